@@ -17,7 +17,7 @@ import uuid
 import sys
 import json
 import subprocess
-from fastapi import FastAPI, UploadFile, File, HTTPException
+from fastapi import FastAPI, UploadFile, File, HTTPException, Body
 from pathlib import Path
 
 # Add the 'analysis' directory to Python's path
@@ -29,6 +29,7 @@ try:
     from analysis import ocr_extract
     from analysis.preprocess import preprocess_text, format_as_dsl
     from analysis.synthesis import generate_enhanced_paper
+    from analysis import qverifier
 except ImportError as e:
     print(f"Error: Could not import required modules: {e}")
     print("Make sure all analysis modules are in the 'analysis' subdirectory.")
@@ -327,6 +328,27 @@ async def get_dashboard_data(job_id: str):
         "dashboard_data": report
     }
 
+# One in-process compiler for the whole server (it keeps its automata warm)
+_compiler = None
+
+@app.post("/compile-dsl/", tags=["Compiler"])
+async def compile_dsl(dsl: str = Body(..., embed=True)):
+    """
+    Compiles DSL text in memory with libqverifier and returns the tokens,
+    the AST (DOT) and the semantic report. No job directory is created.
+    The DSL comes from the client, so no base_dir is given: its
+    SYLLABUS_PATH is never opened and the built-in topics are used.
+    """
+    global _compiler
+    if not qverifier.available():
+        raise HTTPException(status_code=503, detail="libqverifier is not built (run 'make' in compiler/)")
+    if _compiler is None:
+        _compiler = qverifier.Compiler()
+    try:
+        return _compiler.compile(dsl, base_dir=None)
+    except qverifier.QVerifierError as e:
+        raise HTTPException(status_code=400, detail={"error": str(e), "tokens": e.tokens})
+
 @app.get("/", tags=["Health"])
 async def root():
     return {"message": "Smart Exam Compiler API is running."}
@@ -0,0 +1,36 @@
+"""
+Compiler Server Client
+Sends a job to a running 'q_compiler --serve=SOCKET' (see compiler/server.h)
+instead of starting a new compiler process for every upload.
+"""
+
+import os
+import socket
+
+def compile_via_server(socket_path, job_dir, timeout=60):
+    """Compile job_dir on the compiler server.
+    Returns (ok, progress_lines), or None if no server is listening
+    (the caller should then run the compiler executable itself).
+    Raises socket.timeout if the job takes longer than 'timeout' seconds."""
+    if not os.path.exists(socket_path):
+        return None
+    sock = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+    sock.settimeout(timeout)
+    try:
+        sock.connect(socket_path)
+    except (ConnectionRefusedError, FileNotFoundError):
+        sock.close()
+        return None  # Stale socket file: the server is not running
+
+    with sock, sock.makefile('rw', encoding='utf-8', newline='\n') as stream:
+        # The server resolves paths from its own working directory
+        stream.write(f"COMPILE {os.path.abspath(job_dir)}\n")
+        stream.flush()
+        progress = []
+        for line in stream:
+            line = line.rstrip('\n')
+            if line.startswith('DONE '):
+                return line == 'DONE OK', progress
+            if line.startswith('PROGRESS '):
+                progress.append(line[len('PROGRESS '):])
+        return False, progress  # Connection closed before DONE
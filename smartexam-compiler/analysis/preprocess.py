@@ -73,7 +73,8 @@ def format_as_dsl(cleaned_text, syllabus_path_for_compiler):
         cleaned_text (str): The text after running preprocess_text().
         syllabus_path_for_compiler (str): The path where the compiler
                                           will find the syllabus.
-                                          e.g., "jobs/<job_id>/syllabus.txt"
+                                          e.g., "syllabus.txt" (a bare name
+                                          is found in the job directory)
     
     Returns:
         str: The structured input.qp DSL.
@@ -0,0 +1,139 @@
+"""
+Q-Verifier Library Binding
+Compiles DSL text in memory through compiler/libqverifier.so (see
+compiler/qverifier.h), without starting a process or writing job files.
+
+    from analysis.qverifier import Compiler
+    result = Compiler().compile(dsl_text)
+    result['report']        # semantic_report.json as a dict
+
+Build the library with 'make' in compiler/ (or set QVERIFIER_LIB).
+"""
+
+import ctypes
+import json
+import os
+import threading
+
+LIB_PATH = os.environ.get(
+    'QVERIFIER_LIB',
+    os.path.join(os.path.dirname(os.path.dirname(os.path.abspath(__file__))),
+                 'compiler', 'libqverifier.so'))
+API_VERSION = 3
+
+# QvStatus codes
+QV_OK = 0
+QV_ERROR_MEMORY = 1
+QV_ERROR_SYNTAX = 2
+QV_ERROR_PHASE = 3
+
+class QVerifierError(Exception):
+    """A phase failed. 'status' is the QvStatus code, 'tokens' holds the
+    tokens read before a syntax error (if any)."""
+    def __init__(self, message, status, tokens=None):
+        super().__init__(message)
+        self.status = status
+        self.tokens = tokens or []
+
+_lib = None
+_lib_lock = threading.Lock()
+
+def _load():
+    global _lib
+    with _lib_lock:
+        if _lib is not None:
+            return _lib
+        lib = ctypes.CDLL(LIB_PATH)
+        if lib.qv_api_version() != API_VERSION:
+            raise OSError(f"{LIB_PATH} has API version {lib.qv_api_version()}, expected {API_VERSION}")
+
+        vp, sz = ctypes.c_void_p, ctypes.c_size_t
+        lib.qv_compiler_new.restype = vp
+        lib.qv_compiler_free.argtypes = [vp]
+        lib.qv_paper_new.restype = vp
+        lib.qv_paper_new.argtypes = [vp, ctypes.c_char_p, sz, ctypes.c_char_p]
+        lib.qv_paper_free.argtypes = [vp]
+        for name in ('qv_lex', 'qv_parse', 'qv_analyze', 'qv_export_dot', 'qv_compile'):
+            getattr(lib, name).argtypes = [vp]
+            getattr(lib, name).restype = ctypes.c_int
+        for name in ('qv_tokens_json', 'qv_ast_dot', 'qv_ast_json', 'qv_report_json'):
+            # c_void_p, not c_char_p: the text is read with ctypes.string_at
+            getattr(lib, name).argtypes = [vp, ctypes.POINTER(sz)]
+            getattr(lib, name).restype = vp
+        lib.qv_question_count.argtypes = [vp]
+        lib.qv_error.argtypes = [vp]
+        lib.qv_error.restype = ctypes.c_char_p
+        _lib = lib
+        return lib
+
+def available():
+    """True if libqverifier can be loaded."""
+    try:
+        _load()
+        return True
+    except OSError:
+        return False
+
+def _text(lib, getter, paper):
+    length = ctypes.c_size_t(0)
+    ptr = getter(paper, ctypes.byref(length))
+    if not ptr:
+        return None
+    return ctypes.string_at(ptr, length.value).decode('utf-8', errors='replace')
+
+class Compiler:
+    """One per process is enough: it keeps the keyword automata and
+    syllabi warm, and can be used from several threads at once."""
+
+    def __init__(self):
+        self._lib = _load()
+        self._handle = self._lib.qv_compiler_new()
+        if not self._handle:
+            raise MemoryError("qv_compiler_new failed")
+
+    def close(self):
+        if self._handle:
+            self._lib.qv_compiler_free(self._handle)
+            self._handle = None
+
+    def __del__(self):
+        self.close()
+
+    def _run(self, source, base_dir, phase):
+        lib = self._lib
+        data = source.encode('utf-8') if isinstance(source, str) else source
+        base = base_dir.encode('utf-8') if base_dir else None
+        paper = lib.qv_paper_new(self._handle, data, len(data), base)
+        if not paper:
+            raise MemoryError("qv_paper_new failed")
+        try:
+            status = getattr(lib, phase)(paper)
+            tokens = _text(lib, lib.qv_tokens_json, paper)
+            tokens = json.loads(tokens) if tokens else []
+            if status != QV_OK:
+                raise QVerifierError(lib.qv_error(paper).decode('utf-8', errors='replace'),
+                                     status, tokens)
+            report = _text(lib, lib.qv_report_json, paper)
+            ast = _text(lib, lib.qv_ast_json, paper)
+            return {
+                'tokens': tokens,
+                'ast_dot': _text(lib, lib.qv_ast_dot, paper),
+                'ast': json.loads(ast) if ast else None,
+                'report': json.loads(report) if report else None,
+                'question_count': lib.qv_question_count(paper),
+            }
+        finally:
+            lib.qv_paper_free(paper)
+
+    def lex(self, source):
+        """Token list (like tokens.json), even for a paper with syntax errors."""
+        return self._run(source, None, 'qv_lex')['tokens']
+
+    def compile(self, source, base_dir=None):
+        """Runs every phase. Returns a dict with 'tokens', 'ast_dot',
+        'ast' (ast.json), 'report' (semantic_report.json) and
+        'question_count'.
+        SYLLABUS_PATH is read only if it is a bare file name in base_dir;
+        without base_dir the built-in topics are used.
+        Raises QVerifierError if a phase fails."""
+        return self._run(source, base_dir, 'qv_compile')
@@ -0,0 +1,48 @@
+"""
+Token Stream Reader
+Reads the compiler's binary token log (tokens.bin) one page at a time.
+The format is described in compiler/token_stream.h.
+"""
+
+import mmap
+import os
+import struct
+
+HEADER = struct.Struct('<4sHHII')   # magic, version, record_size, count, source_length
+RECORD = struct.Struct('<HHIII')    # kind, reserved, line, offset, length
+MAGIC = b'QTOK'
+VERSION = 1
+
+# Indexed by the TokenKind ids in compiler/token_stream.h
+TOKEN_NAMES = [
+    'T_HEADER_START', 'T_HEADER_END',
+    'T_QUESTION_LIST_START', 'T_QUESTION_LIST_END',
+    'T_QUESTION_START', 'T_QUESTION_END',
+    'T_SUBJECT', 'T_TOTAL_MARKS', 'T_TOTAL_TIME', 'T_SYLLABUS_PATH',
+    'T_Q_TEXT', 'T_Q_MARKS',
+    'T_STRING', 'T_NUMBER', 'T_COLON',
+    'T_ERROR_UNKNOWN',
+]
+
+def read_token_page(job_dir, start=0, count=100):
+    """Return (tokens, total) for tokens[start:start+count] of a job.
+    Only the requested records are read; values are sliced out of input.qp.
+    Each token is a dict shaped like an entry of tokens.json."""
+    bin_path = os.path.join(job_dir, 'tokens.bin')
+    src_path = os.path.join(job_dir, 'input.qp')
+    with open(bin_path, 'rb') as bf, open(src_path, 'rb') as sf:
+        with mmap.mmap(bf.fileno(), 0, access=mmap.ACCESS_READ) as bm:
+            magic, version, record_size, total, source_length = HEADER.unpack_from(bm, 0)
+            if magic != MAGIC or version != VERSION or record_size != RECORD.size:
+                raise ValueError(f'{bin_path} is not a token stream')
+            source = sf.read()
+            if len(source) != source_length:
+                raise ValueError(f'{src_path} changed since {bin_path} was written')
+            tokens = []
+            end = min(total, start + count)
+            for i in range(max(0, start), end):
+                kind, _, line, offset, length = RECORD.unpack_from(bm, HEADER.size + i * RECORD.size)
+                name = TOKEN_NAMES[kind] if kind < len(TOKEN_NAMES) else 'T_INVALID'
+                value = source[offset:offset + length].decode('utf-8', errors='replace')
+                tokens.append({'token': name, 'value': value, 'line': line})
+            return tokens, total
@@ -8,6 +8,8 @@ from flask import Flask, render_template, request, jsonify, send_file, session,
 import os
 import json
 import subprocess
+import socket
+import importlib.util
 from werkzeug.utils import secure_filename
 import uuid
 import graphviz # For rendering the AST .dot file
@@ -17,6 +19,8 @@ from analysis.ocr_extract import extract_text_from_file
 from analysis.preprocess import preprocess_text, format_as_dsl
 from analysis.synthesis import generate_enhanced_paper_with_pdf # <-- ADD THIS LINE
 from analysis.semantic_analysis import perform_semantic_analysis
+from analysis.token_stream import read_token_page
+from analysis.compiler_client import compile_via_server
 
 
 
@@ -28,6 +32,11 @@ app.config['ALLOWED_EXTENSIONS'] = {'pdf', 'png', 'jpg', 'jpeg', 'txt'}
 
 os.makedirs(app.config['JOBS_FOLDER'], exist_ok=True)
 COMPILER_EXECUTABLE = os.path.join(os.getcwd(), 'compiler', 'q_compiler')
+# A running 'q_compiler --serve=...' is used when this socket exists
+COMPILER_SOCKET = os.environ.get('QVERIFIER_SOCKET',
+                                 os.path.join(os.getcwd(), 'compiler', 'q_compiler.sock'))
+COMPILER_STUB = COMPILER_EXECUTABLE + '.py'
+TOKENS_PER_PAGE = 500  # Page size when reading the binary token stream
 
 # Configure Google Cloud Vision API credentials
 # Set the path to your Google Cloud service account key file
@@ -128,7 +137,10 @@ def upload():
         cleaned_text = preprocess_text(raw_text)
 
         print(f"[{job_id}] Running Phase 0: Formatting DSL...")
-        compiler_syllabus_path = os.path.join(job_dir, syllabus_filename)
+        # A bare file name: the compiler looks it up in the job directory, so
+        # re-uploads of a paper give the same input.qp (and reuse its tokens and
+        # AST from the compile cache)
+        compiler_syllabus_path = syllabus_filename
         dsl_content = format_as_dsl(cleaned_text, compiler_syllabus_path)
 
         input_qp_path = os.path.join(job_dir, "input.qp")
@@ -140,13 +152,30 @@ def upload():
     # --- 4. RUN PHASES 1-6 (C/C++ COMPILER) ---
 
         # --- FIX 1: The compiler call is now UN-COMMENTED ---
-        print(f"[{job_id}] Running compiler: {COMPILER_EXECUTABLE}")
-        result = subprocess.run(
-            ["python", COMPILER_EXECUTABLE + ".py", job_dir],
-            capture_output=True, text=True, timeout=60, check=True
-            )
-
-        print(f"[{job_id}] Compiler STDOUT: {result.stdout}")
+        # Prefer the compiler server (keeps its automata warm between jobs),
+        # then the native compiler, then the Python stub
+        try:
+            served = compile_via_server(COMPILER_SOCKET, job_dir, timeout=60)
+        except socket.timeout:
+            raise subprocess.TimeoutExpired(COMPILER_SOCKET, 60)
+        if served is not None:
+            ok, progress = served
+            print(f"[{job_id}] Compiler server: " + "; ".join(progress))
+            if not ok:
+                raise subprocess.CalledProcessError(1, COMPILER_SOCKET, stderr="\n".join(progress))
+        else:
+            if os.path.exists(COMPILER_EXECUTABLE):
+                compiler_cmd = [COMPILER_EXECUTABLE, job_dir]
+            else:
+                compiler_cmd = ["python", COMPILER_EXECUTABLE + ".py", job_dir]
+            print(f"[{job_id}] Running compiler: {compiler_cmd[0]}")
+            result = subprocess.run(
+                compiler_cmd,
+                capture_output=True, text=True, timeout=60, check=True
+                )
+
+            print(f"[{job_id}] Compiler STDOUT: {result.stdout}")
+        run_stub_back_end(job_id, job_dir)
         # ---------------------------------------------------
 
         # --- 5. ENHANCE SEMANTIC REPORT WITH ANALYSIS ---
@@ -156,17 +185,21 @@ def upload():
             with open(semantic_report_path, 'r', encoding='utf-8') as f:
                 semantic_data = json.load(f)
 
-            # Perform semantic analysis using the extracted text
-            enhanced_report = perform_semantic_analysis(semantic_data, cleaned_text)
+            # The native compiler already writes the full report (with 'checks')
+            if 'checks' in semantic_data:
+                print(f"[{job_id}] Semantic report written by the compiler.")
+            else:
+                # Perform semantic analysis using the extracted text
+                enhanced_report = perform_semantic_analysis(semantic_data, cleaned_text)
 
-            # Merge with existing semantic data
-            semantic_data.update(enhanced_report)
+                # Merge with existing semantic data
+                semantic_data.update(enhanced_report)
 
-            # Save enhanced report
-            with open(semantic_report_path, 'w', encoding='utf-8') as f:
-                json.dump(semantic_data, f, indent=2)
+                # Save enhanced report
+                with open(semantic_report_path, 'w', encoding='utf-8') as f:
+                    json.dump(semantic_data, f, indent=2)
 
-            print(f"[{job_id}] Semantic report enhanced successfully.")
+                print(f"[{job_id}] Semantic report enhanced successfully.")
         except Exception as e:
             print(f"[{job_id}] Warning: Could not enhance semantic report: {e}")
         # ---------------------------------------------------
@@ -191,6 +224,36 @@ def upload():
 
 # ... (rest of the app.py code remains the same) ...
 
+def run_stub_back_end(job_id, job_dir):
+    """Writes the Phase 4-6 outputs the compiler didn't, with the Python stub.
+    Parameters:
+        - job_id (str): The job, for the log lines.
+        - job_dir (str): The job directory; semantic_report.json must exist.
+    Returns:
+        - None. optimization_log.json is written if it is missing, and the
+          .tex files (and their PDFs if pdflatex is installed) if
+          EnhancedPaper.tex is missing, so /optimization and the downloads
+          keep working with a compiler binary that stops after Phase 3.
+    """
+    def missing(name):
+        return not os.path.exists(os.path.join(job_dir, name))
+
+    need_log = missing('optimization_log.json')
+    need_tex = missing('EnhancedPaper.tex')
+    if not need_log and not need_tex:
+        return
+    spec = importlib.util.spec_from_file_location('q_compiler_stub', COMPILER_STUB)
+    stub = importlib.util.module_from_spec(spec)
+    spec.loader.exec_module(stub)
+    with open(os.path.join(job_dir, 'semantic_report.json'), 'r', encoding='utf-8') as f:
+        semantic = json.load(f)
+    if need_log:
+        stub.phase45_opt(job_dir, semantic)
+    if need_tex:
+        stub.phase6_tex_and_pdf(job_dir, semantic)
+    print(f"[{job_id}] Phases 4-6 not run by the compiler; written by the stub.")
+
+
 # --- Helper to get job directory and check for errors ---
 def get_job_dir():
     if 'job_id' not in session:
@@ -341,11 +404,39 @@ def dashboard():
                            ast=ast_svg)
 
 
+def load_ast_page(job_dir, page):
+    """Return ast.json with 'page' expanded. Long papers are paged (see
+    compiler/ast_export.h); other pages are exported on demand to their
+    own ast.page<N>.json, so viewers of different pages never touch the
+    ast.json and ast.dot the dashboard reads."""
+    ast_json_path = os.path.join(job_dir, 'ast.json')
+    with open(ast_json_path, 'r', encoding='utf-8') as f:
+        ast = json.load(f)
+    if page == ast.get('page', 0) or not 0 <= page < ast.get('page_count', 1) \
+            or not os.path.exists(COMPILER_EXECUTABLE):
+        return ast
+
+    # Reused until the job is compiled again (which rewrites ast.json)
+    page_path = os.path.join(job_dir, f'ast.page{page}.json')
+    if not os.path.exists(page_path) or \
+            os.path.getmtime(page_path) < os.path.getmtime(ast_json_path):
+        subprocess.run([COMPILER_EXECUTABLE, '--export-ast', f'--ast-page={page}', job_dir],
+                       capture_output=True, timeout=30, check=True)
+    with open(page_path, 'r', encoding='utf-8') as f:
+        return json.load(f)
+
 @app.route('/tree')
 def tree():
     job_dir, error_response = get_job_dir()
     if error_response: return error_response
 
+    # The JSON AST is drawn in the browser (d3); the DOT file is the
+    # fallback for jobs compiled before ast.json existed
+    try:
+        return render_template('tree.html', ast=load_ast_page(job_dir, request.args.get('page', 0, type=int)))
+    except Exception as e:
+        print(f"Could not load ast.json, falling back to ast.dot: {e}")
+
     ast_dot_path = os.path.join(job_dir, 'ast.dot')
     ast_svg = ""
     try:
@@ -378,8 +469,14 @@ def lexical():
     tokens_path = os.path.join(job_dir, 'tokens.json')
     tokens_data = [] # Default to empty list
     try:
-        with open(tokens_path, 'r', encoding='utf-8') as f:
-            tokens_data = json.load(f)
+        if not os.path.exists(tokens_path) and os.path.exists(os.path.join(job_dir, 'tokens.bin')):
+            # Binary token stream only: read just the requested page
+            page = max(0, request.args.get('page', 0, type=int))
+            per_page = max(1, request.args.get('per_page', TOKENS_PER_PAGE, type=int))
+            tokens_data, _ = read_token_page(job_dir, page * per_page, per_page)
+        else:
+            with open(tokens_path, 'r', encoding='utf-8') as f:
+                tokens_data = json.load(f)
     except Exception:
         # This is now expected, as the compiler hasn't run
         tokens_data = [{"token": "---", "value": "Compiler has not run yet", "line": 0}]
@@ -465,6 +562,14 @@ def download_pdf_report():
 
 @app.route('/download/tokens')
 def download_tokens():
+    # With --tokens=bin the compiler only writes tokens.bin;
+    # build tokens.json from it the first time someone asks for it
+    job_dir, error_response = get_job_dir()
+    if error_response: return error_response
+    if not os.path.exists(os.path.join(job_dir, 'tokens.json')) and \
+            os.path.exists(os.path.join(job_dir, 'tokens.bin')):
+        subprocess.run([COMPILER_EXECUTABLE, '--export-tokens', job_dir],
+                       capture_output=True, timeout=60)
     return send_job_file('tokens.json', 'tokens.json')
 
 @app.route('/download/ast')
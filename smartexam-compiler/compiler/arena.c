@@ -0,0 +1,93 @@
+/*
+ * compiler/arena.c
+ * Implementation of the bump allocator.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "arena.h"
+
+#define ARENA_ALIGN 16
+
+static size_t align_up(size_t n) {
+    return (n + (ARENA_ALIGN - 1)) & ~(size_t)(ARENA_ALIGN - 1);
+}
+
+// Adds a block with room for at least 'min_size' bytes
+static ArenaBlock* add_block(Arena* arena, size_t min_size) {
+    size_t size = arena->next_block_size;
+    if (size < min_size) size = min_size;
+
+    ArenaBlock* block = (ArenaBlock*)malloc(sizeof(ArenaBlock) + size);
+    if (block == NULL) return NULL;
+    block->size = size;
+    block->used = 0;
+    block->next = arena->head;
+    arena->head = block;
+
+    if (arena->next_block_size < ARENA_MAX_BLOCK_SIZE) {
+        arena->next_block_size *= 2;
+    }
+    return block;
+}
+
+/* --- Arena Functions --- */
+
+void arena_init(Arena* arena) {
+    arena->head = NULL;
+    arena->next_block_size = ARENA_FIRST_BLOCK_SIZE;
+    arena->bytes_allocated = 0;
+}
+
+void* arena_alloc(Arena* arena, size_t size) {
+    size = align_up(size);
+
+    ArenaBlock* block = arena->head;
+    if (block == NULL || block->size - block->used < size) {
+        block = add_block(arena, size);
+        if (block == NULL) return NULL;
+    }
+
+    void* p = block->data + block->used;
+    block->used += size;
+    arena->bytes_allocated += size;
+    return p;
+}
+
+char* arena_strndup(Arena* arena, const char* s, size_t len) {
+    char* copy = (char*)arena_alloc(arena, len + 1);
+    if (copy == NULL) return NULL;
+    memcpy(copy, s, len);
+    copy[len] = '\0';
+    return copy;
+}
+
+char* arena_strdup(Arena* arena, const char* s) {
+    return arena_strndup(arena, s, strlen(s));
+}
+
+void arena_adopt(Arena* arena, Arena* other) {
+    if (other->head == NULL) return;
+    ArenaBlock* tail = other->head;
+    while (tail->next != NULL) tail = tail->next;
+    if (arena->head == NULL) {
+        arena->head = other->head;
+        tail->next = NULL;
+    } else {
+        // Behind our current block, which keeps its free space
+        tail->next = arena->head->next;
+        arena->head->next = other->head;
+    }
+    arena->bytes_allocated += other->bytes_allocated;
+    arena_init(other);
+}
+
+void arena_free(Arena* arena) {
+    ArenaBlock* block = arena->head;
+    while (block != NULL) {
+        ArenaBlock* next = block->next;
+        free(block);
+        block = next;
+    }
+    arena_init(arena);
+}
@@ -0,0 +1,52 @@
+/*
+ * compiler/arena.h
+ * A simple bump ("arena") allocator.
+ *
+ * Each job owns one Arena. Every AST node (and any string we need to
+ * build) is carved out of it, so building the AST costs a few large
+ * malloc()s instead of one per node, and tearing the AST down is a single
+ * arena_free() that releases a handful of blocks.
+ */
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+#define ARENA_FIRST_BLOCK_SIZE (64 * 1024)
+#define ARENA_MAX_BLOCK_SIZE   (16 * 1024 * 1024)
+
+typedef struct ArenaBlock {
+    struct ArenaBlock* next; // Older blocks
+    size_t size;             // Usable bytes in 'data'
+    size_t used;
+    _Alignas(16) char data[]; // Keeps every allocation 16-byte aligned
+} ArenaBlock;
+
+typedef struct Arena {
+    ArenaBlock* head;        // Block we are currently allocating from
+    size_t next_block_size;  // Blocks double in size up to ARENA_MAX_BLOCK_SIZE
+    size_t bytes_allocated;  // Total handed out (for stats)
+} Arena;
+
+/* --- Arena Functions --- */
+
+void arena_init(Arena* arena);
+
+// Returns 'size' bytes aligned for any type, or NULL if out of memory.
+// Memory is not zeroed.
+void* arena_alloc(Arena* arena, size_t size);
+
+// Copies 'len' bytes of 's' into the arena and adds a NUL
+char* arena_strndup(Arena* arena, const char* s, size_t len);
+char* arena_strdup(Arena* arena, const char* s);
+
+// Moves every block of 'other' into 'arena' (e.g. the arena a worker
+// thread built nodes in), so they are freed together. 'other' is left
+// empty.
+void arena_adopt(Arena* arena, Arena* other);
+
+// Releases every block at once. The arena can be reused afterwards.
+void arena_free(Arena* arena);
+
+#endif // ARENA_H
@@ -1,33 +1,79 @@
-/*
- * compiler/ast.h
- * Defines the core Abstract Syntax Tree (AST) structures.
- */
-
-#ifndef AST_H
-#define AST_H
-
-// As specified in the RFD
-typedef struct QuestionNode {
-    char* text;
-    int marks;
-    
-    // --- Phase 3 Annotations (will be filled in later) ---
-    char* difficulty;     // "Easy", "Medium", "Hard"
-    int estimated_time;   // in minutes
-    char* syllabus_topic; // "Trees", "Sorting", "N/A"
-    int status_flag;      // 0=OK, 1=DUPLICATE, 2=OUT_OF_SYLLABUS
-    char* blooms_level;   // "Remembering", "Analyzing", etc. (From LLM Ideation)
-    
-    struct QuestionNode* next; // for linked list
-} QuestionNode;
-
-typedef struct ASTNode {
-    char* subject;
-    int total_marks;
-    int total_time;
-    char* syllabus_path;
-    
-    QuestionNode* questions; // Head of the question list
-} ASTNode;
-
+/*
+ * compiler/ast.h
+ * Defines the core Abstract Syntax Tree (AST) structures.
+ */
+
+#ifndef AST_H
+#define AST_H
+
+#include <stdint.h>
+#include "arena.h"
+#include "topics.h"
+
+/* --- Phase 3 Annotation Codes --- */
+// Small integer codes instead of strings: nodes stay compact and the
+// semantic passes compare and count them with plain integer operations.
+// difficulty_name() etc. in ast_helpers.h give the report strings.
+
+typedef enum Difficulty {
+    DIFFICULTY_UNKNOWN = 0, // "N/A" (not classified yet)
+    DIFFICULTY_EASY,
+    DIFFICULTY_MEDIUM,
+    DIFFICULTY_HARD,
+    DIFFICULTY_COUNT
+} Difficulty;
+
+typedef enum BloomsLevel {
+    BLOOMS_UNKNOWN = 0,     // "N/A"
+    BLOOMS_REMEMBERING,
+    BLOOMS_UNDERSTANDING,
+    BLOOMS_APPLYING,
+    BLOOMS_ANALYZING,
+    BLOOMS_EVALUATING,
+    BLOOMS_CREATING,
+    BLOOMS_COUNT
+} BloomsLevel;
+
+typedef enum StatusFlag {
+    STATUS_OK = 0,
+    STATUS_DUPLICATE = 1,
+    STATUS_OUT_OF_SYLLABUS = 2
+} StatusFlag;
+
+// As specified in the RFD
+typedef struct QuestionNode {
+    const char* text;     // Points into the input.qp SourceBuffer
+    int marks;
+    
+    // --- Phase 3 Annotations (will be filled in later) ---
+    int estimated_time;      // in minutes
+    uint16_t syllabus_topic; // Topic id in ASTNode.topics (TOPIC_NONE = "N/A")
+    uint8_t difficulty;      // A Difficulty
+    uint8_t status_flag;     // A StatusFlag: 0=OK, 1=DUPLICATE, 2=OUT_OF_SYLLABUS
+    uint8_t blooms_level;    // A BloomsLevel (From LLM Ideation)
+    
+    struct QuestionNode* next; // for linked list
+} QuestionNode;
+
+// The question list while it is being built: keeping the tail and the
+// count makes every append O(1), so parsing N questions is linear.
+typedef struct QuestionList {
+    QuestionNode* head;
+    QuestionNode* tail;
+    int count;
+} QuestionList;
+
+typedef struct ASTNode {
+    const char* subject;       // Points into the input.qp SourceBuffer
+    int total_marks;
+    int total_time;
+    const char* syllabus_path; // Points into the input.qp SourceBuffer
+    
+    QuestionNode* questions; // Head of the question list
+    int question_count;      // Length of the question list
+
+    TopicTable topics;       // Names behind QuestionNode.syllabus_topic
+    Arena* arena;            // Owns this node and every QuestionNode in it
+} ASTNode;
+
 #endif // AST_H
\ No newline at end of file
@@ -0,0 +1,345 @@
+/*
+ * compiler/ast_export.c
+ * Buffered DOT + JSON export of the AST (see ast_export.h).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "ast_export.h"
+#include "source.h"
+
+#define EXPORT_BUFFER_SIZE (64 * 1024)
+#define LABEL_MAX_BYTES (AST_LABEL_LENGTH * 4 + 4) // UTF-8 + "..."
+
+static const char hex_digits[] = "0123456789abcdef";
+
+/* --- Output Buffer --- */
+// Like TokenWriter: text is collected in one big buffer and handed to
+// stdio in large blocks, instead of one fprintf() per line.
+
+typedef struct OutBuf {
+    FILE* out;       // NULL: this format isn't wanted; everything is dropped
+    char* data;      // EXPORT_BUFFER_SIZE bytes
+    size_t len;
+    int failed;
+} OutBuf;
+
+static void out_flush(OutBuf* b) {
+    if (b->out != NULL && b->len > 0 && fwrite(b->data, 1, b->len, b->out) != b->len) {
+        b->failed = 1;
+    }
+    b->len = 0;
+}
+
+static void out_append(OutBuf* b, const char* s, size_t n) {
+    if (b->out == NULL) return;
+    while (n > 0) {
+        if (b->len == EXPORT_BUFFER_SIZE) out_flush(b);
+        size_t chunk = EXPORT_BUFFER_SIZE - b->len;
+        if (chunk > n) chunk = n;
+        memcpy(b->data + b->len, s, chunk);
+        b->len += chunk;
+        s += chunk;
+        n -= chunk;
+    }
+}
+
+static void out_str(OutBuf* b, const char* s) {
+    out_append(b, s, strlen(s));
+}
+
+static void out_int(OutBuf* b, long value) {
+    char digits[24];
+    int n = snprintf(digits, sizeof(digits), "%ld", value);
+    out_append(b, digits, (size_t)n);
+}
+
+// A JSON string, quotes included. Bytes >= 0x80 are copied unchanged.
+static void out_json_string(OutBuf* b, const char* s, size_t len) {
+    out_append(b, "\"", 1);
+    const unsigned char* p = (const unsigned char*)s;
+    const unsigned char* end = p + len;
+    while (p < end) {
+        const unsigned char* run = p;
+        while (p < end && *p >= 0x20 && *p != '"' && *p != '\\') p++;
+        out_append(b, (const char*)run, (size_t)(p - run));
+        if (p == end) break;
+
+        char esc[6] = { '\\', (char)*p, 0, 0, 0, 0 };
+        size_t esc_len = 2;
+        if (*p < 0x20) {
+            esc[1] = 'u';
+            esc[2] = '0';
+            esc[3] = '0';
+            esc[4] = hex_digits[*p >> 4];
+            esc[5] = hex_digits[*p & 0xF];
+            esc_len = 6;
+        }
+        out_append(b, esc, esc_len);
+        p++;
+    }
+    out_append(b, "\"", 1);
+}
+
+// Text inside a DOT "..." label: quotes and backslashes are escaped
+// (a lone backslash would start a DOT escape like \n or \l)
+static void out_dot_text(OutBuf* b, const char* s, size_t len) {
+    const char* end = s + len;
+    while (s < end) {
+        const char* run = s;
+        while (s < end && *s != '"' && *s != '\\') s++;
+        out_append(b, run, (size_t)(s - run));
+        if (s == end) break;
+        out_append(b, "\\", 1);
+        out_append(b, s, 1);
+        s++;
+    }
+}
+
+/* --- Labels --- */
+
+// Copies 'text' into 'label' (LABEL_MAX_BYTES) with each run of
+// whitespace or control characters, including the two-character "\n"
+// that OCR leaves in question texts, turned into one space. Stops after AST_LABEL_LENGTH
+// characters: a character is a UTF-8 lead byte plus its continuation
+// bytes, so the cut never splits one. Returns the label length.
+static size_t make_label(const char* text, char* label) {
+    const unsigned char* p = (const unsigned char*)(text != NULL ? text : "");
+    size_t len = 0;
+    int chars = 0;
+    int pending_space = 0;
+
+    while (*p != '\0') {
+        if (*p <= ' ') { // Whitespace and other control characters
+            pending_space = len > 0;
+            p++;
+            continue;
+        }
+        if (p[0] == '\\' && p[1] == 'n') {
+            pending_space = len > 0;
+            p += 2;
+            continue;
+        }
+        int lead = (*p & 0xC0) != 0x80;
+        if (lead) {
+            // Room for this character (up to 4 bytes), a space and "..."?
+            if (chars + pending_space >= AST_LABEL_LENGTH || len + 8 > LABEL_MAX_BYTES) {
+                memcpy(label + len, "...", 3);
+                return len + 3;
+            }
+            if (pending_space) {
+                label[len++] = ' ';
+                chars++;
+                pending_space = 0;
+            }
+            chars++;
+        } else if (len + 4 > LABEL_MAX_BYTES) {
+            // Stray continuation bytes: not a character, but bounded too
+            memcpy(label + len, "...", 3);
+            return len + 3;
+        }
+        label[len++] = (char)*p++;
+    }
+    return len;
+}
+
+/* --- Nodes --- */
+
+static void write_root(OutBuf* dot, OutBuf* json, const ASTNode* root,
+                       int page, int page_count, int page_size) {
+    char subject[LABEL_MAX_BYTES];
+    size_t subject_len = make_label(root->subject, subject);
+
+    out_str(dot, "digraph AST {\n");
+    out_str(dot, "  node [shape=box, style=\"filled\", fillcolor=\"lightblue\"];\n");
+    out_str(dot, "  root [label=\"Q-Verifier AST\\nSubject: ");
+    out_dot_text(dot, subject, subject_len);
+    out_str(dot, "\\nMarks: ");
+    out_int(dot, root->total_marks);
+    out_str(dot, "\\nTime: ");
+    out_int(dot, root->total_time);
+    out_str(dot, " min\"];\n");
+
+    out_str(json, "{\"name\": \"Q-Verifier AST\", \"type\": \"paper\", \"subject\": ");
+    out_json_string(json, subject, subject_len);
+    out_str(json, ", \"total_marks\": ");
+    out_int(json, root->total_marks);
+    out_str(json, ", \"total_time\": ");
+    out_int(json, root->total_time);
+    out_str(json, ", \"question_count\": ");
+    out_int(json, root->question_count);
+    out_str(json, ", \"page\": ");
+    out_int(json, page);
+    out_str(json, ", \"page_count\": ");
+    out_int(json, page_count);
+    out_str(json, ", \"page_size\": ");
+    out_int(json, page_size);
+    out_str(json, ", \"children\": [");
+}
+
+static void write_question(OutBuf* dot, OutBuf* json, const QuestionNode* q, int index) {
+    char label[LABEL_MAX_BYTES];
+    size_t label_len = make_label(q->text, label);
+
+    out_str(dot, "  q");
+    out_int(dot, index);
+    out_str(dot, " [label=\"Q_TEXT: ");
+    out_dot_text(dot, label, label_len);
+    out_str(dot, "\\nQ_MARKS: ");
+    out_int(dot, q->marks);
+    out_str(dot, "\"];\n  root -> q");
+    out_int(dot, index);
+    out_str(dot, ";\n");
+
+    // The d3 tree shows "name"; "Q12: text..." reads well there
+    char name[LABEL_MAX_BYTES + 16];
+    int prefix = snprintf(name, sizeof(name), "Q%d: ", index + 1);
+    memcpy(name + prefix, label, label_len);
+    out_str(json, index > 0 ? ",\n" : "\n");
+    out_str(json, "{\"name\": ");
+    out_json_string(json, name, (size_t)prefix + label_len);
+    out_str(json, ", \"type\": \"question\", \"number\": ");
+    out_int(json, index + 1);
+    out_str(json, ", \"marks\": ");
+    out_int(json, q->marks);
+    out_str(json, "}");
+}
+
+// One node standing for questions first..last (0-based, inclusive)
+static void write_group(OutBuf* dot, OutBuf* json, int page, int first, int last, long marks) {
+    char name[48];
+    snprintf(name, sizeof(name), "Q%d-Q%d", first + 1, last + 1);
+
+    out_str(dot, "  g");
+    out_int(dot, page);
+    out_str(dot, " [label=\"");
+    out_str(dot, name);
+    out_str(dot, "\\n");
+    out_int(dot, last - first + 1);
+    out_str(dot, " questions, ");
+    out_int(dot, marks);
+    out_str(dot, " marks\", fillcolor=\"lightgrey\"];\n  root -> g");
+    out_int(dot, page);
+    out_str(dot, ";\n");
+
+    out_str(json, first > 0 ? ",\n" : "\n");
+    out_str(json, "{\"name\": ");
+    out_json_string(json, name, strlen(name));
+    out_str(json, ", \"type\": \"group\", \"page\": ");
+    out_int(json, page);
+    out_str(json, ", \"first\": ");
+    out_int(json, first + 1);
+    out_str(json, ", \"last\": ");
+    out_int(json, last + 1);
+    out_str(json, ", \"marks\": ");
+    out_int(json, marks);
+    out_str(json, "}");
+}
+
+/* --- AST Export Functions --- */
+
+int export_ast(const ASTNode* root, FILE* dot_file, FILE* json_file, const AstExportOptions* options) {
+    OutBuf dot = { dot_file, NULL, 0, 0 };
+    OutBuf json = { json_file, NULL, 0, 0 };
+    if (dot_file != NULL) dot.data = (char*)malloc(EXPORT_BUFFER_SIZE);
+    if (json_file != NULL) json.data = (char*)malloc(EXPORT_BUFFER_SIZE);
+    if ((dot_file != NULL && dot.data == NULL) || (json_file != NULL && json.data == NULL)) {
+        free(dot.data);
+        free(json.data);
+        return -1;
+    }
+
+    int page_size = options != NULL && options->page_size > 0 ? options->page_size : AST_PAGE_SIZE;
+    int count = root->question_count;
+    int page_count = count > page_size ? (count + page_size - 1) / page_size : 1;
+    int page = options != NULL ? options->page : 0;
+    if (page < 0) page = 0;
+    if (page >= page_count) page = page_count - 1;
+
+    write_root(&dot, &json, root, page, page_count, page_size);
+
+    // Single pass: questions on the expanded page get a node each, the
+    // others are summed up until their page ends
+    long group_marks = 0;
+    int i = 0;
+    for (const QuestionNode* q = root->questions; q != NULL; q = q->next, i++) {
+        int q_page = i / page_size;
+        if (page_count == 1 || q_page == page) {
+            write_question(&dot, &json, q, i);
+            continue;
+        }
+        group_marks += q->marks;
+        if (i % page_size == page_size - 1 || q->next == NULL) {
+            write_group(&dot, &json, q_page, q_page * page_size, i, group_marks);
+            group_marks = 0;
+        }
+    }
+
+    out_str(&dot, "}\n");
+    out_str(&json, "\n]}\n");
+    out_flush(&dot);
+    out_flush(&json);
+    free(dot.data);
+    free(json.data);
+    return dot.failed || json.failed ? -1 : 0;
+}
+
+int export_ast_page_file(const ASTNode* root, const char* job_dir, const AstExportOptions* options) {
+    char path[PATH_MAX], tmp_path[PATH_MAX];
+    int n = snprintf(path, sizeof(path), "%s/ast.page%d.json", job_dir, options->page);
+    int m = snprintf(tmp_path, sizeof(tmp_path), "%s.tmp.XXXXXX", path);
+    if (n < 0 || (size_t)n >= sizeof(path) || m < 0 || (size_t)m >= sizeof(tmp_path)) {
+        fprintf(stderr, "Path too long: %s\n", job_dir);
+        return -1;
+    }
+
+    // A unique temporary name: two viewers may ask for the same page
+    int fd = mkstemp(tmp_path);
+    FILE* json = fd >= 0 ? fdopen(fd, "w") : NULL;
+    if (json == NULL) {
+        perror(tmp_path);
+        if (fd >= 0) {
+            close(fd);
+            unlink(tmp_path);
+        }
+        return -1;
+    }
+    fchmod(fd, 0644); // mkstemp() makes it 0600
+    int result = export_ast(root, NULL, json, options);
+    if (fclose(json) != 0) result = -1;
+    if (result == 0 && rename(tmp_path, path) != 0) {
+        perror(path);
+        result = -1;
+    }
+    if (result != 0) unlink(tmp_path);
+    return result;
+}
+
+int export_ast_files(const ASTNode* root, const char* job_dir, const AstExportOptions* options) {
+    char dot_path[PATH_MAX], json_path[PATH_MAX];
+    if (source_path(dot_path, sizeof(dot_path), job_dir, "ast.dot") != 0 ||
+        source_path(json_path, sizeof(json_path), job_dir, "ast.json") != 0) {
+        return -1;
+    }
+
+    // Replaced rather than truncated: they may be links into the compile cache
+    unlink(dot_path);
+    unlink(json_path);
+    FILE* dot = fopen(dot_path, "w");
+    if (dot == NULL) {
+        perror("Failed to open ast.dot");
+        return -1;
+    }
+    FILE* json = fopen(json_path, "w");
+    if (json == NULL) {
+        perror("Failed to open ast.json"); // ast.dot alone is still useful
+    }
+    int result = export_ast(root, dot, json, options);
+    if (fclose(dot) != 0) result = -1;
+    if (json != NULL && fclose(json) != 0) result = -1;
+    return json != NULL ? result : -1;
+}
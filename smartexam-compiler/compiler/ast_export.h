@@ -0,0 +1,47 @@
+/*
+ * compiler/ast_export.h
+ * Phase 2 web output: the AST as Graphviz DOT (ast.dot) and as JSON
+ * (ast.json, the {name, type, children} tree that templates/tree.html
+ * draws with d3).
+ *
+ * Both files are written in one walk over the question list through
+ * large output buffers. Question labels are shortened to
+ * AST_LABEL_LENGTH characters without cutting a UTF-8 sequence in half.
+ *
+ * Big papers are paged: when there are more than 'page_size' questions,
+ * only the questions of one page get their own node and every other page
+ * is collapsed into a single "Q101-Q200" group node. That keeps the graph
+ * small enough for Graphviz and the browser no matter how long the paper is.
+ */
+
+#ifndef AST_EXPORT_H
+#define AST_EXPORT_H
+
+#include <stdio.h>
+#include "ast.h"
+
+#define AST_LABEL_LENGTH 40  // Characters of question text in a label
+#define AST_PAGE_SIZE 100    // Default questions per page
+
+typedef struct AstExportOptions {
+    int page_size;           // Questions per page (<= 0: AST_PAGE_SIZE)
+    int page;                // Which page to expand (0-based)
+} AstExportOptions;
+
+/* --- AST Export Functions --- */
+
+// Writes the DOT and/or JSON form of 'root' ('dot' or 'json' may be NULL).
+// 'options' may be NULL for the defaults. Streams are not closed.
+// Returns 0 on success, -1 if a write failed.
+int export_ast(const ASTNode* root, FILE* dot, FILE* json, const AstExportOptions* options);
+
+// Same, creating job_dir/ast.dot and job_dir/ast.json
+int export_ast_files(const ASTNode* root, const char* job_dir, const AstExportOptions* options);
+
+// Writes only the JSON with options->page expanded, to
+// job_dir/ast.page<N>.json. The file is written under a temporary name
+// and renamed, so readers never see half of it, and ast.dot/ast.json
+// (which the dashboard shows) are left alone.
+int export_ast_page_file(const ASTNode* root, const char* job_dir, const AstExportOptions* options);
+
+#endif // AST_EXPORT_H
@@ -1,108 +1,102 @@
-/*
- * compiler/ast_helpers.c
- * Implementation of AST helper functions.
- * This is where all the 'malloc' logic lives.
- */
-
-#include <stdio.h>
-#include <stdlib.h>
-#include <string.h>
-#include "ast_helpers.h"
-
-/* --- AST Creation Functions --- */
-
-ASTNode* create_ast_node(char* subject, int marks, int time, char* syllabus_path, QuestionNode* questions) {
-    ASTNode* node = (ASTNode*)malloc(sizeof(ASTNode));
-    node->subject = strdup(subject);
-    node->total_marks = marks;
-    node->total_time = time;
-    node->syllabus_path = strdup(syllabus_path);
-    node->questions = questions;
-    
-    // Free the strings from the parser, as strdup made copies
-    free(subject);
-    free(syllabus_path);
-    
-    return node;
-}
-
-QuestionNode* create_question_node(char* text, int marks) {
-    QuestionNode* node = (QuestionNode*)malloc(sizeof(QuestionNode));
-    node->text = strdup(text);
-    node->marks = marks;
-    
-    // --- Initialize all Phase 3 fields to NULL/0 ---
-    node->difficulty = strdup("N/A");
-    node->estimated_time = 0;
-    node->syllabus_topic = strdup("N/A");
-    node->status_flag = 0; // 0 = OK
-    node->blooms_level = strdup("N/A");
-    node->next = NULL;
-    
-    // Free the string from the parser
-    free(text);
-    
-    return node;
-}
-
-QuestionNode* append_question(QuestionNode* list_head, QuestionNode* new_question) {
-    if (list_head == NULL) {
-        return new_question; // This is the first question in the list
-    }
-    
-    // Find the end of the list and append
-    QuestionNode* current = list_head;
-    while (current->next != NULL) {
-        current = current->next;
-    }
-    current->next = new_question;
-    
-    return list_head; // Return the head of the list
-}
-
-/* Stub for recursive AST freeing */
-void free_ast(ASTNode* root) {
-    if (root == NULL) return;
-    // TODO: Free all strings and question nodes
-    free(root);
-}
-
-
-/* --- Web Output Functions --- */
-
-// Phase 2: Generates the ast.dot file
-void export_ast_to_dot(ASTNode* root, const char* filepath) {
-    printf("AST Helper: Exporting AST to %s\n", filepath);
-    FILE* f = fopen(filepath, "w");
-    if (f == NULL) {
-        perror("Failed to open ast.dot");
-        return;
-    }
-
-    fprintf(f, "digraph AST {\n");
-    fprintf(f, "  node [shape=box, style=\"filled\", fillcolor=\"lightblue\"];\n");
-    
-    // Root node
-    fprintf(f, "  root [label=\"Q-Verifier AST\\nSubject: %s\\nMarks: %d\\nTime: %d min\"];\n",
-            root->subject, root->total_marks, root->total_time);
-
-    // Question nodes
-    QuestionNode* q = root->questions;
-    int i = 0;
-    while (q != NULL) {
-        // Create a unique ID for each question node
-        fprintf(f, "  q%d [label=\"Q_TEXT: %s...\\nQ_MARKS: %d\"];\n", 
-                i, 
-                "TODO: Substring", // Need a helper to show just first 20 chars
-                q->marks);
-        
-        // Link root to question
-        fprintf(f, "  root -> q%d;\n", i);
-        
-        q = q->next;
-        i++;
-    }
-    
-    fprintf(f, "}\n");
-    fclose(f);
+/*
+ * compiler/ast_helpers.c
+ * Implementation of AST helper functions.
+ * This is where all the allocation logic lives (all of it from the
+ * job's Arena, see arena.h).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ast_helpers.h"
+
+/* --- AST Creation Functions --- */
+
+ASTNode* create_ast_node(Arena* arena, const char* subject, int marks, int time, const char* syllabus_path, QuestionNode* questions) {
+    ASTNode* node = (ASTNode*)arena_alloc(arena, sizeof(ASTNode));
+    if (node == NULL) return NULL;
+    node->subject = subject;             // No copy: the source buffer outlives the AST
+    node->total_marks = marks;
+    node->total_time = time;
+    node->syllabus_path = syllabus_path;
+    node->questions = questions;
+    node->question_count = 0;
+    node->arena = arena;
+    topic_table_init(&node->topics, arena);
+    
+    return node;
+}
+
+QuestionNode* create_question_node(Arena* arena, const char* text, int marks) {
+    QuestionNode* node = (QuestionNode*)arena_alloc(arena, sizeof(QuestionNode));
+    if (node == NULL) return NULL;
+    node->text = text; // No copy: the source buffer outlives the AST
+    node->marks = marks;
+    
+    // --- Initialize all Phase 3 fields to "N/A"/0 ---
+    node->difficulty = DIFFICULTY_UNKNOWN;
+    node->estimated_time = 0;
+    node->syllabus_topic = TOPIC_NONE;
+    node->status_flag = STATUS_OK;
+    node->blooms_level = BLOOMS_UNKNOWN;
+    node->next = NULL;
+    
+    return node;
+}
+
+void init_question_list(QuestionList* list) {
+    list->head = NULL;
+    list->tail = NULL;
+    list->count = 0;
+}
+
+void append_question(QuestionList* list, QuestionNode* new_question) {
+    new_question->next = NULL;
+    if (list->tail == NULL) {
+        list->head = new_question; // This is the first question in the list
+    } else {
+        list->tail->next = new_question; // No walk: we know where the end is
+    }
+    list->tail = new_question;
+    list->count++;
+}
+
+/*
+ * Frees the AST. Every node came from root->arena, so there is nothing
+ * to walk: releasing the arena's blocks frees all of it at once.
+ */
+void free_ast(ASTNode* root) {
+    if (root == NULL) return;
+    arena_free(root->arena);
+}
+
+
+/* --- Annotation Names --- */
+
+static const char* difficulty_names[DIFFICULTY_COUNT] = {
+    "N/A", "Easy", "Medium", "Hard"
+};
+
+static const char* blooms_level_names[BLOOMS_COUNT] = {
+    "N/A", "Remembering", "Understanding", "Applying",
+    "Analyzing", "Evaluating", "Creating"
+};
+
+const char* difficulty_name(int difficulty) {
+    if (difficulty < 0 || difficulty >= DIFFICULTY_COUNT) return "N/A";
+    return difficulty_names[difficulty];
+}
+
+const char* blooms_level_name(int level) {
+    if (level < 0 || level >= BLOOMS_COUNT) return "N/A";
+    return blooms_level_names[level];
+}
+
+const char* status_flag_name(int status_flag) {
+    switch (status_flag) {
+        case STATUS_OK:              return "OK";
+        case STATUS_DUPLICATE:       return "DUPLICATE";
+        case STATUS_OUT_OF_SYLLABUS: return "OUT_OF_SYLLABUS";
+        default:                     return "UNKNOWN";
+    }
 }
\ No newline at end of file
@@ -1,24 +1,32 @@
-/*
- * compiler/ast_helpers.h
- * Prototypes for AST helper functions (creation, traversal, export)
- */
-
-#ifndef AST_HELPERS_H
-#define AST_HELPERS_H
-
-#include "ast.h" // Include our data structure definitions
-
-/* --- AST Creation Functions (called by parser) --- */
-
-ASTNode* create_ast_node(char* subject, int marks, int time, char* syllabus_path, QuestionNode* questions);
-QuestionNode* create_question_node(char* text, int marks);
-QuestionNode* append_question(QuestionNode* list_head, QuestionNode* new_question);
-void free_ast(ASTNode* root);
-
-
-/* --- Web Output Functions (called by main.c) --- */
-
-// Phase 2: Generates the ast.dot file for the web UI
-void export_ast_to_dot(ASTNode* root, const char* filepath);
-
+/*
+ * compiler/ast_helpers.h
+ * Prototypes for AST helper functions (creation, traversal, export)
+ */
+
+#ifndef AST_HELPERS_H
+#define AST_HELPERS_H
+
+#include "ast.h" // Include our data structure definitions
+
+/* --- AST Creation Functions (called by parser) --- */
+
+// Nodes are allocated from 'arena' (one per job), so they are never
+// freed one by one. String arguments are views into the source buffer;
+// they are not copied.
+ASTNode* create_ast_node(Arena* arena, const char* subject, int marks, int time, const char* syllabus_path, QuestionNode* questions);
+QuestionNode* create_question_node(Arena* arena, const char* text, int marks);
+void init_question_list(QuestionList* list);
+void append_question(QuestionList* list, QuestionNode* new_question); // O(1)
+void free_ast(ASTNode* root); // Releases the whole arena in one go
+
+
+/* --- Annotation Names (for reports) --- */
+
+const char* difficulty_name(int difficulty);   // "Easy", "Medium", "Hard", "N/A"
+const char* blooms_level_name(int level);      // "Remembering", ..., "N/A"
+const char* status_flag_name(int status_flag); // "OK", "DUPLICATE", "OUT_OF_SYLLABUS"
+
+
+// The Phase 2 web output (ast.dot, ast.json) is in ast_export.h
+
 #endif // AST_HELPERS_H
\ No newline at end of file
@@ -1 +1 @@
-/* C source placeholder */
+/* C source placeholder */
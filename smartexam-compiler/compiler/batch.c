@@ -0,0 +1,330 @@
+/*
+ * compiler/batch.c
+ * Batch compilation on a work-stealing thread pool (see batch.h).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <time.h>
+#include <glob.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include "batch.h"
+
+/* --- Finding Job Directories --- */
+
+typedef struct DirList {
+    char** items;
+    size_t count;
+    size_t capacity;
+} DirList;
+
+// A path too long for the buffer is not a job dir: a cut-off path would
+// name some other file
+static int is_job_dir(const char* path) {
+    char input_path[PATH_MAX];
+    struct stat st;
+    int n = snprintf(input_path, sizeof(input_path), "%s/input.qp", path);
+    if (n < 0 || (size_t)n >= sizeof(input_path)) return 0;
+    return stat(input_path, &st) == 0 && S_ISREG(st.st_mode);
+}
+
+static int is_dir(const char* path) {
+    struct stat st;
+    return stat(path, &st) == 0 && S_ISDIR(st.st_mode);
+}
+
+static int push_dir(DirList* list, const char* path) {
+    if (list->count == list->capacity) {
+        size_t capacity = list->capacity == 0 ? 64 : list->capacity * 2;
+        char** items = (char**)realloc(list->items, sizeof(char*) * capacity);
+        if (items == NULL) return -1;
+        list->items = items;
+        list->capacity = capacity;
+    }
+    char* copy = strdup(path);
+    if (copy == NULL) return -1;
+    list->items[list->count++] = copy;
+    return 0;
+}
+
+// A job dir is added as is; any other directory is searched one level
+// deep for job dirs (so "jobs/" means every job under jobs/)
+static int add_path(DirList* list, const char* path) {
+    if (is_job_dir(path)) return push_dir(list, path);
+    if (!is_dir(path)) {
+        fprintf(stderr, "Warning: Skipping %s (not a job directory)\n", path);
+        return 0;
+    }
+
+    DIR* dir = opendir(path);
+    if (dir == NULL) {
+        perror(path);
+        return 0;
+    }
+    size_t len = strlen(path);
+    const char* sep = len > 0 && path[len - 1] == '/' ? "" : "/";
+    struct dirent* entry;
+    int result = 0;
+    while (result == 0 && (entry = readdir(dir)) != NULL) {
+        if (entry->d_name[0] == '.') continue;
+        char child[PATH_MAX];
+        int n = snprintf(child, sizeof(child), "%s%s%s", path, sep, entry->d_name);
+        if (n < 0 || (size_t)n >= sizeof(child)) {
+            fprintf(stderr, "Warning: Skipping %s/%s (path too long)\n", path, entry->d_name);
+            continue;
+        }
+        if (is_job_dir(child)) result = push_dir(list, child);
+    }
+    closedir(dir);
+    return result;
+}
+
+static int compare_paths(const void* a, const void* b) {
+    return strcmp(*(char* const*)a, *(char* const*)b);
+}
+
+int batch_expand(const char* const* args, size_t arg_count, char*** dirs, size_t* dir_count) {
+    DirList list = { NULL, 0, 0 };
+    int result = 0;
+
+    for (size_t i = 0; i < arg_count && result == 0; i++) {
+        // The shell usually expands globs already; this handles quoted
+        // patterns and argument lists too long for the shell
+        if (strpbrk(args[i], "*?[") == NULL) {
+            result = add_path(&list, args[i]);
+            continue;
+        }
+        glob_t matches;
+        int found = glob(args[i], 0, NULL, &matches);
+        if (found == GLOB_NOSPACE) {
+            result = -1;
+        } else if (found == 0) {
+            for (size_t m = 0; m < matches.gl_pathc && result == 0; m++) {
+                result = add_path(&list, matches.gl_pathv[m]);
+            }
+        } else {
+            fprintf(stderr, "Warning: No job directories match %s\n", args[i]);
+        }
+        if (found != GLOB_NOMATCH) globfree(&matches);
+    }
+
+    if (result != 0) {
+        batch_free_dirs(list.items, list.count);
+        return -1;
+    }
+    if (list.count > 1) qsort(list.items, list.count, sizeof(char*), compare_paths);
+    *dirs = list.items;
+    *dir_count = list.count;
+    return 0;
+}
+
+void batch_free_dirs(char** dirs, size_t dir_count) {
+    for (size_t i = 0; i < dir_count; i++) {
+        free(dirs[i]);
+    }
+    free(dirs);
+}
+
+/* --- Work-Stealing Pool --- */
+
+// Each worker owns the jobs [next, end). The owner takes jobs from the
+// front; a thief takes the back half. Both only touch the range while
+// holding its lock, which is held for a few instructions at a time.
+typedef struct WorkRange {
+    pthread_mutex_t lock;
+    size_t next;
+    size_t end;
+} WorkRange;
+
+typedef struct Pool {
+    const char* const* dirs;
+    const JobContext* defaults;
+    SemanticCache* cache;
+    WorkRange* ranges;
+    int worker_count;
+
+    pthread_mutex_t stats_lock; // Guards the totals below
+    size_t failed;
+    size_t cached;
+    long questions;
+} Pool;
+
+typedef struct Worker {
+    Pool* pool;
+    int id;
+} Worker;
+
+static int take_own(WorkRange* range, size_t* job) {
+    pthread_mutex_lock(&range->lock);
+    int found = range->next < range->end;
+    if (found) *job = range->next++;
+    pthread_mutex_unlock(&range->lock);
+    return found;
+}
+
+// Moves the back half of another worker's range into 'own'
+static int steal(Pool* pool, int self) {
+    WorkRange* own = &pool->ranges[self];
+    for (int k = 1; k < pool->worker_count; k++) {
+        WorkRange* victim = &pool->ranges[(self + k) % pool->worker_count];
+        pthread_mutex_lock(&victim->lock);
+        size_t left = victim->end - victim->next;
+        size_t start = 0, end = 0;
+        if (left > 0) {
+            // With one job left the thief takes it; the victim is busy anyway
+            start = victim->end - (left + 1) / 2;
+            end = victim->end;
+            victim->end = start;
+        }
+        pthread_mutex_unlock(&victim->lock);
+
+        if (end > start) {
+            pthread_mutex_lock(&own->lock);
+            own->next = start;
+            own->end = end;
+            pthread_mutex_unlock(&own->lock);
+            return 1;
+        }
+    }
+    return 0; // Every range is empty: the batch is done
+}
+
+static void compile_one(Pool* pool, size_t index, size_t* failed, size_t* cached, long* questions) {
+    JobContext job;
+    job_init(&job, pool->dirs[index]);
+    job_copy_options(&job, pool->defaults);
+    job.cache = pool->cache;
+    if (pool->worker_count > 1) {
+        job.lex_threads = 1; // The other cores are busy with other jobs
+    }
+
+    if (job_compile(&job) != 0) {
+        (*failed)++;
+    } else if (job.cache_hit) {
+        (*cached)++; // Nothing was parsed, so there are no questions to count
+    } else {
+        if (job.front_end_cached) (*cached)++;
+        *questions += job.store.count;
+    }
+    job_cleanup(&job);
+}
+
+static void* worker_main(void* arg) {
+    Worker* worker = (Worker*)arg;
+    Pool* pool = worker->pool;
+    size_t failed = 0;
+    size_t cached = 0;
+    long questions = 0;
+    size_t index;
+
+    do {
+        while (take_own(&pool->ranges[worker->id], &index)) {
+            compile_one(pool, index, &failed, &cached, &questions);
+        }
+    } while (steal(pool, worker->id));
+
+    pthread_mutex_lock(&pool->stats_lock);
+    pool->failed += failed;
+    pool->cached += cached;
+    pool->questions += questions;
+    pthread_mutex_unlock(&pool->stats_lock);
+    return NULL;
+}
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+size_t run_batch(const char* const* dirs, size_t dir_count, const JobContext* defaults,
+                 int threads, BatchStats* stats) {
+    double start = now_seconds();
+    memset(stats, 0, sizeof(*stats));
+    stats->papers = dir_count;
+
+    if (threads <= 0) {
+        long cores = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cores > 0 ? (int)cores : 1;
+    }
+    if (threads > BATCH_MAX_THREADS) threads = BATCH_MAX_THREADS;
+    if ((size_t)threads > dir_count) threads = dir_count > 0 ? (int)dir_count : 1;
+
+    // One cache for the whole batch: the difficulty automaton and each
+    // distinct syllabus are compiled once instead of once per paper
+    SemanticCache cache;
+    SemanticCache* shared = semantic_cache_init(&cache) == 0 ? &cache : NULL;
+
+    Pool pool;
+    memset(&pool, 0, sizeof(pool));
+    pool.dirs = dirs;
+    pool.defaults = defaults;
+    pool.cache = shared;
+    pool.worker_count = threads;
+    pool.ranges = (WorkRange*)calloc((size_t)threads, sizeof(WorkRange));
+    Worker* workers = (Worker*)calloc((size_t)threads, sizeof(Worker));
+    pthread_t* ids = (pthread_t*)calloc((size_t)threads, sizeof(pthread_t));
+    if (pool.ranges == NULL || workers == NULL || ids == NULL) {
+        fprintf(stderr, "Fatal Error: Out of memory starting the batch\n");
+        free(pool.ranges);
+        free(workers);
+        free(ids);
+        if (shared != NULL) semantic_cache_free(shared);
+        stats->failed = dir_count;
+        return dir_count;
+    }
+    pthread_mutex_init(&pool.stats_lock, NULL);
+
+    // Contiguous, nearly equal ranges; stealing evens out the rest
+    for (int w = 0; w < threads; w++) {
+        pthread_mutex_init(&pool.ranges[w].lock, NULL);
+        pool.ranges[w].next = dir_count * (size_t)w / (size_t)threads;
+        pool.ranges[w].end = dir_count * (size_t)(w + 1) / (size_t)threads;
+        workers[w].pool = &pool;
+        workers[w].id = w;
+    }
+
+    // Worker 0 runs on this thread
+    int started = 1;
+    for (int w = 1; w < threads; w++) {
+        if (pthread_create(&ids[w], NULL, worker_main, &workers[w]) != 0) {
+            fprintf(stderr, "Warning: Could only start %d of %d worker threads\n", started, threads);
+            break;
+        }
+        started++;
+    }
+    stats->threads = started;
+    worker_main(&workers[0]); // Also steals the ranges of threads that didn't start
+    for (int w = 1; w < started; w++) {
+        pthread_join(ids[w], NULL);
+    }
+
+    for (int w = 0; w < threads; w++) {
+        pthread_mutex_destroy(&pool.ranges[w].lock);
+    }
+    pthread_mutex_destroy(&pool.stats_lock);
+    free(pool.ranges);
+    free(workers);
+    free(ids);
+    if (shared != NULL) semantic_cache_free(shared);
+
+    stats->failed = pool.failed;
+    stats->cached = pool.cached;
+    stats->questions = pool.questions;
+    stats->seconds = now_seconds() - start;
+    return pool.failed;
+}
+
+void batch_print_stats(const BatchStats* stats) {
+    double seconds = stats->seconds > 0 ? stats->seconds : 1e-9;
+    printf("Batch: %zu papers (%zu failed, %zu from cache), %ld questions in %.2f s on %d threads\n",
+           stats->papers, stats->failed, stats->cached, stats->questions, stats->seconds,
+           stats->threads);
+    printf("Throughput: %.1f papers/s, %.1f questions/s\n",
+           (double)stats->papers / seconds, (double)stats->questions / seconds);
+}
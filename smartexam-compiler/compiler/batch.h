@@ -0,0 +1,52 @@
+/*
+ * compiler/batch.h
+ * Batch mode: q_compiler --batch <job dirs, globs or jobs/ folders>
+ *
+ * Compiles many jobs (e.g. a whole semester archive) in one process on a
+ * small pool of worker threads, one per CPU core. The jobs are split into
+ * one contiguous range per worker; a worker that finishes its range early
+ * steals half of the remaining range of another worker, so one slow paper
+ * doesn't leave the other cores idle.
+ */
+
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <stddef.h>
+#include "job.h"
+
+// Most worker threads one batch starts, whatever --threads says
+#define BATCH_MAX_THREADS 64
+
+typedef struct BatchStats {
+    size_t papers;     // Jobs compiled
+    size_t failed;     // ... of which failed
+    size_t cached;     // ... of which reused an identical paper's outputs
+    long questions;    // Questions in the jobs that were compiled
+    double seconds;    // Wall-clock time for the whole batch
+    int threads;       // Worker threads used
+} BatchStats;
+
+/* --- Batch Functions --- */
+
+// Expands the command line arguments into job directories (a directory
+// with an input.qp file). Each argument may be
+//   - a job directory:          jobs/d4a5c68e...
+//   - a glob pattern:           'jobs/2025-*'
+//   - a folder of job dirs:     jobs/
+// The result is sorted. Free it with batch_free_dirs().
+// Returns 0 on success, -1 if out of memory.
+int batch_expand(const char* const* args, size_t arg_count, char*** dirs, size_t* dir_count);
+void batch_free_dirs(char** dirs, size_t dir_count);
+
+// Compiles every job in 'dirs' with the options in 'defaults' (use_mmap,
+// token_formats, bank options). 'threads' <= 0 means one per core; at
+// most BATCH_MAX_THREADS are started.
+// Returns the number of failed jobs.
+size_t run_batch(const char* const* dirs, size_t dir_count, const JobContext* defaults,
+                 int threads, BatchStats* stats);
+
+// Prints papers/s and questions/s
+void batch_print_stats(const BatchStats* stats);
+
+#endif // BATCH_H
@@ -0,0 +1,82 @@
+/*
+ * compiler/bench_ast.c
+ * Benchmark: how building the question list scales with question count.
+ *
+ * Build and run with:  make bench
+ *
+ * For each size N it builds an N-question list the way the parser does
+ * (create_question_node + append_question) and reports the time per
+ * question. With the O(1) tail append the ns/question column stays flat.
+ * The "walk" column repeats the old append, which walked the list to the
+ * end every time, to show the quadratic growth it replaced.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "ast_helpers.h"
+
+#define MAX_WALK_QUESTIONS 32000 // The old append gets too slow past this
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+// The previous append_question(): find the end of the list every time
+static QuestionNode* append_question_walk(QuestionNode* list_head, QuestionNode* new_question) {
+    if (list_head == NULL) return new_question;
+    QuestionNode* current = list_head;
+    while (current->next != NULL) {
+        current = current->next;
+    }
+    current->next = new_question;
+    return list_head;
+}
+
+static double bench_tail_append(int n) {
+    Arena arena;
+    arena_init(&arena);
+    double start = now_ms();
+    QuestionList list;
+    init_question_list(&list);
+    for (int i = 0; i < n; i++) {
+        append_question(&list, create_question_node(&arena, "Explain the phases of a compiler.", 10));
+    }
+    ASTNode* root = create_ast_node(&arena, "Bench", 10 * n, 180, "syllabus.txt", list.head);
+    root->question_count = list.count;
+    free_ast(root); // Included in the timing: it is part of a job's cost
+    return now_ms() - start;
+}
+
+static double bench_walk_append(int n) {
+    Arena arena;
+    arena_init(&arena);
+    double start = now_ms();
+    QuestionNode* head = NULL;
+    for (int i = 0; i < n; i++) {
+        head = append_question_walk(head, create_question_node(&arena, "Explain the phases of a compiler.", 10));
+    }
+    ASTNode* root = create_ast_node(&arena, "Bench", 10 * n, 180, "syllabus.txt", head);
+    root->question_count = n;
+    free_ast(root); // Included in the timing: it is part of a job's cost
+    return now_ms() - start;
+}
+
+int main(void) {
+    printf("%10s %14s %14s %14s %14s\n",
+           "questions", "tail ms", "tail ns/q", "walk ms", "walk ns/q");
+
+    for (int n = 1000; n <= 64000; n *= 2) {
+        double tail = bench_tail_append(n);
+        printf("%10d %14.2f %14.1f", n, tail, tail * 1e6 / n);
+        if (n <= MAX_WALK_QUESTIONS) {
+            double walk = bench_walk_append(n);
+            printf(" %14.2f %14.1f\n", walk, walk * 1e6 / n);
+        } else {
+            printf(" %14s %14s\n", "-", "-");
+        }
+    }
+    return 0;
+}
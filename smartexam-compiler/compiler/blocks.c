@@ -0,0 +1,133 @@
+/*
+ * compiler/blocks.c
+ * Finds the question blocks of a DSL source (see blocks.h).
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "blocks.h"
+
+static const char question_start[] = "[QUESTION]";
+static const char question_end[] = "[/QUESTION]";
+
+static uint64_t hash_bytes(const char* data, size_t len) {
+    uint64_t h = 14695981039346656037ull; // FNV-1a
+    for (size_t i = 0; i < len; i++) {
+        h ^= (unsigned char)data[i];
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+static int starts_with(const char* text, size_t len, size_t at, const char* tag, size_t tlen) {
+    return len - at >= tlen && memcmp(text + at, tag, tlen) == 0;
+}
+
+// Offset of the next 'c' at or after 'from', or 'len' if there is none.
+// memchr() checks a whole vector register of bytes per step.
+static size_t find_next(const char* text, size_t len, size_t from, char c) {
+    if (from >= len) return len;
+    const char* p = (const char*)memchr(text + from, c, len - from);
+    return p != NULL ? (size_t)(p - text) : len;
+}
+
+// Newlines in [from, to), counted without a branch per byte.
+static int count_lines(const char* text, size_t from, size_t to) {
+    int n = 0;
+    for (size_t i = from; i < to; i++) {
+        n += text[i] == '\n';
+    }
+    return n;
+}
+
+static int all_blank(const char* text, size_t from, size_t to) {
+    for (size_t i = from; i < to; i++) {
+        char c = text[i];
+        if (c != ' ' && c != '\t' && c != '\r' && c != '\n') return 0;
+    }
+    return 1;
+}
+
+int source_split_blocks(const char* text, size_t len, SourceBlocks* out, Arena* arena) {
+    memset(out, 0, sizeof(*out));
+    SourceBlock* blocks = NULL;
+    int count = 0, capacity = 0;
+    int line = 1;
+    size_t counted = 0; // 'line' is the line of this offset
+    int end_line = 1;   // Line the last block ended on
+    int in_block = 0;
+    int result = 0;
+
+    // Only quotes and tags matter, so jump from one to the next
+    size_t next_quote = find_next(text, len, 0, '"');
+    size_t next_tag = find_next(text, len, 0, '[');
+    while (result == 0) {
+        size_t i = next_quote < next_tag ? next_quote : next_tag;
+        if (i == len) break;
+        if (i == next_quote) {
+            // A string: the lexer takes everything up to the next quote
+            size_t close = find_next(text, len, i + 1, '"');
+            if (close == len) {
+                result = -1; // Unclosed: the lexer would see an error token
+                break;
+            }
+            next_quote = find_next(text, len, close + 1, '"');
+            if (next_tag < close) next_tag = find_next(text, len, close + 1, '[');
+            continue;
+        }
+        next_tag = find_next(text, len, i + 1, '[');
+        if (starts_with(text, len, i, question_start, sizeof(question_start) - 1)) {
+            // Nothing but blanks may come between two blocks
+            if (in_block || (count > 0 && !all_blank(text, blocks[count - 1].end, i))) {
+                result = -1;
+                break;
+            }
+            if (count == capacity) {
+                capacity = capacity > 0 ? capacity * 2 : 64;
+                SourceBlock* grown = (SourceBlock*)realloc(blocks, sizeof(SourceBlock) * capacity);
+                if (grown == NULL) {
+                    result = -1;
+                    break;
+                }
+                blocks = grown;
+            }
+            line += count_lines(text, counted, i);
+            counted = i;
+            blocks[count].start = i;
+            blocks[count].line = line;
+            in_block = 1;
+        } else if (starts_with(text, len, i, question_end, sizeof(question_end) - 1)) {
+            if (!in_block) {
+                result = -1;
+                break;
+            }
+            line += count_lines(text, counted, i);
+            counted = i;
+            blocks[count].end = i + sizeof(question_end) - 1;
+            end_line = line;
+            count++;
+            in_block = 0;
+        }
+    }
+    if (in_block) result = -1;
+
+    if (result == 0) {
+        out->count = count;
+        out->blocks = (SourceBlock*)arena_alloc(arena, sizeof(SourceBlock) * (count > 0 ? count : 1));
+        if (out->blocks == NULL) result = -1;
+    }
+    if (result == 0) {
+        if (count > 0) memcpy(out->blocks, blocks, sizeof(SourceBlock) * count);
+        for (int b = 0; b < count; b++) {
+            SourceBlock* block = &out->blocks[b];
+            block->hash = hash_bytes(text + block->start, block->end - block->start);
+        }
+        out->prefix_end = count > 0 ? out->blocks[0].start : len;
+        out->suffix_start = count > 0 ? out->blocks[count - 1].end : len;
+        out->prefix_hash = hash_bytes(text, out->prefix_end);
+        out->suffix_hash = hash_bytes(text + out->suffix_start, len - out->suffix_start);
+        out->suffix_line = count > 0 ? end_line : line + count_lines(text, counted, len);
+    }
+    free(blocks);
+    return result;
+}
@@ -0,0 +1,49 @@
+/*
+ * compiler/blocks.h
+ * Splits a DSL source into its [QUESTION] ... [/QUESTION] blocks.
+ *
+ * A quick scan that only knows about strings and the two question tags,
+ * so it is much cheaper than running the lexer: it jumps from quote to
+ * quote and tag to tag with memchr(). Incremental recompiles
+ * (incremental.h) use it to fingerprint every question block, and the
+ * parallel front end (parallel.h) to hand out blocks to threads.
+ *
+ * The source is cut into three parts:
+ *     prefix    everything before the first block (the header)
+ *     blocks    the questions, with only blanks between them
+ *     suffix    everything after the last block ([/QUESTION_LIST])
+ */
+
+#ifndef BLOCKS_H
+#define BLOCKS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "arena.h"
+
+typedef struct SourceBlock {
+    size_t start;      // Offset of "[QUESTION]"
+    size_t end;        // Offset just past "[/QUESTION]"
+    int line;          // Line of 'start', counting from 1 like the lexer
+    uint64_t hash;     // FNV-1a of the block's bytes
+} SourceBlock;
+
+typedef struct SourceBlocks {
+    SourceBlock* blocks;
+    int count;
+    size_t prefix_end;    // Prefix is [0, prefix_end)
+    uint64_t prefix_hash;
+    size_t suffix_start;  // Suffix is [suffix_start, length)
+    int suffix_line;
+    uint64_t suffix_hash;
+} SourceBlocks;
+
+/* --- Block Functions --- */
+
+// Splits 'text'. The blocks array comes from 'arena'.
+// Returns 0 on success, -1 if out of memory or the source can't be split
+// the way the lexer would see it (an unclosed string or block, a block
+// inside a block, or anything but blanks between two blocks).
+int source_split_blocks(const char* text, size_t len, SourceBlocks* out, Arena* arena);
+
+#endif // BLOCKS_H
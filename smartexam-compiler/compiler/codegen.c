@@ -0,0 +1,330 @@
+/*
+ * compiler/codegen.c
+ * Phase 6: EnhancedPaper.tex and AnalysisReport.tex (see codegen.h).
+ */
+
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <spawn.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "codegen.h"
+#include "ast_helpers.h"
+#include "pdf_writer.h"
+#include "tex_writer.h"
+
+extern char** environ;
+
+// Totals over the AST, for the report
+typedef struct PaperSummary {
+    long marks;
+    long time;
+    int count[DIFFICULTY_COUNT];     // Questions per difficulty
+    long marks_by[DIFFICULTY_COUNT]; // Marks per difficulty
+    int* topic_count;                // Per topic id
+    long* topic_marks;
+} PaperSummary;
+
+static int summarize(const ASTNode* root, PaperSummary* s, Arena* arena) {
+    memset(s, 0, sizeof(*s));
+    size_t topics = root->topics.count > 0 ? (size_t)root->topics.count : 1;
+    s->topic_count = (int*)arena_alloc(arena, sizeof(int) * topics);
+    s->topic_marks = (long*)arena_alloc(arena, sizeof(long) * topics);
+    if (s->topic_count == NULL || s->topic_marks == NULL) return -1;
+    memset(s->topic_count, 0, sizeof(int) * topics);
+    memset(s->topic_marks, 0, sizeof(long) * topics);
+    for (const QuestionNode* q = root->questions; q != NULL; q = q->next) {
+        int d = q->difficulty < DIFFICULTY_COUNT ? q->difficulty : DIFFICULTY_UNKNOWN;
+        int t = q->syllabus_topic < topics ? q->syllabus_topic : TOPIC_NONE;
+        s->marks += q->marks;
+        s->time += q->estimated_time;
+        s->count[d]++;
+        s->marks_by[d] += q->marks;
+        s->topic_count[t]++;
+        s->topic_marks[t] += q->marks;
+    }
+    return 0;
+}
+
+static const char* subject_of(const ASTNode* root) {
+    return root->subject != NULL && root->subject[0] != '\0' ? root->subject : "Question Paper";
+}
+
+/* --- EnhancedPaper.tex --- */
+
+static void write_paper_tex(TexWriter* w, const ASTNode* root) {
+    tex_raw(w, "\\documentclass{article}\n\\begin{document}\n\\section*{");
+    tex_text(w, subject_of(root));
+    tex_raw(w, "}\n");
+    tex_rawf(w, "\\noindent Total marks: %d \\hfill Time: %d minutes\n\n", root->total_marks, root->total_time);
+    int i = 1;
+    for (const QuestionNode* q = root->questions; q != NULL; q = q->next, i++) {
+        tex_rawf(w, "\\paragraph{Q%d (%d marks)} ", i, q->marks);
+        tex_text(w, q->text);
+        tex_raw(w, "\n\n");
+    }
+    tex_raw(w, "\\end{document}\n");
+}
+
+/* --- AnalysisReport.tex --- */
+
+// The first CODEGEN_REPORT_TEXT bytes of 'text', not cutting a UTF-8 sequence
+static void write_short_text(TexWriter* w, const char* text) {
+    size_t len = strlen(text);
+    if (len <= CODEGEN_REPORT_TEXT) {
+        tex_text_n(w, text, len);
+        return;
+    }
+    len = CODEGEN_REPORT_TEXT;
+    while (len > 0 && ((unsigned char)text[len] & 0xC0) == 0x80) len--;
+    tex_text_n(w, text, len);
+    tex_raw(w, "\\ldots{}");
+}
+
+static void write_report_tex(TexWriter* w, const ASTNode* root, const PaperSummary* s) {
+    tex_raw(w, "\\documentclass{article}\n\\usepackage{longtable}\n\\begin{document}\n");
+    tex_raw(w, "\\section*{Analysis Report: ");
+    tex_text(w, subject_of(root));
+    tex_raw(w, "}\n\n");
+
+    // --- Totals ---
+    tex_raw(w, "\\subsection*{Totals}\n\\begin{tabular}{lrr}\n & Questions & Header \\\\ \\hline\n");
+    tex_rawf(w, "Marks & %ld & %d \\\\\n", s->marks, root->total_marks);
+    tex_rawf(w, "Time (minutes) & %ld & %d \\\\\n", s->time, root->total_time);
+    tex_rawf(w, "Questions & %d & \\\\\n\\end{tabular}\n\n", root->question_count);
+    if (root->total_marks > 0) {
+        tex_rawf(w, "\\noindent Marks check: \\textbf{%s}\n\n", s->marks == root->total_marks ? "PASS" : "FAIL");
+    }
+
+    // --- Difficulty ---
+    tex_raw(w, "\\subsection*{Difficulty}\n\\begin{tabular}{lrrr}\n");
+    tex_raw(w, "Difficulty & Questions & Marks & Share \\\\ \\hline\n");
+    for (int d = DIFFICULTY_EASY; d <= DIFFICULTY_COUNT; d++) {
+        int level = d < DIFFICULTY_COUNT ? d : DIFFICULTY_UNKNOWN; // N/A last, if any
+        if (level == DIFFICULTY_UNKNOWN && s->count[level] == 0) continue;
+        double share = root->question_count > 0 ? 100.0 * s->count[level] / root->question_count : 0.0;
+        tex_rawf(w, "%s & %d & %ld & %.1f\\%% \\\\\n", difficulty_name(level), s->count[level],
+                 s->marks_by[level], share);
+    }
+    tex_raw(w, "\\end{tabular}\n\n");
+
+    // --- Syllabus units ---
+    tex_raw(w, "\\subsection*{Syllabus Units}\n\\begin{tabular}{lrr}\n");
+    tex_raw(w, "Unit & Questions & Marks \\\\ \\hline\n");
+    for (int t = 1; t <= root->topics.count; t++) {
+        int topic = t < root->topics.count ? t : TOPIC_NONE; // N/A last, if any
+        if (s->topic_count[topic] == 0) continue;
+        tex_text(w, topic_name(&root->topics, topic));
+        tex_rawf(w, " & %d & %ld \\\\\n", s->topic_count[topic], s->topic_marks[topic]);
+    }
+    tex_raw(w, "\\end{tabular}\n\n");
+
+    // --- Every question ---
+    tex_raw(w, "\\subsection*{Questions}\n{\\small\n\\begin{longtable}{rrrlp{2.2cm}p{2.2cm}p{4.4cm}}\n");
+    tex_raw(w, "No. & Marks & Time & Difficulty & Unit & Status & Question \\\\ \\hline\n\\endhead\n");
+    int i = 1;
+    for (const QuestionNode* q = root->questions; q != NULL; q = q->next, i++) {
+        tex_rawf(w, "%d & %d & %d & %s & ", i, q->marks, q->estimated_time, difficulty_name(q->difficulty));
+        tex_text(w, topic_name(&root->topics, q->syllabus_topic));
+        tex_raw(w, " & ");
+        tex_text(w, status_flag_name(q->status_flag));
+        tex_raw(w, " & ");
+        write_short_text(w, q->text);
+        tex_raw(w, " \\\\\n");
+    }
+    tex_raw(w, "\\end{longtable}\n}\n\\end{document}\n");
+}
+
+/* --- PDF --- */
+
+// The same two documents, laid out by pdf_writer.c
+
+static void write_paper_pdf(PdfWriter* w, const ASTNode* root) {
+    char left[64], right[64], lead[64];
+    pdf_heading(w, subject_of(root), PDF_TITLE_SIZE);
+    snprintf(left, sizeof(left), "Total marks: %d", root->total_marks);
+    snprintf(right, sizeof(right), "Time: %d minutes", root->total_time);
+    pdf_line_lr(w, left, right);
+    pdf_space(w, PDF_TEXT_SIZE);
+    int i = 1;
+    for (const QuestionNode* q = root->questions; q != NULL; q = q->next, i++) {
+        snprintf(lead, sizeof(lead), "Q%d (%d marks)", i, q->marks);
+        pdf_paragraph(w, lead, q->text, strlen(q->text));
+    }
+}
+
+static const PdfColumn totals_columns[] = {
+    { "", 243, 0 }, { "Questions", 120, 1 }, { "Header", 120, 1 }
+};
+static const PdfColumn difficulty_columns[] = {
+    { "Difficulty", 183, 0 }, { "Questions", 100, 1 }, { "Marks", 100, 1 }, { "Share", 100, 1 }
+};
+static const PdfColumn unit_columns[] = {
+    { "Unit", 283, 0 }, { "Questions", 100, 1 }, { "Marks", 100, 1 }
+};
+static const PdfColumn question_columns[] = {
+    { "No.", 28, 1 }, { "Marks", 34, 1 }, { "Time", 30, 1 }, { "Difficulty", 52, 0 },
+    { "Unit", 85, 0 }, { "Status", 96, 0 }, { "Question", 158, 0 }
+};
+#define COLUMNS(c) (int)(sizeof(c) / sizeof((c)[0]))
+
+static void write_report_pdf(PdfWriter* w, const ASTNode* root, const PaperSummary* s) {
+    char a[32], b[32], c[32];
+    char title[512];
+    snprintf(title, sizeof(title), "Analysis Report: %s", subject_of(root));
+    pdf_heading(w, title, PDF_TITLE_SIZE);
+
+    // --- Totals ---
+    pdf_heading(w, "Totals", PDF_HEADING_SIZE);
+    pdf_table_begin(w, totals_columns, COLUMNS(totals_columns));
+    snprintf(a, sizeof(a), "%ld", s->marks);
+    snprintf(b, sizeof(b), "%d", root->total_marks);
+    pdf_table_row(w, (const char* const[]){ "Marks", a, b });
+    snprintf(a, sizeof(a), "%ld", s->time);
+    snprintf(b, sizeof(b), "%d", root->total_time);
+    pdf_table_row(w, (const char* const[]){ "Time (minutes)", a, b });
+    snprintf(a, sizeof(a), "%d", root->question_count);
+    pdf_table_row(w, (const char* const[]){ "Questions", a, "" });
+    pdf_table_end(w);
+    if (root->total_marks > 0) {
+        const char* check = s->marks == root->total_marks ? "PASS" : "FAIL";
+        pdf_paragraph(w, "Marks check:", check, strlen(check));
+    }
+
+    // --- Difficulty ---
+    pdf_heading(w, "Difficulty", PDF_HEADING_SIZE);
+    pdf_table_begin(w, difficulty_columns, COLUMNS(difficulty_columns));
+    for (int level = DIFFICULTY_EASY; level <= DIFFICULTY_COUNT; level++) {
+        int l = level < DIFFICULTY_COUNT ? level : DIFFICULTY_UNKNOWN; // N/A last, if any
+        if (l == DIFFICULTY_UNKNOWN && s->count[l] == 0) continue;
+        snprintf(a, sizeof(a), "%d", s->count[l]);
+        snprintf(b, sizeof(b), "%ld", s->marks_by[l]);
+        snprintf(c, sizeof(c), "%.1f%%", root->question_count > 0 ? 100.0 * s->count[l] / root->question_count : 0.0);
+        pdf_table_row(w, (const char* const[]){ difficulty_name(l), a, b, c });
+    }
+    pdf_table_end(w);
+
+    // --- Syllabus units ---
+    pdf_heading(w, "Syllabus Units", PDF_HEADING_SIZE);
+    pdf_table_begin(w, unit_columns, COLUMNS(unit_columns));
+    for (int t = 1; t <= root->topics.count; t++) {
+        int topic = t < root->topics.count ? t : TOPIC_NONE; // N/A last, if any
+        if (s->topic_count[topic] == 0) continue;
+        snprintf(a, sizeof(a), "%d", s->topic_count[topic]);
+        snprintf(b, sizeof(b), "%ld", s->topic_marks[topic]);
+        pdf_table_row(w, (const char* const[]){ topic_name(&root->topics, topic), a, b });
+    }
+    pdf_table_end(w);
+
+    // --- Every question ---
+    pdf_heading(w, "Questions", PDF_HEADING_SIZE);
+    pdf_table_begin(w, question_columns, COLUMNS(question_columns));
+    char text[CODEGEN_REPORT_TEXT + 4];
+    int i = 1;
+    for (const QuestionNode* q = root->questions; q != NULL; q = q->next, i++) {
+        snprintf(a, sizeof(a), "%d", i);
+        snprintf(b, sizeof(b), "%d", q->marks);
+        snprintf(c, sizeof(c), "%d", q->estimated_time);
+        size_t len = strlen(q->text);
+        if (len > CODEGEN_REPORT_TEXT) {
+            len = CODEGEN_REPORT_TEXT;
+            while (len > 0 && ((unsigned char)q->text[len] & 0xC0) == 0x80) len--;
+            memcpy(text, q->text, len);
+            memcpy(text + len, "\xE2\x80\xA6", 4); // Ellipsis, with the NUL
+        } else {
+            memcpy(text, q->text, len + 1);
+        }
+        pdf_table_row(w, (const char* const[]){ a, b, c, difficulty_name(q->difficulty), topic_name(&root->topics, q->syllabus_topic),
+                                                status_flag_name(q->status_flag), text });
+    }
+    pdf_table_end(w);
+}
+
+// job_dir/<name><ext> into 'buf'. Returns -1 if it doesn't fit.
+static int doc_path(char* buf, size_t size, const char* job_dir, const char* name, const char* ext) {
+    int n = snprintf(buf, size, "%s/%s%s", job_dir, name, ext);
+    return n >= 0 && (size_t)n < size ? 0 : -1;
+}
+
+// Runs pdflatex on job_dir/<name>.tex. Returns 0 if it wrote the PDF.
+static int run_pdflatex(const char* job_dir, const char* name) {
+    char tex[PATH_MAX], pdf[PATH_MAX], out_dir[PATH_MAX + 32];
+    int n = snprintf(out_dir, sizeof(out_dir), "-output-directory=%s", job_dir);
+    if (doc_path(tex, sizeof(tex), job_dir, name, ".tex") != 0 ||
+        doc_path(pdf, sizeof(pdf), job_dir, name, ".pdf") != 0 || n < 0 || (size_t)n >= sizeof(out_dir)) {
+        return -1;
+    }
+    unlink(pdf); // May be a link into the compile cache
+    char* argv[] = { "pdflatex", "-interaction=nonstopmode", "-halt-on-error", out_dir, tex, NULL };
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addopen(&actions, STDIN_FILENO, "/dev/null", O_RDONLY, 0);
+    posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+    posix_spawn_file_actions_addopen(&actions, STDERR_FILENO, "/dev/null", O_WRONLY, 0);
+    pid_t pid;
+    int spawned = posix_spawnp(&pid, "pdflatex", &actions, NULL, argv, environ) == 0;
+    posix_spawn_file_actions_destroy(&actions);
+    int status = 0;
+    if (spawned && waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0 &&
+        access(pdf, F_OK) == 0) {
+        return 0;
+    }
+    fprintf(stderr, "Warning: pdflatex failed on %s, writing the PDF without it\n", tex);
+    return -1;
+}
+
+// Writes one of the PDFs natively. Returns 0 on success, -1 on error.
+static int write_pdf(const char* job_dir, const char* name, const ASTNode* root, const PaperSummary* s) {
+    char path[PATH_MAX];
+    if (doc_path(path, sizeof(path), job_dir, name, ".pdf") != 0) return -1;
+    PdfWriter w;
+    if (pdf_writer_begin(&w, path) != 0) return -1;
+    if (s == NULL) {
+        write_paper_pdf(&w, root);
+    } else {
+        write_report_pdf(&w, root, s);
+    }
+    return pdf_writer_end(&w);
+}
+
+/* --- Phase 6 Entry Point --- */
+
+int run_phase_6_code_gen(const ASTNode* root, const char* job_dir, int use_pdflatex, Arena* arena) {
+    PaperSummary summary;
+    if (summarize(root, &summary, arena) != 0) return -1;
+
+    // --- 1. LaTeX ---
+    TexWriter tex;
+    if (tex_writer_init(&tex) != 0) return -1;
+    char path[PATH_MAX];
+    int result = 0;
+    if (doc_path(path, sizeof(path), job_dir, "EnhancedPaper", ".tex") == 0 &&
+        tex_writer_begin(&tex, path) == 0) {
+        write_paper_tex(&tex, root);
+        if (tex_writer_end(&tex) != 0) result = -1;
+    } else {
+        result = -1;
+    }
+    if (doc_path(path, sizeof(path), job_dir, "AnalysisReport", ".tex") == 0 &&
+        tex_writer_begin(&tex, path) == 0) {
+        write_report_tex(&tex, root, &summary);
+        if (tex_writer_end(&tex) != 0) result = -1;
+    } else {
+        result = -1;
+    }
+    tex_writer_free(&tex);
+
+    // --- 2. PDF: by pdflatex if asked for, else (or if it fails) natively ---
+    int typeset = use_pdflatex && result == 0;
+    if ((!typeset || run_pdflatex(job_dir, "EnhancedPaper") != 0) &&
+        write_pdf(job_dir, "EnhancedPaper", root, NULL) != 0) {
+        result = -1;
+    }
+    if ((!typeset || run_pdflatex(job_dir, "AnalysisReport") != 0) &&
+        write_pdf(job_dir, "AnalysisReport", root, &summary) != 0) {
+        result = -1;
+    }
+    return result;
+}
@@ -0,0 +1,40 @@
+/*
+ * compiler/codegen.h
+ * Phase 6: writes the paper and its analysis as LaTeX and PDF.
+ *
+ * Walks the annotated AST once Phase 3 is done and writes two documents
+ * into the job dir:
+ *   - EnhancedPaper.tex: the paper as the students get it, the subject
+ *     and totals on top, then one paragraph per question;
+ *   - AnalysisReport.tex: the Phase 3 results for the reviewer, i.e. the
+ *     totals, questions and marks per difficulty and per syllabus unit,
+ *     and a table of every question with its time, difficulty, unit and
+ *     status.
+ * Both go through one TexWriter (see tex_writer.h), so text from the
+ * paper is always escaped and the output is written in large blocks.
+ *
+ * EnhancedPaper.pdf and AnalysisReport.pdf, which the web UI offers for
+ * download, hold the same content laid out by pdf_writer.h. That takes
+ * milliseconds. With --pdflatex they are typeset by pdflatex from the
+ * .tex files instead, which looks better but takes seconds per document;
+ * if pdflatex is missing or fails, the native PDF is written after all.
+ */
+
+#ifndef CODEGEN_H
+#define CODEGEN_H
+
+#include "arena.h"
+#include "ast.h"
+
+// Longest question text in the analysis table; the rest is cut off
+#define CODEGEN_REPORT_TEXT 120
+
+/* --- Phase 6 Entry Point --- */
+
+// Writes EnhancedPaper.tex, AnalysisReport.tex and their PDFs into
+// job_dir for 'root' (scratch memory comes from 'arena'). The PDFs come
+// from pdflatex if 'use_pdflatex' is set.
+// Returns 0 on success, -1 on error.
+int run_phase_6_code_gen(const ASTNode* root, const char* job_dir, int use_pdflatex, Arena* arena);
+
+#endif // CODEGEN_H
@@ -0,0 +1,219 @@
+/*
+ * compiler/compile_cache.c
+ * Reuses the outputs of an identical earlier job (see compile_cache.h).
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "compile_cache.h"
+#include "source.h"
+#include "syllabus.h"
+
+#define FNV_OFFSET 14695981039346656037ull
+#define FNV_PRIME  1099511628211ull
+
+typedef struct CachedOutput {
+    const char* name;
+    int front_end; // Doesn't depend on the question bank
+} CachedOutput;
+
+// Every file a compile can leave in the job dir. Entries only hold the
+// ones the job actually wrote (e.g. no tokens.bin without --tokens=bin).
+static const CachedOutput cached_outputs[] = {
+    { "tokens.json", 1 }, { "tokens.bin", 1 }, { "ast.dot", 1 }, { "ast.json", 1 },
+    { "fingerprints.bin", 1 }, { "semantic_report.json", 0 },
+    { "EnhancedPaper.tex", 0 }, { "AnalysisReport.tex", 0 },
+    { "EnhancedPaper.pdf", 0 }, { "AnalysisReport.pdf", 0 },
+    { "optimization_log.json", 0 }, { NULL, 0 }
+};
+
+// Without a report the compile didn't finish, so the entry is no use.
+// Front-end entries need the fingerprints the AST is rebuilt from.
+static const char* required_output(int front_end) {
+    return front_end ? "fingerprints.bin" : "semantic_report.json";
+}
+
+/* --- Hashing --- */
+
+static uint64_t hash_bytes(uint64_t h, const char* data, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        h ^= (unsigned char)data[i];
+        h *= FNV_PRIME;
+    }
+    return h;
+}
+
+// Copies the SYLLABUS_PATH string out of the header, like the parser
+// would see it. Returns 0 if found.
+static int find_syllabus_path(const char* text, size_t len, char* path, size_t size) {
+    static const char keyword[] = "SYLLABUS_PATH";
+    size_t klen = sizeof(keyword) - 1;
+    int in_string = 0;
+    for (size_t i = 0; i < len; i++) {
+        if (text[i] == '"') {
+            in_string = !in_string;
+        } else if (!in_string && len - i >= klen && memcmp(text + i, keyword, klen) == 0) {
+            size_t p = i + klen;
+            while (p < len && strchr(" \t\r\n:", text[p]) != NULL) p++;
+            if (p == len || text[p] != '"') return -1;
+            const char* start = text + p + 1;
+            const char* end = memchr(start, '"', len - (p + 1));
+            if (end == NULL || (size_t)(end - start) >= size) return -1;
+            memcpy(path, start, (size_t)(end - start));
+            path[end - start] = '\0';
+            return 0;
+        }
+    }
+    return -1;
+}
+
+void compile_cache_key(const char* source, size_t length, const char* job_dir,
+                       const char* options, char key[COMPILE_CACHE_KEY_SIZE]) {
+    // Exact bytes: tokens.bin and fingerprints.bin hold byte offsets
+    uint64_t input = hash_bytes(FNV_OFFSET, source, length);
+
+    // The syllabus is looked up exactly as Phase 3 will look it up, and
+    // its contents (not its path) go into the key
+    uint64_t rest = FNV_OFFSET;
+    char path[PATH_MAX];
+    SourceBuffer syllabus;
+    if (find_syllabus_path(source, length, path, sizeof(path)) == 0 &&
+        syllabus_open_file(&syllabus, path, job_dir) == 0) {
+        rest = hash_bytes(rest, syllabus.data, syllabus.length);
+        source_close(&syllabus);
+    } else {
+        rest = hash_bytes(rest, "(default topics)", 16);
+    }
+
+    char version[32];
+    snprintf(version, sizeof(version), "|v%d|", COMPILE_CACHE_VERSION);
+    rest = hash_bytes(rest, version, strlen(version));
+    rest = hash_bytes(rest, options, strlen(options));
+
+    snprintf(key, COMPILE_CACHE_KEY_SIZE, "%016llx%016llx",
+             (unsigned long long)input, (unsigned long long)rest);
+}
+
+/* --- File Helpers --- */
+
+// Fallback for when the cache is on another file system than the job
+static int copy_file(const char* from, const char* to) {
+    int in = open(from, O_RDONLY);
+    if (in < 0) return -1;
+    int out = open(to, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (out < 0) {
+        close(in);
+        return -1;
+    }
+    char buf[65536];
+    ssize_t n;
+    int result = 0;
+    while ((n = read(in, buf, sizeof(buf))) > 0) {
+        if (write(out, buf, (size_t)n) != n) {
+            result = -1;
+            break;
+        }
+    }
+    if (n < 0) result = -1;
+    close(in);
+    if (close(out) != 0) result = -1;
+    return result;
+}
+
+// Links (or copies) 'from' to 'to', replacing 'to'
+static int link_output(const char* from, const char* to) {
+    unlink(to);
+    if (link(from, to) == 0) return 0;
+    return copy_file(from, to);
+}
+
+// Removes a half-built entry
+static void remove_entry(const char* entry) {
+    char path[PATH_MAX];
+    for (int i = 0; cached_outputs[i].name != NULL; i++) {
+        if (source_path(path, sizeof(path), entry, cached_outputs[i].name) == 0) unlink(path);
+    }
+    rmdir(entry);
+}
+
+/* --- Compile Cache Functions --- */
+
+int compile_cache_fetch(const char* cache_dir, const char* key, const char* job_dir, int front_end) {
+    char entry[PATH_MAX], from[PATH_MAX], to[PATH_MAX];
+    if (source_path(entry, sizeof(entry), cache_dir, key) != 0 ||
+        source_path(from, sizeof(from), entry, required_output(front_end)) != 0 ||
+        access(from, R_OK) != 0) {
+        return -1; // A miss
+    }
+
+    for (int i = 0; cached_outputs[i].name != NULL; i++) {
+        if (front_end && !cached_outputs[i].front_end) continue;
+        if (source_path(from, sizeof(from), entry, cached_outputs[i].name) != 0 ||
+            source_path(to, sizeof(to), job_dir, cached_outputs[i].name) != 0) {
+            return -1;
+        }
+        if (access(from, R_OK) != 0) continue; // The first job didn't write this one
+        if (link_output(from, to) != 0) {
+            perror(to);
+            return -1; // The caller compiles from scratch, which replaces every file
+        }
+    }
+    return 0;
+}
+
+int compile_cache_store(const char* cache_dir, const char* key, const char* job_dir, int front_end) {
+    char entry[PATH_MAX], tmp[PATH_MAX], from[PATH_MAX], to[PATH_MAX];
+    int n = snprintf(tmp, sizeof(tmp), "%s/%s.tmp.XXXXXX", cache_dir, key);
+    if (source_path(entry, sizeof(entry), cache_dir, key) != 0 || n < 0 || (size_t)n >= sizeof(tmp)) {
+        fprintf(stderr, "Path too long: %s\n", cache_dir);
+        return -1;
+    }
+    if (access(entry, F_OK) == 0) return 0; // Another job got there first
+
+    if (mkdir(cache_dir, 0755) != 0 && errno != EEXIST) {
+        perror(cache_dir);
+        return -1;
+    }
+    // Built under a temporary name, then renamed: readers never see half an entry
+    if (mkdtemp(tmp) == NULL) {
+        perror(tmp);
+        return -1;
+    }
+    chmod(tmp, 0755);
+
+    int result = 0;
+    for (int i = 0; result == 0 && cached_outputs[i].name != NULL; i++) {
+        if (front_end && !cached_outputs[i].front_end) continue;
+        if (source_path(from, sizeof(from), job_dir, cached_outputs[i].name) != 0 ||
+            source_path(to, sizeof(to), tmp, cached_outputs[i].name) != 0) {
+            result = -1;
+        } else if (link(from, to) != 0 && errno != ENOENT && copy_file(from, to) != 0) {
+            perror(to);
+            result = -1;
+        }
+    }
+    // Nothing worth keeping without the report (or the fingerprints)
+    if (result == 0 && (source_path(from, sizeof(from), tmp, required_output(front_end)) != 0 ||
+                        access(from, R_OK) != 0)) {
+        result = -1;
+    }
+
+    if (result == 0 && rename(tmp, entry) != 0) {
+        // ENOTEMPTY/EEXIST: the same paper finished on another thread
+        if (errno != ENOTEMPTY && errno != EEXIST) {
+            perror(entry);
+            result = -1;
+        }
+        remove_entry(tmp);
+    } else if (result != 0) {
+        remove_entry(tmp);
+    }
+    return result;
+}
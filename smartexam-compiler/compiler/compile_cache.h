@@ -0,0 +1,59 @@
+/*
+ * compiler/compile_cache.h
+ * Content-addressed cache of finished compiles.
+ *
+ * The same paper is often uploaded more than once (retries after a
+ * timeout, several reviewers), and every upload gets a fresh job
+ * directory. Before compiling, a job is hashed into a key: its input.qp,
+ * the syllabus file the header names, and the options that shape the
+ * outputs. input.qp is hashed byte for byte, not normalized: tokens.bin
+ * and fingerprints.bin record byte offsets, so even extra blanks change
+ * them. If an earlier job had the same key, its output files are
+ * hardlinked into the new job instead of being computed again.
+ *
+ * Jobs that check the question bank (the default) only reuse the
+ * outputs of Phases 1 & 2: tokens.json, tokens.bin, ast.dot, ast.json
+ * and fingerprints.bin. Their report depends on what the bank holds when
+ * they run, and each of them has to be added to the bank, so job.c
+ * rebuilds the AST from the cached fingerprints (see incremental.h:
+ * nothing is lexed, and every question keeps its Phase 3 results and
+ * signature) and runs Phase 3 on, bank lookup included.
+ *
+ * Each entry is a directory <cache>/<key>/ with links to one job's
+ * outputs. By default <cache> is compile_cache/ next to the job
+ * directories (like question_bank.idx). Because a cached file may be
+ * shared by many jobs, every output writer unlinks the old file before
+ * creating the new one, so rewriting one job's copy never changes the
+ * others.
+ */
+
+#ifndef COMPILE_CACHE_H
+#define COMPILE_CACHE_H
+
+#include <stddef.h>
+
+#define COMPILE_CACHE_VERSION  7  // Bump when the content of any output changes
+#define COMPILE_CACHE_KEY_SIZE 33 // 32 hex digits + NUL
+
+/* --- Compile Cache Functions --- */
+
+// Builds the key for the DSL in [source, source + length) of 'job_dir'.
+// 'options' describes the settings that change the outputs (see job.c).
+// Must be called before the source is parsed: the lexer edits it in place.
+void compile_cache_key(const char* source, size_t length, const char* job_dir,
+                       const char* options, char key[COMPILE_CACHE_KEY_SIZE]);
+
+// Links the outputs cached under 'key' into 'job_dir'. With 'front_end'
+// set only the Phase 1 & 2 outputs and fingerprints.bin are linked (for
+// jobs that check the question bank; their key must differ from the
+// full entries', see job.c).
+// Returns 0 on a hit, -1 if there is no entry or it couldn't be used.
+int compile_cache_fetch(const char* cache_dir, const char* key, const char* job_dir, int front_end);
+
+// Adds the outputs of a finished job under 'key' ('front_end' as for
+// compile_cache_fetch()). Entries appear atomically, so jobs racing on
+// the same key are fine.
+// Returns 0 on success, -1 on error.
+int compile_cache_store(const char* cache_dir, const char* key, const char* job_dir, int front_end);
+
+#endif // COMPILE_CACHE_H
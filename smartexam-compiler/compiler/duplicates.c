@@ -0,0 +1,182 @@
+/*
+ * compiler/duplicates.c
+ * MinHash signatures and LSH bucketing (see duplicates.h).
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "duplicates.h"
+
+/* --- Hashing --- */
+
+// splitmix64: turns a counter into well-mixed 64-bit values
+static uint64_t mix64(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+static uint64_t hash_bytes(const unsigned char* p, size_t len) {
+    uint64_t h = 14695981039346656037ull; // FNV-1a
+    for (size_t i = 0; i < len; i++) {
+        h ^= p[i];
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+// Slot i of a signature uses h_i(x) = (a_i * x + b_i) >> 32, a cheap
+// universal hash family. The constants are fixed so signatures are
+// comparable across runs (and across jobs).
+static void hash_params(uint64_t* a, uint64_t* b) {
+    for (int i = 0; i < MINHASH_SIZE; i++) {
+        a[i] = mix64(2 * (uint64_t)i) | 1; // Must be odd
+        b[i] = mix64(2 * (uint64_t)i + 1);
+    }
+}
+
+// Lower-case letters and digits; every other run of bytes becomes one space
+static size_t normalize(const char* text, size_t len, unsigned char* out) {
+    size_t n = 0;
+    for (size_t i = 0; i < len; i++) {
+        unsigned char c = (unsigned char)text[i];
+        if (c >= 'A' && c <= 'Z') c = (unsigned char)(c - 'A' + 'a');
+        if ((c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c >= 0x80) {
+            out[n++] = c;
+        } else if (n > 0 && out[n - 1] != ' ') {
+            out[n++] = ' ';
+        }
+    }
+    if (n > 0 && out[n - 1] == ' ') n--;
+    return n;
+}
+
+static void compute(MinHash* sig, const char* text, size_t len,
+                    const uint64_t* a, const uint64_t* b, unsigned char* scratch) {
+    for (int i = 0; i < MINHASH_SIZE; i++) {
+        sig->slot[i] = UINT32_MAX;
+    }
+
+    size_t n = normalize(text, len, scratch);
+    if (n == 0) return; // Empty text: all slots stay UINT32_MAX
+
+    size_t shingles = n >= SHINGLE_LENGTH ? n - SHINGLE_LENGTH + 1 : 1;
+    size_t width = n >= SHINGLE_LENGTH ? SHINGLE_LENGTH : n;
+    for (size_t s = 0; s < shingles; s++) {
+        uint64_t x = hash_bytes(scratch + s, width);
+        for (int i = 0; i < MINHASH_SIZE; i++) {
+            uint32_t h = (uint32_t)((a[i] * x + b[i]) >> 32);
+            if (h < sig->slot[i]) sig->slot[i] = h;
+        }
+    }
+}
+
+/* --- Duplicate Detection Functions --- */
+
+void minhash_compute(MinHash* sig, const char* text, size_t len) {
+    uint64_t a[MINHASH_SIZE], b[MINHASH_SIZE];
+    hash_params(a, b);
+
+    unsigned char small[1024];
+    unsigned char* scratch = len <= sizeof(small) ? small : (unsigned char*)malloc(len);
+    if (scratch == NULL) {
+        memset(sig, 0xFF, sizeof(*sig)); // Treated like an empty text
+        return;
+    }
+    compute(sig, text, len, a, b, scratch);
+    if (scratch != small) free(scratch);
+}
+
+double minhash_similarity(const MinHash* a, const MinHash* b) {
+    int same = 0;
+    for (int i = 0; i < MINHASH_SIZE; i++) {
+        same += a->slot[i] == b->slot[i];
+    }
+    return (double)same / MINHASH_SIZE;
+}
+
+int minhash_store(QuestionStore* store, Arena* arena) {
+    int n = store->count;
+    uint32_t longest = 0;
+    for (int i = 0; i < n; i++) {
+        if (!store->reused[i] && store->text_length[i] > longest) longest = store->text_length[i];
+    }
+    unsigned char* scratch = (unsigned char*)arena_alloc(arena, (size_t)longest + 1);
+    if (scratch == NULL) return -1;
+
+    uint64_t a[MINHASH_SIZE], b[MINHASH_SIZE];
+    hash_params(a, b);
+    for (int i = 0; i < n; i++) {
+        if (store->reused[i]) continue; // Signature saved by the last compile
+        compute(&store->signature[i], store->text + store->text_offset[i], store->text_length[i],
+                a, b, scratch);
+    }
+    return 0;
+}
+
+/* --- LSH Buckets --- */
+
+// One open-addressing table holds the buckets of all bands; a bucket
+// is every entry with the same key.
+typedef struct BucketEntry {
+    uint64_t key;   // Hash of (band, band values)
+    int question;   // -1 = empty slot
+} BucketEntry;
+
+uint64_t minhash_band_key(const MinHash* sig, int band) {
+    const unsigned char* rows = (const unsigned char*)&sig->slot[band * LSH_ROWS];
+    return mix64(hash_bytes(rows, sizeof(uint32_t) * LSH_ROWS) ^ (uint64_t)band);
+}
+
+static int is_empty(const MinHash* sig) {
+    return sig->slot[0] == UINT32_MAX && sig->slot[1] == UINT32_MAX;
+}
+
+int find_duplicates(const MinHash* sigs, int count, Arena* arena, int* duplicate_of) {
+    // Every original question goes into LSH_BANDS buckets; keep the
+    // table at most half full
+    size_t slots = 16;
+    while (slots < (size_t)count * LSH_BANDS * 2) slots *= 2;
+    BucketEntry* table = (BucketEntry*)arena_alloc(arena, sizeof(BucketEntry) * slots);
+    if (table == NULL) return -1;
+    for (size_t i = 0; i < slots; i++) {
+        table[i].question = -1;
+    }
+    size_t mask = slots - 1;
+
+    int duplicates = 0;
+    for (int i = 0; i < count; i++) {
+        duplicate_of[i] = -1;
+        if (is_empty(&sigs[i])) continue;
+
+        uint64_t keys[LSH_BANDS];
+        for (int band = 0; band < LSH_BANDS; band++) {
+            keys[band] = minhash_band_key(&sigs[i], band);
+        }
+
+        // Compare only with earlier questions sharing a bucket
+        for (int band = 0; band < LSH_BANDS && duplicate_of[i] < 0; band++) {
+            for (size_t s = keys[band] & mask; table[s].question >= 0; s = (s + 1) & mask) {
+                if (table[s].key != keys[band]) continue;
+                int j = table[s].question;
+                if (minhash_similarity(&sigs[i], &sigs[j]) >= DUPLICATE_THRESHOLD) {
+                    duplicate_of[i] = j;
+                    break;
+                }
+            }
+        }
+        if (duplicate_of[i] >= 0) {
+            duplicates++;
+            continue; // Only originals are bucketed, so chains stay short
+        }
+
+        for (int band = 0; band < LSH_BANDS; band++) {
+            size_t s = keys[band] & mask;
+            while (table[s].question >= 0) s = (s + 1) & mask;
+            table[s].key = keys[band];
+            table[s].question = i;
+        }
+    }
+    return duplicates;
+}
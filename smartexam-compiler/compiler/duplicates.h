@@ -0,0 +1,56 @@
+/*
+ * compiler/duplicates.h
+ * Near-duplicate question detection (MinHash + LSH).
+ *
+ * Each question's normalized text is cut into overlapping 5-character
+ * shingles and summarized by a MinHash signature: for two questions the
+ * fraction of equal signature slots estimates how many shingles they
+ * share (Jaccard similarity). Signatures are then split into bands and
+ * hashed into buckets (locality-sensitive hashing), so only questions
+ * that land in a common bucket are compared. The whole pass is roughly
+ * linear in the number of questions instead of comparing every pair.
+ */
+
+#ifndef DUPLICATES_H
+#define DUPLICATES_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "arena.h"
+#include "question_store.h"
+
+#define MINHASH_SIZE   64  // Slots per signature
+#define LSH_BANDS      16  // MINHASH_SIZE = LSH_BANDS * LSH_ROWS
+#define LSH_ROWS       4
+#define SHINGLE_LENGTH 5
+
+// Questions at least this similar (estimated Jaccard) are duplicates
+#define DUPLICATE_THRESHOLD 0.6
+
+typedef struct MinHash {
+    uint32_t slot[MINHASH_SIZE];
+} MinHash;
+
+/* --- Duplicate Detection Functions --- */
+
+// Signature of one text. Case, punctuation and spacing are ignored.
+void minhash_compute(MinHash* sig, const char* text, size_t len);
+
+// Estimated Jaccard similarity of two signatures (0.0 - 1.0)
+double minhash_similarity(const MinHash* a, const MinHash* b);
+
+// LSH bucket key of one band of a signature (0 <= band < LSH_BANDS).
+// Stable across runs, so keys can be stored on disk.
+uint64_t minhash_band_key(const MinHash* sig, int band);
+
+// Fills in store->signature for every question that wasn't reused from
+// the last compile (see incremental.h). Returns 0, or -1 if out of memory.
+int minhash_store(QuestionStore* store, Arena* arena);
+
+// Finds near-duplicates among 'count' signatures. duplicate_of[i] is set
+// to the index of the earlier question that i repeats, or -1. The first
+// occurrence of a question is never marked.
+// Returns the number of duplicates, or -1 if out of memory.
+int find_duplicates(const MinHash* sigs, int count, Arena* arena, int* duplicate_of);
+
+#endif // DUPLICATES_H
@@ -0,0 +1,358 @@
+/*
+ * compiler/incremental.c
+ * Reuses the unchanged questions of a job's last compile
+ * (see incremental.h).
+ */
+
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "incremental.h"
+#include "ast_helpers.h"
+#include "syllabus.h"
+
+#define FINGERPRINT_FILE "fingerprints.bin"
+
+/* --- External Functions --- */
+
+// From lexer.l (lex.yy.c)
+QuestionNode* lexer_parse_question(JobContext* job, size_t start, size_t end, int line);
+void lexer_log_tokens(JobContext* job, const TokenRecord* tokens, size_t count);
+
+/* --- Helpers --- */
+
+static uint64_t hash_bytes(const char* data, size_t len) {
+    uint64_t h = 14695981039346656037ull; // FNV-1a
+    for (size_t i = 0; i < len; i++) {
+        h ^= (unsigned char)data[i];
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+// The syllabus file Phase 3 will read, hashed. 0 if it can't be read
+// (Phase 3 then uses the built-in topics).
+static uint64_t syllabus_hash(const char* path, const char* job_dir) {
+    SourceBuffer file;
+    if (syllabus_open_file(&file, path, job_dir) != 0) return 0;
+    uint64_t h = hash_bytes(file.data, file.length);
+    source_close(&file);
+    return h;
+}
+
+// Whether saved tokens are known kinds and lie inside a part of the
+// source 'length' bytes long (the token logs copy their values from it)
+static int tokens_fit(const TokenRecord* tokens, size_t count, uint64_t length) {
+    for (size_t i = 0; i < count; i++) {
+        if (tokens[i].kind >= TOK_KIND_COUNT || (uint64_t)tokens[i].offset + tokens[i].length > length) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// Reads and checks job_dir/fingerprints.bin. Returns 0 on success.
+// (Syllabus units are checked against the syllabus in Phase 3.)
+static int load_fingerprints(IncrementalState* s, const char* job_dir) {
+    char path[PATH_MAX];
+    if (source_path(path, sizeof(path), job_dir, FINGERPRINT_FILE) != 0) return -1;
+    FILE* in = fopen(path, "rb");
+    if (in == NULL) return -1; // First compile of this job
+    fseek(in, 0, SEEK_END);
+    long size = ftell(in);
+    fseek(in, 0, SEEK_SET);
+    char* data = size >= (long)sizeof(FingerprintHeader) ? (char*)malloc((size_t)size) : NULL;
+    int ok = data != NULL && fread(data, 1, (size_t)size, in) == (size_t)size;
+    fclose(in);
+    if (!ok) {
+        free(data);
+        return -1;
+    }
+
+    const FingerprintHeader* h = (const FingerprintHeader*)data;
+    size_t records = sizeof(FingerprintHeader);
+    size_t tokens = records + sizeof(FingerprintRecord) * (size_t)h->question_count;
+    size_t units = tokens + sizeof(TokenRecord) * (size_t)h->token_count;
+    size_t end = units + sizeof(uint16_t) * (size_t)h->unit_count;
+    ok = memcmp(h->magic, FINGERPRINT_MAGIC, 4) == 0 && h->version == FINGERPRINT_VERSION &&
+         end == (size_t)size &&
+         (size_t)h->prefix_tokens + h->suffix_tokens <= h->token_count;
+    const FingerprintRecord* r = (const FingerprintRecord*)(data + records);
+    const TokenRecord* t = (const TokenRecord*)(data + tokens);
+    for (uint32_t i = 0; ok && i < h->question_count; i++) {
+        ok = (size_t)r[i].token_first + r[i].token_count <= h->token_count &&
+             (size_t)r[i].unit_first + r[i].unit_count <= h->unit_count &&
+             (size_t)r[i].text_offset + r[i].text_length < r[i].length &&
+             tokens_fit(t + r[i].token_first, r[i].token_count, r[i].length);
+    }
+    ok = ok && tokens_fit(t, h->prefix_tokens, h->prefix_length) &&
+         tokens_fit(t + h->token_count - h->suffix_tokens, h->suffix_tokens, h->suffix_length);
+    if (!ok) {
+        fprintf(stderr, "Warning: Ignoring damaged %s\n", path);
+        free(data);
+        return -1;
+    }
+
+    s->old = data;
+    s->old_header = h;
+    s->old_records = r;
+    s->old_tokens = t;
+    s->old_units = (const uint16_t*)(data + units);
+    return 0;
+}
+
+// Adds saved tokens, moving them to 'offset' and 'line'
+static void add_saved_tokens(IncrementalState* s, const TokenRecord* tokens, size_t count,
+                             size_t offset, int line) {
+    for (size_t i = 0; i < count; i++) {
+        token_list_add(&s->tokens, (TokenKind)tokens[i].kind, (uint32_t)((int)tokens[i].line + line),
+                       (uint32_t)(tokens[i].offset + offset), tokens[i].length);
+    }
+}
+
+// Saved tokens are stored relative to their part of the source
+static void relative_token(TokenRecord* out, const TokenRecord* t, size_t offset, int line) {
+    *out = *t;
+    out->offset = (uint32_t)(t->offset - offset);
+    out->line = (uint32_t)((int)t->line - line);
+}
+
+/* --- Incremental Functions --- */
+
+int incremental_begin(JobContext* job) {
+    IncrementalState* s = (IncrementalState*)arena_alloc(&job->arena, sizeof(IncrementalState));
+    if (s == NULL) return -1;
+    memset(s, 0, sizeof(*s));
+    if (source_split_blocks(job->source.data, job->source.length, &s->split, &job->arena) != 0) {
+        return -1; // The lexer and the parser will tell what is wrong
+    }
+    load_fingerprints(s, job->job_dir);
+    job->incremental = s;
+    job->token_capture = &s->tokens;
+    return 0;
+}
+
+int incremental_parse(JobContext* job) {
+    IncrementalState* s = job->incremental;
+    const FingerprintHeader* h = s->old_header;
+    const SourceBlocks* split = &s->split;
+    char* data = job->source.data;
+    s->tokens.count = 0;
+    s->reused = NULL;
+    s->reused_count = 0;
+
+    // --- 1. Same header, same end, same syllabus? ---
+    if (h == NULL || h->prefix_length != split->prefix_end || h->prefix_hash != split->prefix_hash ||
+        h->suffix_length != job->source.length - split->suffix_start ||
+        h->suffix_hash != split->suffix_hash ||
+        (size_t)h->subject_offset + h->subject_length >= split->prefix_end ||
+        (size_t)h->syllabus_offset + h->syllabus_length >= split->prefix_end) {
+        return -1;
+    }
+    char path[PATH_MAX];
+    if (h->syllabus_length >= sizeof(path)) return -1;
+    memcpy(path, data + h->syllabus_offset, h->syllabus_length);
+    path[h->syllabus_length] = '\0';
+    if (syllabus_hash(path, job->job_dir) != h->syllabus_hash) return -1;
+
+    // --- 2. Find each block's old record by its hash ---
+    // (so questions that only moved are reused too)
+    size_t slots = 16;
+    while (slots < (size_t)h->question_count * 2) slots *= 2;
+    int* table = (int*)arena_alloc(&job->arena, sizeof(int) * slots); // Record + 1, 0 = empty
+    s->reused = (int*)arena_alloc(&job->arena, sizeof(int) * (split->count > 0 ? split->count : 1));
+    if (table == NULL || s->reused == NULL) return -1;
+    memset(table, 0, sizeof(int) * slots);
+    for (uint32_t r = 0; r < h->question_count; r++) {
+        size_t slot = s->old_records[r].hash & (slots - 1);
+        while (table[slot] != 0) slot = (slot + 1) & (slots - 1);
+        table[slot] = (int)r + 1;
+    }
+
+    // --- 3. Rebuild the questions, lexing only the changed blocks ---
+    add_saved_tokens(s, s->old_tokens, h->prefix_tokens, 0, 0);
+    QuestionList list;
+    init_question_list(&list);
+    for (int b = 0; b < split->count; b++) {
+        const SourceBlock* block = &split->blocks[b];
+        int found = -1;
+        for (size_t slot = block->hash & (slots - 1); table[slot] != 0; slot = (slot + 1) & (slots - 1)) {
+            const FingerprintRecord* r = &s->old_records[table[slot] - 1];
+            if (r->hash == block->hash && r->length == block->end - block->start) {
+                found = table[slot] - 1;
+                break;
+            }
+        }
+
+        QuestionNode* node;
+        if (found >= 0) {
+            const FingerprintRecord* r = &s->old_records[found];
+            char* text = data + block->start + r->text_offset;
+            text[r->text_length] = '\0'; // The closing quote, as the lexer does
+            node = create_question_node(&job->arena, text, r->marks);
+            add_saved_tokens(s, s->old_tokens + r->token_first, r->token_count,
+                             block->start, block->line);
+            s->reused_count++;
+        } else {
+            node = lexer_parse_question(job, block->start, block->end, block->line);
+        }
+        if (node == NULL) {
+            s->reused = NULL;
+            return -1;
+        }
+        s->reused[b] = found;
+        append_question(&list, node);
+    }
+    add_saved_tokens(s, s->old_tokens + h->token_count - h->suffix_tokens, h->suffix_tokens,
+                     split->suffix_start, split->suffix_line);
+    if (s->tokens.failed) {
+        s->reused = NULL;
+        return -1;
+    }
+
+    // --- 4. The header is unchanged, so its values are the saved ones ---
+    data[h->subject_offset + h->subject_length] = '\0';
+    data[h->syllabus_offset + h->syllabus_length] = '\0';
+    ASTNode* root = create_ast_node(&job->arena, data + h->subject_offset, h->total_marks,
+                                    h->total_time, data + h->syllabus_offset, NULL);
+    if (root == NULL) {
+        s->reused = NULL;
+        return -1;
+    }
+    root->questions = list.head;
+    root->question_count = list.count;
+    job->root = root;
+
+    // Token logs linked from the compile cache already hold these tokens
+    if (s->reused_count < split->count) job->front_end_cached = 0;
+    if (!job->front_end_cached) lexer_log_tokens(job, s->tokens.tokens, s->tokens.count);
+    return 0;
+}
+
+void incremental_apply(JobContext* job) {
+    IncrementalState* s = job->incremental;
+    if (s == NULL || s->reused == NULL) return; // Parsed in full
+    QuestionStore* store = &job->store;
+    for (int i = 0; i < store->count && i < s->split.count; i++) {
+        if (s->reused[i] < 0) continue;
+        const FingerprintRecord* r = &s->old_records[s->reused[i]];
+        store->difficulty[i] = r->difficulty;
+        store->crispness[i] = r->crispness;
+        store->unit_count[i] = r->unit_count;
+        store->units[i] = s->old_units + r->unit_first;
+        store->signature[i] = r->signature;
+        store->reused[i] = 1;
+    }
+}
+
+int incremental_save(JobContext* job) {
+    IncrementalState* s = job->incremental;
+    const SourceBlocks* split = &s->split;
+    const QuestionStore* store = &job->store;
+    const char* data = job->source.data;
+    const ASTNode* root = job->root;
+    if (s->tokens.failed || root == NULL || store->count != split->count) {
+        return -1; // The split and the parser disagree: nothing safe to save
+    }
+
+    FingerprintHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, FINGERPRINT_MAGIC, 4);
+    h.version = FINGERPRINT_VERSION;
+    h.question_count = (uint32_t)store->count;
+    h.token_count = (uint32_t)s->tokens.count;
+    h.suffix_line = (uint32_t)split->suffix_line;
+    h.prefix_length = split->prefix_end;
+    h.prefix_hash = split->prefix_hash;
+    h.suffix_length = job->source.length - split->suffix_start;
+    h.suffix_hash = split->suffix_hash;
+    h.syllabus_hash = syllabus_hash(root->syllabus_path, job->job_dir);
+    h.subject_offset = (uint32_t)(root->subject - data);
+    h.subject_length = (uint32_t)strlen(root->subject);
+    h.syllabus_offset = (uint32_t)(root->syllabus_path - data);
+    h.syllabus_length = (uint32_t)strlen(root->syllabus_path);
+    h.total_marks = root->total_marks;
+    h.total_time = root->total_time;
+    for (int i = 0; i < store->count; i++) {
+        h.unit_count += store->unit_count[i];
+    }
+
+    FingerprintRecord* records = (FingerprintRecord*)calloc(store->count > 0 ? store->count : 1,
+                                                            sizeof(FingerprintRecord));
+    TokenRecord* tokens = (TokenRecord*)malloc(sizeof(TokenRecord) * (s->tokens.count + 1));
+    uint16_t* units = (uint16_t*)malloc(sizeof(uint16_t) * (h.unit_count + 1));
+    int ok = records != NULL && tokens != NULL && units != NULL;
+
+    // Cut the token list into prefix, blocks and suffix
+    size_t t = 0;
+    while (ok && t < s->tokens.count && s->tokens.tokens[t].offset < split->prefix_end) {
+        relative_token(&tokens[t], &s->tokens.tokens[t], 0, 0);
+        t++;
+    }
+    h.prefix_tokens = (uint32_t)t;
+    uint32_t unit = 0;
+    for (int i = 0; ok && i < store->count; i++) {
+        const SourceBlock* block = &split->blocks[i];
+        FingerprintRecord* r = &records[i];
+        r->hash = block->hash;
+        r->length = (uint32_t)(block->end - block->start);
+        r->token_first = (uint32_t)t;
+        while (t < s->tokens.count && s->tokens.tokens[t].offset < block->end) {
+            ok &= s->tokens.tokens[t].offset >= block->start;
+            relative_token(&tokens[t], &s->tokens.tokens[t], block->start, block->line);
+            t++;
+        }
+        r->token_count = (uint32_t)t - r->token_first;
+        const char* text = store->nodes[i]->text;
+        ok &= text >= data + block->start && text < data + block->end;
+        r->text_offset = (uint32_t)(text - data - block->start);
+        r->text_length = store->text_length[i];
+        r->marks = store->marks[i];
+        r->unit_first = unit;
+        r->unit_count = store->unit_count[i];
+        if (r->unit_count > 0) memcpy(units + unit, store->units[i], sizeof(uint16_t) * r->unit_count);
+        unit += r->unit_count;
+        r->difficulty = store->difficulty[i];
+        r->crispness = store->crispness[i];
+        r->signature = store->signature[i];
+    }
+    h.suffix_tokens = (uint32_t)(s->tokens.count - t);
+    for (; ok && t < s->tokens.count; t++) {
+        ok &= s->tokens.tokens[t].offset >= split->suffix_start;
+        relative_token(&tokens[t], &s->tokens.tokens[t], split->suffix_start, split->suffix_line);
+    }
+
+    // Written under a temporary name, then renamed over the old file
+    // (which may be a link into the compile cache)
+    char path[PATH_MAX], tmp_path[PATH_MAX];
+    ok &= source_path(path, sizeof(path), job->job_dir, FINGERPRINT_FILE) == 0 &&
+          source_path(tmp_path, sizeof(tmp_path), job->job_dir, FINGERPRINT_FILE ".tmp") == 0;
+    FILE* out = ok ? fopen(tmp_path, "wb") : NULL;
+    if (out != NULL) {
+        fwrite(&h, sizeof(h), 1, out);
+        fwrite(records, sizeof(FingerprintRecord), store->count, out);
+        fwrite(tokens, sizeof(TokenRecord), s->tokens.count, out);
+        fwrite(units, sizeof(uint16_t), h.unit_count, out);
+        ok = !ferror(out);
+        if (fclose(out) != 0) ok = 0;
+        if (ok && rename(tmp_path, path) != 0) ok = 0;
+        if (!ok) unlink(tmp_path);
+    } else {
+        ok = 0;
+    }
+    free(records);
+    free(tokens);
+    free(units);
+    return ok ? 0 : -1;
+}
+
+void incremental_end(JobContext* job) {
+    IncrementalState* s = job->incremental;
+    if (s == NULL) return;
+    token_list_free(&s->tokens);
+    free(s->old);
+    job->incremental = NULL;
+    job->token_capture = NULL;
+}
@@ -0,0 +1,127 @@
+/*
+ * compiler/incremental.h
+ * Incremental recompilation: only changed questions are lexed and
+ * analyzed again.
+ *
+ * Reviewers often edit one or two questions and resubmit. After each
+ * compile a job keeps fingerprints.bin next to its other outputs. For
+ * every [QUESTION] block (see blocks.h) it holds a hash of the block's
+ * bytes, the block's tokens (relative to the block) and what Phase 3
+ * worked out from that question alone: difficulty, crispness, syllabus
+ * units and MinHash signature.
+ *
+ * On the next compile, if the header, the syllabus file and the end of
+ * the file are unchanged, every block with a known hash is rebuilt from
+ * that file. Only new or edited blocks go through the lexer and the
+ * per-question analysis. The token logs are written from the merged
+ * token list. The checks that compare questions with each other
+ * (duplicates, question bank) and the paper totals still run over all
+ * questions: they only read the store's columns. Anything unexpected
+ * (a block that isn't one well-formed question, say) falls back to a
+ * full compile, which reports errors as usual. So does a damaged file;
+ * saved units that the syllabus doesn't have are caught in Phase 3, which
+ * then analyzes every question again.
+ *
+ * Layout (native byte order, sections 8-byte aligned):
+ *     FingerprintHeader
+ *     FingerprintRecord[question_count]
+ *     TokenRecord[token_count]    prefix tokens, then each block's, then the suffix's
+ *     uint16_t[unit_count]        syllabus units of every question
+ */
+
+#ifndef INCREMENTAL_H
+#define INCREMENTAL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "blocks.h"
+#include "duplicates.h"
+#include "job.h"
+#include "token_stream.h"
+
+#define FINGERPRINT_MAGIC   "QFPR"
+#define FINGERPRINT_VERSION 2 // Bump whenever the lexer or a Phase 3 rule changes
+
+typedef struct FingerprintHeader {
+    char magic[4];           // "QFPR"
+    uint32_t version;        // FINGERPRINT_VERSION
+    uint32_t question_count;
+    uint32_t token_count;
+    uint32_t unit_count;
+    uint32_t prefix_tokens;  // Tokens before the first block
+    uint32_t suffix_tokens;  // Tokens after the last block
+    uint32_t suffix_line;    // Line the suffix starts on
+    uint64_t prefix_length;  // The prefix and suffix must not have changed
+    uint64_t prefix_hash;
+    uint64_t suffix_length;
+    uint64_t suffix_hash;
+    uint64_t syllabus_hash;  // FNV-1a of the syllabus file (0: built-in topics)
+    // Header values (the header is in the prefix, so offsets are absolute)
+    uint32_t subject_offset;
+    uint32_t subject_length;
+    uint32_t syllabus_offset;
+    uint32_t syllabus_length;
+    int32_t total_marks;
+    int32_t total_time;
+} FingerprintHeader;
+
+typedef struct FingerprintRecord {
+    uint64_t hash;           // FNV-1a of the block (SourceBlock.hash)
+    uint32_t length;         // Block length in bytes
+    uint32_t token_first;    // The block's tokens: lines and offsets are
+    uint32_t token_count;    // relative to the block's first line/byte
+    uint32_t text_offset;    // Q_TEXT value, relative to the block
+    uint32_t text_length;
+    int32_t marks;
+    uint32_t unit_first;     // Syllabus units the text mentions
+    uint16_t unit_count;
+    uint8_t difficulty;      // A Difficulty
+    uint8_t crispness;       // Crispness code (semantic.c)
+    MinHash signature;
+} FingerprintRecord;
+
+// Per-job state, from incremental_begin() to incremental_end()
+typedef struct IncrementalState {
+    SourceBlocks split;        // Blocks of the current source
+
+    // Every token of this compile in source order (absolute lines and
+    // offsets). The lexer appends to it (job->token_capture points here);
+    // fingerprints.bin is cut from it.
+    TokenList tokens;
+
+    // The previous compile's fingerprints.bin (NULL if there was none)
+    char* old;
+    const FingerprintHeader* old_header;
+    const FingerprintRecord* old_records;
+    const TokenRecord* old_tokens;
+    const uint16_t* old_units;
+
+    int* reused;               // reused[i]: old record of question i, or -1
+    int reused_count;
+} IncrementalState;
+
+/* --- Incremental Functions --- */
+
+// Splits the source (which must not have been lexed yet) and loads the
+// job's last fingerprints. Returns 0 on success, -1 if this job can't be
+// compiled incrementally (then job->incremental stays NULL).
+int incremental_begin(JobContext* job);
+
+// Phases 1 & 2 from the fingerprints: builds job->root, lexing only the
+// changed blocks, and writes the token logs. Returns 0 on success, -1 if
+// a full parse is needed. The source buffer may have been edited by then,
+// so the caller has to reload it before parsing it in full.
+int incremental_parse(JobContext* job);
+
+// Copies the saved Phase 3 results of unchanged questions into the
+// store (sets store->reused) so Phase 3 can skip them
+void incremental_apply(JobContext* job);
+
+// Writes job_dir/fingerprints.bin after a successful Phase 3.
+// Returns 0 on success, -1 on error.
+int incremental_save(JobContext* job);
+
+// Frees the state (job_cleanup() calls this)
+void incremental_end(JobContext* job);
+
+#endif // INCREMENTAL_H
@@ -0,0 +1,43 @@
+/*
+ * compiler/ir.c
+ * Phase 4: builds the IR of a paper (see ir.h).
+ */
+
+#include "ir.h"
+
+// Fewest marks a question of each difficulty keeps (indexed by Difficulty)
+static const int min_marks_for[DIFFICULTY_COUNT] = { 1, 1, 2, 3 };
+
+int ir_max_change(int value) {
+    int change = value * IR_MAX_CHANGE_PERCENT / 100;
+    return change > 1 ? change : 1;
+}
+
+IR_List* run_phase_4_ir_gen(const ASTNode* root, const QuestionStore* store, Arena* arena) {
+    IR_List* ir = (IR_List*)arena_alloc(arena, sizeof(IR_List));
+    if (ir == NULL) return NULL;
+    int n = store->count;
+    ir->questions = (IRQuestion*)arena_alloc(arena, sizeof(IRQuestion) * (n > 0 ? (size_t)n : 1));
+    if (ir->questions == NULL) return NULL;
+    ir->count = n;
+    ir->target_marks = root->total_marks;
+    ir->target_time = root->total_time;
+    ir->total_marks = question_store_total_marks(store);
+    ir->total_time = question_store_total_time(store);
+
+    for (int i = 0; i < n; i++) {
+        IRQuestion* q = &ir->questions[i];
+        int marks = store->marks[i];
+        int floor = min_marks_for[store->difficulty[i]];
+        q->marks = marks;
+        q->min_marks = marks - ir_max_change(marks);
+        if (q->min_marks < floor) q->min_marks = floor;
+        if (q->min_marks > marks) q->min_marks = marks; // Already below the floor: don't raise it
+        q->max_marks = marks + ir_max_change(marks);
+        q->time = store->estimated_time[i];
+        q->difficulty = store->difficulty[i];
+        q->status = store->status[i];
+        q->topic = store->topic[i];
+    }
+    return ir;
+}
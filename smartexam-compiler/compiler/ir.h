@@ -0,0 +1,51 @@
+/*
+ * compiler/ir.h
+ * Phase 4: a compact intermediate representation (IR) of the paper.
+ *
+ * The optimizer (Phase 5, see optimizer.h) needs no question text, only
+ * numbers. The IR keeps one small fixed-size record per question: its
+ * marks, estimated time, difficulty and topic, and how far the marks may
+ * be moved. It is built from the QuestionStore after Phase 3.
+ */
+
+#ifndef IR_H
+#define IR_H
+
+#include <stdint.h>
+#include "arena.h"
+#include "ast.h"
+#include "question_store.h"
+
+// The optimizer may move a question's marks by at most this much either
+// way (at least 1), and cut its time by at most this much
+#define IR_MAX_CHANGE_PERCENT 50
+
+typedef struct IRQuestion {
+    int marks;          // As in the paper
+    int min_marks;      // The optimizer keeps marks in [min_marks, max_marks]
+    int max_marks;
+    int time;           // Estimated minutes (Phase 3)
+    uint8_t difficulty; // A Difficulty
+    uint8_t status;     // Phase 3 status flag (STATUS_*)
+    uint16_t topic;     // Topic id in the AST's topic table
+} IRQuestion;
+
+typedef struct IR_List {
+    IRQuestion* questions; // One per question, in paper order
+    int count;
+    int target_marks;      // TOTAL_MARKS from the header (<= 0: not given)
+    int target_time;       // TOTAL_TIME from the header (<= 0: not given)
+    long total_marks;      // Sums over the questions
+    long total_time;
+} IR_List;
+
+// Largest move the optimizer may make from 'value'
+int ir_max_change(int value);
+
+/* --- Phase 4 Entry Point --- */
+
+// Builds the IR of 'root' from its store (after Phase 3), in 'arena'.
+// Returns NULL if out of memory.
+IR_List* run_phase_4_ir_gen(const ASTNode* root, const QuestionStore* store, Arena* arena);
+
+#endif // IR_H
@@ -0,0 +1,407 @@
+/*
+ * compiler/job.c
+ * Runs the compiler phases for a single job directory.
+ * main.c calls this once per job; nothing in here touches global state.
+ * libqverifier (qverifier.c) calls the phases one at a time.
+ */
+
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "job.h"
+#include "ast_helpers.h"
+#include "ast_export.h"
+#include "codegen.h"
+#include "compile_cache.h"
+#include "incremental.h"
+#include "ir.h"
+#include "optimizer.h"
+#include "parallel.h"
+#include "semantic.h"
+
+/* --- External Functions --- */
+
+// From lexer.l (lex.yy.c)
+int lexer_init(JobContext* job);
+void lexer_cleanup(JobContext* job);
+
+// From parser.y (y.tab.c)
+int yyparse(void* scanner, JobContext* job);
+
+// "jobs/<uuid>" -> "jobs/<name>": for files shared by all jobs (the
+// question bank and the compile cache). NULL if it doesn't fit in 'buf'.
+static const char* sibling_path(const char* job_dir, const char* name, char* buf, size_t size) {
+    size_t len = strlen(job_dir);
+    while (len > 1 && job_dir[len - 1] == '/') len--;
+    while (len > 0 && job_dir[len - 1] != '/') len--;
+    int n;
+    if (len == 0) {
+        n = snprintf(buf, size, "%s", name); // Job dir is in the cwd
+    } else {
+        n = snprintf(buf, size, "%.*s%s", (int)len, job_dir, name);
+    }
+    return n >= 0 && (size_t)n < size ? buf : NULL;
+}
+
+static const char* job_bank_path(const JobContext* job, char* buf, size_t size) {
+    if (!job->use_bank) return NULL;
+    if (job->bank_path != NULL) return job->bank_path;
+    return sibling_path(job->job_dir, "question_bank.idx", buf, size);
+}
+
+// Reports progress to whoever asked for it (see JobProgressFn)
+static void job_progress(JobContext* job, const char* phase, const char* status, const char* message) {
+    if (job->progress != NULL) {
+        job->progress(job->progress_ctx, phase, status, message);
+    }
+}
+
+/* --- Job Functions --- */
+
+void job_init(JobContext* job, const char* job_dir) {
+    memset(job, 0, sizeof(*job));
+    job->job_dir = job_dir;
+    job->use_mmap = 1;
+    job->token_formats = TOKENS_JSON;
+    job->use_bank = 1;
+    job->use_cache = 1;
+    job->use_incremental = 1;
+    arena_init(&job->arena);
+}
+
+void job_copy_options(JobContext* job, const JobContext* options) {
+    job->use_mmap = options->use_mmap;
+    job->token_formats = options->token_formats;
+    job->use_bank = options->use_bank;
+    job->bank_path = options->bank_path;
+    job->cache = options->cache;
+    job->ast_page = options->ast_page;
+    job->use_cache = options->use_cache;
+    job->cache_dir = options->cache_dir;
+    job->use_incremental = options->use_incremental;
+    job->lex_threads = options->lex_threads;
+    job->use_pdflatex = options->use_pdflatex;
+}
+
+// Maps input.qp, unless a source was loaded already
+static int job_open_source(JobContext* job) {
+    if (job->source.data != NULL) return 0;
+    char input_path[PATH_MAX];
+    if (source_path(input_path, sizeof(input_path), job->job_dir, "input.qp") != 0) {
+        fprintf(stderr, "Fatal Error: Job path too long: %s\n", job->job_dir);
+        job_progress(job, "phase1", "failed", "job path too long");
+        return 1;
+    }
+
+    if (source_open(&job->source, input_path, job->use_mmap) != 0) {
+        fprintf(stderr, "Fatal Error: Cannot open input file %s\n", input_path);
+        job_progress(job, "phase1", "failed", "cannot open input.qp");
+        return 1;
+    }
+    return 0;
+}
+
+// Phases 1 & 2 from the last compile's fingerprints (see incremental.h).
+// Returns 0 if the AST was built this way.
+static int job_parse_incremental(JobContext* job) {
+    if (incremental_begin(job) != 0) return 1;
+    IncrementalState* state = job->incremental;
+    if (incremental_parse(job) == 0) {
+        printf("[%s] Phases 1 & 2 Complete. Re-lexed %d of %d questions.\n",
+               job->job_dir, state->split.count - state->reused_count, state->split.count);
+        job_progress(job, "phase1", "done", "tokens written (unchanged questions reused)");
+        return 0;
+    }
+    // Parse it all after all, from a fresh copy of the source
+    job->root = NULL; // Any half-built nodes are in the arena
+    job->front_end_cached = 0; // The cached token logs and AST files get rewritten
+    state->tokens.count = 0;
+    if (state->old != NULL) source_close(&job->source);
+    return 1;
+}
+
+int job_parse(JobContext* job) {
+    // --- 1. Set up input file ---
+    // The lexer scans this buffer in place, so it must stay open
+    // until we are done with the AST (which points into it).
+    if (job_open_source(job) != 0) return 1;
+
+    // Recompiling a job? Only lex the questions that changed
+    if (job->use_incremental && !job->in_memory && job->incremental == NULL) {
+        if (job_parse_incremental(job) == 0) return 0;
+        if (job_open_source(job) != 0) return 1;
+    }
+
+    // --- 2. Run Phase 1 (Lexer) & Phase 2 (Parser) ---
+
+    // A big paper is lexed and parsed on several threads (parallel.h)
+    int threads = 0;
+    int parallel = parallel_parse(job, &threads);
+    if (parallel == 0) {
+        printf("[%s] Phases 1 & 2 Complete. AST built on %d threads.\n", job->job_dir, threads);
+        job_progress(job, "phase1", "done", "tokens written");
+        return 0;
+    }
+    if (parallel < 0) {
+        fprintf(stderr, "Fatal Error: Out of memory parsing %s\n", job->job_dir);
+        job_progress(job, "phase1", "failed", "out of memory");
+        return 1;
+    }
+
+    // Create this job's scanner and initialize its JSON log
+    if (lexer_init(job) != 0) {
+        fprintf(stderr, "Fatal Error: Cannot start lexer for job %s\n", job->job_dir);
+        job_progress(job, "phase1", "failed", "cannot start lexer");
+        return 1;
+    }
+    printf("[%s] Phases 1 (Lex) & 2 (Parse) running...\n", job->job_dir);
+    job_progress(job, "phase1", "running", "tokenizing and parsing");
+
+    // yyparse() runs the lexer and parser, building the AST in job->root
+    // It will return 0 on success
+    int parse_result = yyparse(job->scanner, job);
+
+    // Finalize the tokens.json log
+    lexer_cleanup(job);
+
+    if (parse_result != 0 || job->root == NULL) {
+        fprintf(stderr, "Fatal Error: Parsing failed for %s. Check syntax of input.qp.\n", job->job_dir);
+        job_progress(job, "phase2", "failed", "syntax error in input.qp");
+        return 1; // Exit with an error
+    }
+
+    printf("[%s] Phases 1 & 2 Complete. AST built successfully.\n", job->job_dir);
+    job_progress(job, "phase1", "done", "tokens written");
+    return 0;
+}
+
+int job_export_ast_page(JobContext* job) {
+    if (job->root == NULL) return 1;
+    AstExportOptions options = { AST_PAGE_SIZE, job->ast_page };
+    if (export_ast_page_file(job->root, job->job_dir, &options) != 0) {
+        fprintf(stderr, "Warning: Could not write page %d of the AST for %s\n", job->ast_page, job->job_dir);
+        return 1;
+    }
+    return 0;
+}
+
+int job_export_ast(JobContext* job) {
+    if (job->root == NULL) return 1;
+    AstExportOptions options = { AST_PAGE_SIZE, job->ast_page };
+    int result;
+    if (job->dot_out != NULL || job->ast_json_out != NULL) {
+        result = export_ast(job->root, job->dot_out, job->ast_json_out, &options);
+    } else {
+        printf("AST Export: Writing ast.dot and ast.json to %s\n", job->job_dir);
+        result = export_ast_files(job->root, job->job_dir, &options);
+    }
+    if (result != 0) {
+        fprintf(stderr, "Warning: Could not write the AST files for %s\n", job->job_dir);
+        job_progress(job, "phase2", "failed", "cannot write ast.dot");
+        return 1;
+    }
+    printf("[%s] Phase 2 (Web Output) Complete. ast.dot generated.\n", job->job_dir);
+    job_progress(job, "phase2", "done", "ast.dot written");
+    return 0;
+}
+
+int job_analyze(JobContext* job) {
+    if (job->root == NULL) return 1;
+    job_progress(job, "phase3", "running", "semantic analysis");
+    // The checks read the columnar store rather than the linked list
+    if (question_store_build(&job->store, job->root, &job->arena) != 0) {
+        fprintf(stderr, "Fatal Error: Out of memory building question store for %s\n", job->job_dir);
+        job_progress(job, "phase3", "failed", "out of memory");
+        return 1;
+    }
+    incremental_apply(job); // Unchanged questions keep their last results
+    char bank_path[PATH_MAX];
+    const char* bank = job_bank_path(job, bank_path, sizeof(bank_path));
+    if (job->use_bank && bank == NULL) {
+        fprintf(stderr, "Warning: Question bank path too long for %s, not checking the bank\n", job->job_dir);
+    }
+    if (run_phase_3_semantic(job->root, &job->store, job->job_dir, job->syllabus_dir, bank,
+                             job->cache, job->report_out) != 0) {
+        fprintf(stderr, "Fatal Error: Phase 3 failed for %s\n", job->job_dir);
+        job_progress(job, "phase3", "failed", "semantic analysis failed");
+        return 1;
+    }
+    if (job->incremental != NULL && incremental_save(job) != 0) {
+        fprintf(stderr, "Warning: Could not write fingerprints.bin for %s\n", job->job_dir);
+    }
+    printf("[%s] Phase 3 (Semantic) Complete. semantic_report.json generated.\n", job->job_dir);
+    job_progress(job, "phase3", "done", "semantic_report.json written");
+    return 0;
+}
+
+int job_optimize(JobContext* job) {
+    if (job->root == NULL) return 1;
+    job_progress(job, "phase45", "running", "rebalancing marks and time");
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    OptimizationPlan plan;
+    IR_List* ir = run_phase_4_ir_gen(job->root, &job->store, &job->arena);
+    if (ir == NULL || run_phase_5_optimize(ir, &plan, &job->arena) != 0) {
+        fprintf(stderr, "Warning: Out of memory in Phases 4 & 5 for %s\n", job->job_dir);
+        job_progress(job, "phase45", "failed", "out of memory");
+        return 1;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    if (write_optimization_log(ir, &plan, job->root, job->job_dir) != 0) {
+        fprintf(stderr, "Warning: Could not write optimization_log.json for %s\n", job->job_dir);
+        job_progress(job, "phase45", "failed", "cannot write optimization_log.json");
+        return 1;
+    }
+    double ms = (end.tv_sec - start.tv_sec) * 1e3 + (end.tv_nsec - start.tv_nsec) / 1e6;
+    printf("[%s] Phases 4 & 5 (IR, Optimizer) Complete. %d rewrites proposed in %.2f ms.\n",
+           job->job_dir, plan.rewrites, ms);
+    job_progress(job, "phase45", "done", "optimization_log.json written");
+    return 0;
+}
+
+int job_generate(JobContext* job) {
+    if (job->root == NULL) return 1;
+    if (job->in_memory) return 0; // In-memory jobs don't print the paper
+    job_progress(job, "phase6", "running", "generating latex");
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    if (run_phase_6_code_gen(job->root, job->job_dir, job->use_pdflatex, &job->arena) != 0) {
+        fprintf(stderr, "Warning: Could not write the LaTeX and PDF documents for %s\n", job->job_dir);
+        job_progress(job, "phase6", "failed", "cannot write the latex and pdf files");
+        return 1;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double ms = (end.tv_sec - start.tv_sec) * 1e3 + (end.tv_nsec - start.tv_nsec) / 1e6;
+    printf("[%s] Phase 6 (Code Generation) Complete. EnhancedPaper and AnalysisReport (.tex, .pdf) written in %.2f ms.\n",
+           job->job_dir, ms);
+    job_progress(job, "phase6", "done", "latex and pdf files written");
+    return 0;
+}
+
+int job_synthesize(JobContext* job, const SynthesisOptions* options) {
+    if (job->root == NULL) return 1;
+    job_progress(job, "synthesis", "running", "assembling a paper from the bank");
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    SynthesizedPaper paper;
+    if (synthesize_paper(&job->store, job->root, options, &paper, &job->arena) != 0) {
+        fprintf(stderr, "Fatal Error: Out of memory in synthesis for %s\n", job->job_dir);
+        job_progress(job, "synthesis", "failed", "out of memory");
+        return 1;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    if (write_synthesis(&paper, &job->store, job->root, job->job_dir) != 0) {
+        fprintf(stderr, "Fatal Error: Could not write synthesis.json for %s\n", job->job_dir);
+        job_progress(job, "synthesis", "failed", "cannot write synthesis.json");
+        return 1;
+    }
+    double ms = (end.tv_sec - start.tv_sec) * 1e3 + (end.tv_nsec - start.tv_nsec) / 1e6;
+    if (paper.status == SYNTH_INFEASIBLE) {
+        if (paper.count > 0) {
+            printf("[%s] Synthesis failed: %d sets would share %d of %d questions (%.2f ms).\n",
+                   job->job_dir, paper.variant_count, paper.max_shared, paper.count, ms);
+            job_progress(job, "synthesis", "failed", "too few questions for that many sets");
+            return 1;
+        }
+        printf("[%s] Synthesis failed: no paper meets the constraints (%d candidates, %d mixes, %.2f ms).\n",
+               job->job_dir, paper.candidates, paper.mixes, ms);
+        job_progress(job, "synthesis", "failed", "no paper meets the constraints");
+        return 1;
+    }
+    printf("[%s] Synthesis Complete. %d questions from %d candidates (%d mixes, %ld nodes, %d threads) in %.2f ms.\n",
+           job->job_dir, paper.count, paper.candidates, paper.mixes, paper.nodes, paper.threads, ms);
+    if (paper.variant_count > 1) {
+        printf("[%s] %d sets written, sharing at most %d questions.\n",
+               job->job_dir, paper.variant_count, paper.max_shared);
+    }
+    job_progress(job, "synthesis", "done",
+                 paper.variant_count > 1 ? "EnhancedPaper_<k>.tex written" : "EnhancedPaper.qp written");
+    return 0;
+}
+
+// Works out the job's cache key and where its entry would be. Returns
+// -1 if the cache folder's path is too long.
+static int job_cache_key(const JobContext* job, char* cache_dir, size_t size,
+                          char key[COMPILE_CACHE_KEY_SIZE]) {
+    // Everything besides the inputs that changes what ends up in the files.
+    // "bank" keeps front-end entries apart from full ones (see job_compile()).
+    char options[128];
+    snprintf(options, sizeof(options), "tokens=%d page=%d pdflatex=%d bank=%d",
+             job->token_formats, job->ast_page, job->use_pdflatex, job->use_bank);
+    compile_cache_key(job->source.data, job->source.length, job->job_dir, options, key);
+
+    if (job->cache_dir != NULL) {
+        int n = snprintf(cache_dir, size, "%s", job->cache_dir);
+        return n >= 0 && (size_t)n < size ? 0 : -1;
+    }
+    return sibling_path(job->job_dir, "compile_cache", cache_dir, size) != NULL ? 0 : -1;
+}
+
+int job_compile(JobContext* job) {
+    printf("Compiler worker started for job: %s\n", job->job_dir);
+
+    // --- 0. An identical paper compiled before? ---
+    // Only for jobs that read input.qp and write their outputs as files.
+    // With the question bank only Phases 1 & 2 come from the cache: the
+    // report depends on what the bank holds now, and Phase 3 must add
+    // this job to it. The AST is rebuilt from the cached fingerprints, so
+    // those jobs need the incremental path.
+    char cache_dir[PATH_MAX], key[COMPILE_CACHE_KEY_SIZE];
+    int front_end = job->use_bank;
+    int cacheable = job->use_cache && job->source.data == NULL && !job->in_memory &&
+                    (!front_end || job->use_incremental);
+    if (cacheable) {
+        if (job_open_source(job) != 0) return 1;
+        // Before the lexer edits the source
+        cacheable = job_cache_key(job, cache_dir, sizeof(cache_dir), key) == 0;
+    }
+    if (cacheable && compile_cache_fetch(cache_dir, key, job->job_dir, front_end) == 0) {
+        if (!front_end) {
+            job->cache_hit = 1;
+            printf("[%s] Outputs reused from compile cache entry %s\n", job->job_dir, key);
+            job_progress(job, "cache", "done", "outputs reused from an identical paper");
+            job_progress(job, "finished", "done", "compile complete");
+            return 0;
+        }
+        job->front_end_cached = 1;
+        printf("[%s] Tokens and AST reused from compile cache entry %s\n", job->job_dir, key);
+        job_progress(job, "cache", "done", "tokens and AST reused from an identical paper");
+    }
+
+    // Cleared again if the cached fingerprints didn't cover every question
+    if (job_parse(job) != 0) return 1;
+
+    // --- 3. Run Phase 2 (Web Output) ---
+    // Not fatal: the report can still be written
+    int exported = job->front_end_cached || job_export_ast(job) == 0;
+
+    // --- 4. Phase 3 (Semantic) ---
+    if (job_analyze(job) != 0) return 1;
+
+    // --- 5. Phases 4 & 5 (IR, Optimizer) ---
+    int optimized = job_optimize(job) == 0; // Not fatal either
+
+    // --- 6. Phase 6 (Code Generation) ---
+    int generated = job_generate(job) == 0; // Not fatal either
+
+    // Front-end entries only need Phases 1 to 3 (fingerprints.bin)
+    int finished = exported && (front_end || (optimized && generated));
+    if (cacheable && !job->front_end_cached && finished &&
+        compile_cache_store(cache_dir, key, job->job_dir, front_end) != 0) {
+        fprintf(stderr, "Warning: Could not add %s to the compile cache\n", job->job_dir);
+    }
+
+    printf("Compiler worker finished for job: %s\n", job->job_dir);
+    job_progress(job, "finished", "done", "compile complete");
+    return 0; // Success!
+}
+
+void job_cleanup(JobContext* job) {
+    incremental_end(job);
+    free_ast(job->root); // Free the memory we allocated
+    job->root = NULL;
+    arena_free(&job->arena); // Also covers a parse that failed half way
+    source_close(&job->source); // Only now: AST strings were views into it
+}
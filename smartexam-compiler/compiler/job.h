@@ -0,0 +1,127 @@
+/*
+ * compiler/job.h
+ * Per-job compiler state.
+ *
+ * Everything one compilation needs (the source buffer, the scanner, the
+ * token log and the AST) lives in a JobContext instead of in globals, so
+ * several jobs can be compiled at the same time on different threads.
+ */
+
+#ifndef JOB_H
+#define JOB_H
+
+#include <stdio.h>
+#include "ast.h"
+#include "arena.h"
+#include "question_store.h"
+#include "semantic.h"
+#include "source.h"
+#include "synthesis.h"
+#include "token_writer.h"
+#include "token_stream.h"
+
+struct IncrementalState; // incremental.h
+
+// Bits for JobContext.token_formats
+#define TOKENS_JSON 1  // tokens.json (what the web UI reads today)
+#define TOKENS_BIN  2  // tokens.bin (see token_stream.h)
+
+// Called as phases start and finish. 'phase' is "phase1", "phase2",
+// "phase3", "phase45" (IR and optimizer), "phase6" (LaTeX), "cache"
+// (outputs reused, see compile_cache.h), "synthesis" (see synthesis.h)
+// or "finished";
+// 'status' is "running", "done" or "failed".
+typedef void (*JobProgressFn)(void* ctx, const char* phase, const char* status,
+                              const char* message);
+
+typedef struct JobContext {
+    const char* job_dir;   // e.g. "jobs/d4a5c68e..."
+    int use_mmap;          // Map input.qp (1) or read it into the heap (0)
+    int token_formats;     // Which token logs to write (TOKENS_* bits)
+    int use_bank;          // Check/update the question bank?
+    const char* bank_path; // NULL: question_bank.idx next to the job dir
+    SemanticCache* cache;  // Warm automata shared between jobs, or NULL
+    JobProgressFn progress; // Optional progress callback
+    void* progress_ctx;
+
+    int ast_page;          // Page of ast.dot/ast.json to expand (see ast_export.h)
+    int use_cache;         // Reuse the outputs of an identical job (compile_cache.h)?
+    const char* cache_dir; // NULL: compile_cache/ next to the job dir
+    int cache_hit;         // Set by job_compile() if the outputs came from the cache
+    int front_end_cached;  // ... or only the tokens and AST (question bank jobs)
+    int use_incremental;   // Only re-lex changed questions (incremental.h)?
+    int lex_threads;       // Threads for Phases 1 & 2 of a big paper (parallel.h); 0: one per core
+    int use_pdflatex;      // Typeset the Phase 6 PDFs with pdflatex (codegen.h)?
+    const char* syllabus_dir; // Set: SYLLABUS_PATH is only read from here (libqverifier)
+
+    // In-memory jobs (libqverifier) never read or write files in job_dir
+    // (fingerprints.bin, the compile cache, the Phase 6 documents);
+    // only the syllabus is read from there
+    int in_memory;
+
+    // In-memory outputs (used by libqverifier). When set, tokens.json,
+    // ast.dot, ast.json and semantic_report.json go to these streams
+    // instead of into job_dir. The job never closes them.
+    FILE* tokens_out;
+    FILE* dot_out;
+    FILE* ast_json_out;
+    FILE* report_out;
+
+    SourceBuffer source;   // input.qp, scanned in place
+    void* scanner;         // The reentrant Flex scanner (a yyscan_t)
+    TokenWriter token_log; // tokens.json
+    int log_tokens;        // Is 'token_log' open?
+    TokenStreamWriter token_bin; // tokens.bin
+    int log_tokens_bin;    // Is 'token_bin' open?
+
+    TokenList* token_capture; // When set, the lexer also appends every token here
+    struct IncrementalState* incremental; // Set while compiling incrementally
+
+    Arena arena;           // Owns the AST (see arena.h)
+    ASTNode* root;         // Set by the parser once the paper is parsed
+    QuestionStore store;   // Columnar copy of root's questions (Phase 3)
+} JobContext;
+
+/* --- Job Functions --- */
+
+// Sets up an empty context for 'job_dir' (nothing is opened yet)
+void job_init(JobContext* job, const char* job_dir);
+
+// Copies the options (use_mmap, token_formats, bank and compile cache
+// settings, cache, ast_page, incremental, lexer threads and pdflatex)
+// from a template context, e.g. one built from the command line
+void job_copy_options(JobContext* job, const JobContext* options);
+
+// Runs all phases for the job and writes its output files, or links in
+// the outputs of an identical earlier job (then job->root stays NULL).
+// Returns 0 on success, 1 on failure. Safe to call from several threads
+// at once as long as each thread has its own JobContext.
+int job_compile(JobContext* job);
+
+// --- The phases one at a time (job_compile() runs all of them) ---
+// Each returns 0 on success, 1 on failure.
+
+// Phases 1 & 2: lexes and parses input.qp into job->root. If job->source
+// is already loaded (e.g. with source_from_memory()), that is parsed
+// instead of input.qp.
+int job_parse(JobContext* job);
+// Writes ast.dot and ast.json (needs job_parse())
+int job_export_ast(JobContext* job);
+// Writes only ast.page<N>.json for job->ast_page (needs job_parse())
+int job_export_ast_page(JobContext* job);
+// Phase 3: semantic checks and semantic_report.json (needs job_parse())
+int job_analyze(JobContext* job);
+// Phases 4 & 5: IR and optimizer, writes optimization_log.json (needs job_analyze())
+int job_optimize(JobContext* job);
+// Phase 6: writes EnhancedPaper and AnalysisReport as .tex and .pdf (needs job_analyze())
+int job_generate(JobContext* job);
+
+// Assembles a new paper from the job's questions (q_compiler --synthesize),
+// writes synthesis.json and EnhancedPaper.qp (needs job_analyze()).
+// Returns 1 if no paper meets the constraints.
+int job_synthesize(JobContext* job, const SynthesisOptions* options);
+
+// Frees the AST and closes the source buffer
+void job_cleanup(JobContext* job);
+
+#endif // JOB_H
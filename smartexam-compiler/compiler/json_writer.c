@@ -0,0 +1,155 @@
+/*
+ * compiler/json_writer.c
+ * Implementation of the streaming JSON writer (see json_writer.h).
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "json_writer.h"
+
+static const char hex_digits[] = "0123456789abcdef";
+
+static void newline_indent(JsonWriter* w) {
+    fputc('\n', w->out);
+    for (int i = 0; i < w->depth; i++) {
+        fputs("  ", w->out);
+    }
+}
+
+// Called before every key or value: writes the comma and indentation
+static void begin_item(JsonWriter* w) {
+    if (w->after_key) {
+        w->after_key = 0; // The value goes on the key's line
+        return;
+    }
+    if (w->depth == 0) return; // Top-level value
+    if (w->count[w->depth] > 0) fputc(',', w->out);
+    w->count[w->depth]++;
+    newline_indent(w);
+}
+
+static void open_container(JsonWriter* w, char c) {
+    begin_item(w);
+    fputc(c, w->out);
+    if (w->depth + 1 < JSON_MAX_DEPTH) {
+        w->depth++;
+        w->count[w->depth] = 0;
+    }
+}
+
+static void close_container(JsonWriter* w, char c) {
+    int empty = w->count[w->depth] == 0;
+    if (w->depth > 0) w->depth--;
+    if (!empty) newline_indent(w); // Empty containers stay as [] / {}
+    fputc(c, w->out);
+}
+
+// Copies runs of plain bytes with fwrite and escapes the rest.
+// Bytes >= 0x80 (UTF-8 sequences) are copied unchanged.
+static void write_escaped(JsonWriter* w, const char* s, size_t len) {
+    const unsigned char* p = (const unsigned char*)s;
+    const unsigned char* end = p + len;
+
+    fputc('"', w->out);
+    while (p < end) {
+        const unsigned char* run = p;
+        while (p < end && *p >= 0x20 && *p != '"' && *p != '\\') {
+            p++;
+        }
+        fwrite(run, 1, (size_t)(p - run), w->out);
+        if (p == end) break;
+
+        switch (*p) {
+            case '"':  fputs("\\\"", w->out); break;
+            case '\\': fputs("\\\\", w->out); break;
+            case '\n': fputs("\\n", w->out); break;
+            case '\r': fputs("\\r", w->out); break;
+            case '\t': fputs("\\t", w->out); break;
+            case '\b': fputs("\\b", w->out); break;
+            case '\f': fputs("\\f", w->out); break;
+            default:
+                fputs("\\u00", w->out);
+                fputc(hex_digits[*p >> 4], w->out);
+                fputc(hex_digits[*p & 0xF], w->out);
+                break;
+        }
+        p++;
+    }
+    fputc('"', w->out);
+}
+
+/* --- Json Writer Functions --- */
+
+int json_writer_open(JsonWriter* w, const char* path) {
+    memset(w, 0, sizeof(*w));
+    unlink(path); // May be a link into the compile cache
+    w->out = fopen(path, "w");
+    if (w->out == NULL) {
+        perror(path);
+        return -1;
+    }
+    // One large buffer: the report is written in a few big blocks
+    w->buf = (char*)malloc(JSON_WRITER_BUFFER_SIZE);
+    if (w->buf != NULL) {
+        setvbuf(w->out, w->buf, _IOFBF, JSON_WRITER_BUFFER_SIZE);
+    }
+    return 0;
+}
+
+int json_writer_open_stream(JsonWriter* w, FILE* out) {
+    memset(w, 0, sizeof(*w));
+    w->out = out;
+    w->borrowed = 1;
+    return out != NULL ? 0 : -1;
+}
+
+int json_writer_close(JsonWriter* w) {
+    if (w->out == NULL) return -1;
+    int failed = ferror(w->out);
+    if ((w->borrowed ? fflush(w->out) : fclose(w->out)) != 0) failed = 1;
+    w->out = NULL;
+    free(w->buf); // Only after fclose: stdio uses it until then
+    w->buf = NULL;
+    if (failed) {
+        perror("Failed to write JSON report");
+        return -1;
+    }
+    return 0;
+}
+
+void json_begin_object(JsonWriter* w) { open_container(w, '{'); }
+void json_end_object(JsonWriter* w) { close_container(w, '}'); }
+void json_begin_array(JsonWriter* w) { open_container(w, '['); }
+void json_end_array(JsonWriter* w) { close_container(w, ']'); }
+
+void json_key(JsonWriter* w, const char* key) {
+    begin_item(w);
+    write_escaped(w, key, strlen(key));
+    fputs(": ", w->out);
+    w->after_key = 1;
+}
+
+void json_string(JsonWriter* w, const char* s) {
+    json_string_n(w, s, strlen(s));
+}
+
+void json_string_n(JsonWriter* w, const char* s, size_t len) {
+    begin_item(w);
+    write_escaped(w, s, len);
+}
+
+void json_int(JsonWriter* w, long value) {
+    begin_item(w);
+    fprintf(w->out, "%ld", value);
+}
+
+void json_double(JsonWriter* w, double value) {
+    begin_item(w);
+    fprintf(w->out, "%.1f", value);
+}
+
+void json_bool(JsonWriter* w, int value) {
+    begin_item(w);
+    fputs(value ? "true" : "false", w->out);
+}
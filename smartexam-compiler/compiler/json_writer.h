@@ -0,0 +1,60 @@
+/*
+ * compiler/json_writer.h
+ * Small streaming JSON writer for the compiler's reports.
+ *
+ * Output is laid out like Python's json.dump(..., indent=2), so files
+ * written here look the same as the ones the Python tools produce.
+ * The writer tracks commas and indentation itself; callers just emit
+ * keys and values in order:
+ *
+ *     json_begin_object(w);
+ *     json_key(w, "marks"); json_int(w, 10);
+ *     json_end_object(w);
+ */
+
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+#include <stdio.h>
+#include <stddef.h>
+
+#define JSON_MAX_DEPTH 32
+#define JSON_WRITER_BUFFER_SIZE (64 * 1024)
+
+typedef struct JsonWriter {
+    FILE* out;
+    int depth;                  // Number of open objects/arrays
+    int count[JSON_MAX_DEPTH];  // Items written so far at each depth
+    int after_key;              // A key was just written; the value follows on the same line
+    char* buf;                  // stdio buffer for 'out'
+    int borrowed;               // 'out' belongs to the caller (only flushed on close)
+} JsonWriter;
+
+/* --- Json Writer Functions --- */
+
+// Creates 'path'. Returns 0 on success, -1 on error.
+int json_writer_open(JsonWriter* w, const char* path);
+
+// Writes to an open stream instead (e.g. from open_memstream()).
+// json_writer_close() only flushes it; the caller closes it.
+int json_writer_open_stream(JsonWriter* w, FILE* out);
+
+// Flushes and closes. Returns 0 if everything was written.
+int json_writer_close(JsonWriter* w);
+
+void json_begin_object(JsonWriter* w);
+void json_end_object(JsonWriter* w);
+void json_begin_array(JsonWriter* w);
+void json_end_array(JsonWriter* w);
+
+// Object member name; the next call writes its value
+void json_key(JsonWriter* w, const char* key);
+
+// --- Values ---
+void json_string(JsonWriter* w, const char* s);
+void json_string_n(JsonWriter* w, const char* s, size_t len); // 's' need not be NUL-terminated
+void json_int(JsonWriter* w, long value);
+void json_double(JsonWriter* w, double value); // One decimal place, like round(x, 1)
+void json_bool(JsonWriter* w, int value);
+
+#endif // JSON_WRITER_H
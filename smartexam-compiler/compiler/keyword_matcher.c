@@ -0,0 +1,184 @@
+/*
+ * compiler/keyword_matcher.c
+ * Aho-Corasick automaton (see keyword_matcher.h).
+ */
+
+#include <string.h>
+#include <ctype.h>
+#include "keyword_matcher.h"
+
+// Letters, digits and UTF-8 bytes count as part of a word
+static int is_word_byte(unsigned char c) {
+    return isalnum(c) || c >= 0x80;
+}
+
+// Whether a match ending at 'end' ends a word: the text goes on with a
+// non-word byte, or with a plural "s" or "es" and then a non-word byte.
+// So "heap" matches "heaps" but not "heapify", and "sort" not "sorted".
+static int ends_word(const unsigned char* p, size_t end, size_t len) {
+    if (end == len || !is_word_byte(p[end]) || !is_word_byte(p[end - 1])) return 1;
+    size_t suffix = 0;
+    if (tolower(p[end]) == 's') {
+        suffix = 1;
+    } else if (tolower(p[end]) == 'e' && end + 1 < len && tolower(p[end + 1]) == 's') {
+        suffix = 2;
+    }
+    return suffix > 0 && (end + suffix == len || !is_word_byte(p[end + suffix]));
+}
+
+/* --- Keyword Matcher Functions --- */
+
+void keyword_matcher_init(KeywordMatcher* m, Arena* arena) {
+    memset(m, 0, sizeof(*m));
+    m->arena = arena;
+}
+
+int keyword_matcher_add(KeywordMatcher* m, const char* word, int value) {
+    size_t len = strlen(word);
+    if (len == 0) return 0;
+
+    KeywordEntry* entry = (KeywordEntry*)arena_alloc(m->arena, sizeof(KeywordEntry));
+    char* copy = arena_strndup(m->arena, word, len);
+    if (entry == NULL || copy == NULL) return -1;
+    for (size_t i = 0; i < len; i++) {
+        copy[i] = (char)tolower((unsigned char)copy[i]);
+    }
+
+    entry->word = copy;
+    entry->length = (int)len;
+    entry->value = value;
+    entry->next = m->words;
+    m->words = entry;
+    m->word_count++;
+    m->total_length += len;
+    return 0;
+}
+
+int keyword_matcher_build(KeywordMatcher* m) {
+    // --- 1. Alphabet: one symbol per distinct (lower-case) keyword byte ---
+    // Both cases of a letter share a symbol, which is all case folding takes.
+    memset(m->symbol, 0, sizeof(m->symbol));
+    m->symbol_count = 1; // Symbol 0: any byte that is in no keyword
+    for (KeywordEntry* e = m->words; e != NULL; e = e->next) {
+        for (int i = 0; i < e->length; i++) {
+            unsigned char c = (unsigned char)e->word[i];
+            if (m->symbol[c] == 0) {
+                m->symbol[c] = (unsigned char)m->symbol_count;
+                m->symbol[toupper(c)] = (unsigned char)m->symbol_count;
+                m->symbol_count++;
+            }
+        }
+    }
+
+    // --- 2. Tables (a trie can't have more states than keyword bytes + 1) ---
+    int k = m->symbol_count;
+    int max_states = (int)m->total_length + 1;
+    m->delta = (int*)arena_alloc(m->arena, sizeof(int) * (size_t)max_states * k);
+    m->output = (int*)arena_alloc(m->arena, sizeof(int) * max_states);
+    m->dict_link = (int*)arena_alloc(m->arena, sizeof(int) * max_states);
+    int* fail = (int*)arena_alloc(m->arena, sizeof(int) * max_states);
+    int* queue = (int*)arena_alloc(m->arena, sizeof(int) * max_states);
+    int words = m->word_count > 0 ? m->word_count : 1;
+    m->lengths = (int*)arena_alloc(m->arena, sizeof(int) * words);
+    m->values = (int*)arena_alloc(m->arena, sizeof(int) * words);
+    if (m->delta == NULL || m->output == NULL || m->dict_link == NULL ||
+        fail == NULL || queue == NULL || m->lengths == NULL || m->values == NULL) {
+        return -1;
+    }
+    memset(m->delta, 0, sizeof(int) * (size_t)max_states * k); // 0 = no edge yet
+    m->output[0] = -1;
+    m->state_count = 1;
+
+    // --- 3. Trie of all keywords. The list is newest first, so walk it
+    // into index order (oldest = 0) to let the first value win. ---
+    int index = m->word_count;
+    for (KeywordEntry* e = m->words; e != NULL; e = e->next) {
+        index--;
+        m->lengths[index] = e->length;
+        m->values[index] = e->value;
+    }
+    index = m->word_count;
+    for (KeywordEntry* e = m->words; e != NULL; e = e->next) {
+        index--;
+        int state = 0;
+        for (int i = 0; i < e->length; i++) {
+            int* edge = &m->delta[state * k + m->symbol[(unsigned char)e->word[i]]];
+            if (*edge == 0) {
+                *edge = m->state_count;
+                m->output[m->state_count] = -1;
+                m->state_count++;
+            }
+            state = *edge;
+        }
+        // Walking newest first, so older keywords overwrite newer ones
+        m->output[state] = index;
+    }
+
+    // --- 4. Failure links (breadth first) and the full transition table ---
+    // Missing edges are filled in from the failure state, which turns the
+    // trie into a DFA: scanning never has to follow failure links.
+    int head = 0, tail = 0;
+    fail[0] = 0;
+    m->dict_link[0] = -1;
+    for (int s = 0; s < k; s++) {
+        int child = m->delta[s];
+        if (child != 0) {
+            fail[child] = 0;
+            m->dict_link[child] = -1;
+            queue[tail++] = child;
+        }
+    }
+    while (head < tail) {
+        int state = queue[head++];
+        for (int s = 0; s < k; s++) {
+            int* edge = &m->delta[state * k + s];
+            int via_fail = m->delta[fail[state] * k + s];
+            if (*edge == 0) {
+                *edge = via_fail;
+            } else {
+                int child = *edge;
+                fail[child] = via_fail;
+                m->dict_link[child] = m->output[via_fail] >= 0 ? via_fail : m->dict_link[via_fail];
+                queue[tail++] = child;
+            }
+        }
+    }
+    return 0;
+}
+
+void keyword_matcher_scan(const KeywordMatcher* m, const char* text, size_t len,
+                          KeywordHitFn fn, void* ctx) {
+    if (m->state_count == 0) return; // Not built (or no keywords)
+
+    const unsigned char* p = (const unsigned char*)text;
+    const int k = m->symbol_count;
+    int state = 0;
+    for (size_t i = 0; i < len; i++) {
+        state = m->delta[state * k + m->symbol[p[i]]];
+
+        // Every keyword ending here: this state's own, then shorter suffixes
+        int s = m->output[state] >= 0 ? state : m->dict_link[state];
+        while (s >= 0) {
+            int id = m->output[s];
+            size_t start = i + 1 - (size_t)m->lengths[id];
+            if ((start == 0 || !is_word_byte(p[start - 1]) || !is_word_byte(p[start])) &&
+                ends_word(p, i + 1, len)) {
+                if (fn(ctx, m->values[id], start, m->lengths[id])) return;
+            }
+            s = m->dict_link[s];
+        }
+    }
+}
+
+static int collect_class(void* ctx, int value, size_t start, int length) {
+    (void)start;
+    (void)length;
+    *(unsigned int*)ctx |= 1u << (value & 31);
+    return 0;
+}
+
+unsigned int keyword_matcher_classes(const KeywordMatcher* m, const char* text, size_t len) {
+    unsigned int classes = 0;
+    keyword_matcher_scan(m, text, len, collect_class, &classes);
+    return classes;
+}
@@ -0,0 +1,73 @@
+/*
+ * compiler/keyword_matcher.h
+ * Multi-keyword search with an Aho-Corasick automaton.
+ *
+ * All keywords are compiled into one state machine, so a text is scanned
+ * once, one table lookup per byte, however many keywords there are.
+ * Matching ignores ASCII case, and a keyword only matches a whole word
+ * or its plural: "state" matches "State" and "states" but not "restate"
+ * or "stated".
+ *
+ * Usage:
+ *     keyword_matcher_init(&m, arena);
+ *     keyword_matcher_add(&m, "explain", MY_CLASS);  // ... more keywords
+ *     keyword_matcher_build(&m);
+ *     unsigned hits = keyword_matcher_classes(&m, text, len);
+ */
+
+#ifndef KEYWORD_MATCHER_H
+#define KEYWORD_MATCHER_H
+
+#include <stddef.h>
+#include "arena.h"
+
+typedef struct KeywordEntry {
+    const char* word;   // Lower-cased copy (in the arena)
+    int length;
+    int value;          // Caller's tag (e.g. a class or topic id)
+    struct KeywordEntry* next;
+} KeywordEntry;
+
+typedef struct KeywordMatcher {
+    Arena* arena;       // All tables are allocated from here
+
+    // --- Keywords added so far (most recent first) ---
+    KeywordEntry* words;
+    int word_count;
+    size_t total_length;
+
+    // --- The automaton (valid after keyword_matcher_build) ---
+    unsigned char symbol[256]; // Byte -> symbol; 0 = not in any keyword
+    int symbol_count;
+    int state_count;
+    int* delta;         // delta[state * symbol_count + symbol] = next state
+    int* output;        // Keyword index ending in 'state', or -1
+    int* dict_link;     // Nearest shorter suffix state with an output, or -1
+    int* lengths;       // Keyword length, by keyword index
+    int* values;        // Keyword value, by keyword index
+} KeywordMatcher;
+
+// Called for every match. 'start' is the byte offset of the match.
+// Return nonzero to stop the scan early.
+typedef int (*KeywordHitFn)(void* ctx, int value, size_t start, int length);
+
+/* --- Keyword Matcher Functions --- */
+
+void keyword_matcher_init(KeywordMatcher* m, Arena* arena);
+
+// Adds a keyword (ASCII; case is ignored). Returns 0, or -1 if out of memory.
+// If the same keyword is added twice, the first value is kept.
+int keyword_matcher_add(KeywordMatcher* m, const char* word, int value);
+
+// Compiles the keywords. Call once, after the last add.
+// Returns 0, or -1 if out of memory.
+int keyword_matcher_build(KeywordMatcher* m);
+
+// Reports every match in text[0..len) to 'fn', in text order
+void keyword_matcher_scan(const KeywordMatcher* m, const char* text, size_t len,
+                          KeywordHitFn fn, void* ctx);
+
+// Bit v is set if a keyword with value v (0-31) occurs in the text
+unsigned int keyword_matcher_classes(const KeywordMatcher* m, const char* text, size_t len);
+
+#endif // KEYWORD_MATCHER_H
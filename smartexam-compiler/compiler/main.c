@@ -1,91 +1,262 @@
-/*
- * compiler/main.c
- * The main driver for the Q-Verifier C/C++ compiler.
- * This is the executable that app.py calls.
- */
-
-#include <stdio.h>
-#include <stdlib.h>
-#include "ast.h"
-#include "ast_helpers.h"
-
-/* --- External Globals & Functions --- */
-
-// From lexer.l (lex.yy.c)
-extern FILE* yyin;
-void lexer_init(const char* job_dir);
-void lexer_cleanup();
-
-// From parser.y (y.tab.c)
-extern int yyparse();
-extern ASTNode* root; // The global pointer to our AST root
-
-// Global path to the job directory
-char* job_dir_path = NULL;
-
-/*
- * Main Entry Point
- * argv[0] will be "./q_compiler"
- * argv[1] will be the path to the job (e.g., "jobs/d4a5c68e...")
- */
-int main(int argc, char *argv[]) {
-    if (argc != 2) {
-        fprintf(stderr, "Usage: %s <path_to_job_directory>\n", argv[0]);
-        return 1;
-    }
-    
-    job_dir_path = argv[1]; // Set global job path
-    printf("Compiler worker started for job: %s\n", job_dir_path);
-
-    // --- 1. Set up input file ---
-    char input_path[1024];
-    sprintf(input_path, "%s/input.qp", job_dir_path);
-
-    yyin = fopen(input_path, "r");
-    if (yyin == NULL) {
-        fprintf(stderr, "Fatal Error: Cannot open input file %s\n", input_path);
-        return 1;
-    }
-
-    // --- 2. Run Phase 1 (Lexer) & Phase 2 (Parser) ---
-    
-    // Initialize the lexer's JSON log
-    lexer_init(job_dir_path);
-    printf("Phases 1 (Lex) & 2 (Parse) running...\n");
-
-    // yyparse() runs the lexer and parser, building the AST
-    // It will return 0 on success
-    int parse_result = yyparse();
-    
-    fclose(yyin); // Close the input file
-    
-    // Finalize the tokens.json log
-    lexer_cleanup();
-
-    if (parse_result != 0 || root == NULL) {
-        fprintf(stderr, "Fatal Error: Parsing failed. Check syntax of input.qp.\n");
-        return 1; // Exit with an error
-    }
-
-    printf("Phases 1 & 2 Complete. AST built successfully.\n");
-
-    // --- 3. Run Phase 2 (Web Output) ---
-    char dot_path[1024];
-    sprintf(dot_path, "%s/ast.dot", job_dir_path);
-    export_ast_to_dot(root, dot_path);
-    printf("Phase 2 (Web Output) Complete. ast.dot generated.\n");
-
-    // --- 4. (STUBS for future phases) ---
-    // run_phase_3_semantic(root, job_dir_path);
-    // IR_List* ir = run_phase_4_ir_gen(root);
-    // run_phase_5_optimize(ir, job_dir_path);
-    // run_phase_6_code_gen(ir, job_dir_path);
-    // printf("Phases 3-6 (STUBS) complete.\n");
-
-
-    // --- 5. Clean up ---
-    free_ast(root); // Free the memory we allocated
-    printf("Compiler worker finished for job: %s\n", job_dir_path);
-
-    return 0; // Success!
-}
\ No newline at end of file
+/*
+ * compiler/main.c
+ * The main driver for the Q-Verifier C/C++ compiler.
+ * This is the executable that app.py calls.
+ */
+
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "batch.h"
+#include "job.h"
+#include "server.h"
+
+static void print_usage(const char* prog) {
+    fprintf(stderr, "Usage: %s [options] <path_to_job_directory> [<path_to_job_directory> ...]\n", prog);
+    fprintf(stderr, "       %s --export-tokens <path_to_job_directory>\n", prog);
+    fprintf(stderr, "       %s --export-ast --ast-page=N <path_to_job_directory>\n", prog);
+    fprintf(stderr, "       %s [options] --batch <job dir | glob | folder of jobs> ...\n", prog);
+    fprintf(stderr, "       %s [options] --serve=SOCKET\n", prog);
+    fprintf(stderr, "       %s [options] --synthesize <bank job directory>\n", prog);
+    fprintf(stderr, "  --no-mmap              read input.qp into a heap buffer instead of mapping it\n");
+    fprintf(stderr, "  --tokens=json|bin|both which token logs to write (default: json)\n");
+    fprintf(stderr, "  --export-tokens        rebuild tokens.json from an existing tokens.bin\n");
+    fprintf(stderr, "  --ast-page=N           page of a long paper to expand in ast.dot/ast.json (default: 0)\n");
+    fprintf(stderr, "  --export-ast           only write that page of the AST to ast.page<N>.json\n");
+    fprintf(stderr, "  --bank=PATH            question bank file (default: question_bank.idx next to the job)\n");
+    fprintf(stderr, "  --no-bank              don't check or update the question bank\n");
+    fprintf(stderr, "  --cache-dir=DIR        compile cache folder (default: compile_cache next to the job)\n");
+    fprintf(stderr, "  --no-cache             always compile, even if an identical paper was compiled before\n");
+    fprintf(stderr, "                         (with the question bank, only tokens and AST are reused)\n");
+    fprintf(stderr, "  --no-incremental       re-lex every question, not just the ones changed since the last compile\n");
+    fprintf(stderr, "  --lex-threads=N        threads for lexing one big paper (default: one per core, 1: off)\n");
+    fprintf(stderr, "  --pdflatex             typeset the PDFs with pdflatex (slower; default: built-in writer)\n");
+    fprintf(stderr, "  --batch                expand globs and folders, then report papers/s and questions/s\n");
+    fprintf(stderr, "  --threads=N            worker threads for several jobs (default: one per core)\n");
+    fprintf(stderr, "  --serve=SOCKET         stay running and compile jobs sent to a Unix socket\n");
+    fprintf(stderr, "  --synthesize           assemble EnhancedPaper.qp from the questions of a bank job\n");
+    fprintf(stderr, "  --paper-marks=N        total marks of that paper (default: the bank's TOTAL_MARKS)\n");
+    fprintf(stderr, "  --paper-time=N         its time budget in minutes (default: the bank's TOTAL_TIME)\n");
+    fprintf(stderr, "  --coverage=P           percent of the syllabus units it must cover (default: %d)\n",
+            SYNTH_DEFAULT_COVERAGE);
+    fprintf(stderr, "  --variants=K           print K sets of that paper (Set A, B, ...; at most %d)\n",
+            SYNTH_MAX_VARIANTS);
+    fprintf(stderr, "  --max-overlap=P        percent of the questions two sets may share (default: %d)\n",
+            SYNTH_DEFAULT_OVERLAP);
+    fprintf(stderr, "  --seed=S               decides which set gets which question (default: %d)\n",
+            SYNTH_DEFAULT_SEED);
+}
+
+// Writes <job>/tokens.json from <job>/tokens.bin + <job>/input.qp
+static int export_tokens(const char* job_dir) {
+    char bin_path[PATH_MAX], src_path[PATH_MAX], json_path[PATH_MAX];
+    if (source_path(bin_path, sizeof(bin_path), job_dir, "tokens.bin") != 0 ||
+        source_path(src_path, sizeof(src_path), job_dir, "input.qp") != 0 ||
+        source_path(json_path, sizeof(json_path), job_dir, "tokens.json") != 0) {
+        fprintf(stderr, "Error: Job path too long: %s\n", job_dir);
+        return 1;
+    }
+    return token_stream_export_json(bin_path, src_path, json_path) == 0 ? 0 : 1;
+}
+
+// Re-parses <job>/input.qp and writes only ast.page<N>.json
+static int export_ast_only(const char* job_dir, const JobContext* defaults) {
+    JobContext job;
+    job_init(&job, job_dir);
+    job_copy_options(&job, defaults);
+    job.token_formats = 0; // The token logs are already there
+    int failed = job_parse(&job) != 0 || job_export_ast_page(&job) != 0;
+    job_cleanup(&job);
+    return failed;
+}
+
+// Compiles a bank job and assembles a paper from its questions
+static int synthesize(const char* job_dir, const JobContext* defaults, const SynthesisOptions* options) {
+    JobContext job;
+    job_init(&job, job_dir);
+    job_copy_options(&job, defaults);
+    job.use_bank = 0; // Spare questions are not a sat paper: keep them out of the question bank
+    int failed = job_parse(&job) != 0 || job_analyze(&job) != 0 || job_synthesize(&job, options) != 0;
+    job_cleanup(&job);
+    return failed;
+}
+
+/*
+ * Main Entry Point
+ * argv[0] will be "./q_compiler"
+ * The other arguments are paths to jobs (e.g., "jobs/d4a5c68e...").
+ * When more than one job is given, they are compiled on a thread pool
+ * (see batch.h).
+ * With --serve=SOCKET it runs as a server instead (see server.h).
+ */
+int main(int argc, char *argv[]) {
+    int use_mmap = 1;
+    int token_formats = TOKENS_JSON;
+    int export_only = 0;
+    int export_ast = 0;
+    int ast_page = 0;
+    int use_bank = 1;
+    const char* bank_path = NULL;
+    int use_cache = 1;
+    const char* cache_dir = NULL;
+    int use_incremental = 1;
+    int lex_threads = 0;
+    int use_pdflatex = 0;
+    const char* socket_path = NULL;
+    int batch = 0;
+    int threads = 0;
+    int synthesis = 0;
+    SynthesisOptions synthesis_options;
+    synthesis_options_init(&synthesis_options);
+    size_t job_count = 0;
+    const char** job_dirs = (const char**)malloc(sizeof(char*) * argc);
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--no-mmap") == 0) {
+            use_mmap = 0;
+        } else if (strcmp(argv[i], "--tokens=json") == 0) {
+            token_formats = TOKENS_JSON;
+        } else if (strcmp(argv[i], "--tokens=bin") == 0) {
+            token_formats = TOKENS_BIN;
+        } else if (strcmp(argv[i], "--tokens=both") == 0) {
+            token_formats = TOKENS_JSON | TOKENS_BIN;
+        } else if (strcmp(argv[i], "--export-tokens") == 0) {
+            export_only = 1;
+        } else if (strcmp(argv[i], "--export-ast") == 0) {
+            export_ast = 1;
+        } else if (strncmp(argv[i], "--ast-page=", 11) == 0 && atoi(argv[i] + 11) >= 0) {
+            ast_page = atoi(argv[i] + 11);
+        } else if (strncmp(argv[i], "--bank=", 7) == 0) {
+            bank_path = argv[i] + 7;
+        } else if (strcmp(argv[i], "--no-bank") == 0) {
+            use_bank = 0;
+        } else if (strncmp(argv[i], "--cache-dir=", 12) == 0 && argv[i][12] != '\0') {
+            cache_dir = argv[i] + 12;
+        } else if (strcmp(argv[i], "--no-cache") == 0) {
+            use_cache = 0;
+        } else if (strcmp(argv[i], "--no-incremental") == 0) {
+            use_incremental = 0;
+        } else if (strncmp(argv[i], "--lex-threads=", 14) == 0 && atoi(argv[i] + 14) > 0) {
+            lex_threads = atoi(argv[i] + 14);
+        } else if (strcmp(argv[i], "--pdflatex") == 0) {
+            use_pdflatex = 1;
+        } else if (strcmp(argv[i], "--batch") == 0) {
+            batch = 1;
+        } else if (strncmp(argv[i], "--threads=", 10) == 0 && atoi(argv[i] + 10) > 0) {
+            threads = atoi(argv[i] + 10);
+        } else if (strncmp(argv[i], "--serve=", 8) == 0 && argv[i][8] != '\0') {
+            socket_path = argv[i] + 8;
+        } else if (strcmp(argv[i], "--synthesize") == 0) {
+            synthesis = 1;
+        } else if (strncmp(argv[i], "--paper-marks=", 14) == 0 && atoi(argv[i] + 14) > 0) {
+            synthesis_options.marks = atoi(argv[i] + 14);
+        } else if (strncmp(argv[i], "--paper-time=", 13) == 0 && atoi(argv[i] + 13) > 0) {
+            synthesis_options.time = atoi(argv[i] + 13);
+        } else if (strncmp(argv[i], "--coverage=", 11) == 0 && atoi(argv[i] + 11) >= 0 &&
+                   atoi(argv[i] + 11) <= 100) {
+            synthesis_options.coverage = atoi(argv[i] + 11);
+        } else if (strncmp(argv[i], "--variants=", 11) == 0 && atoi(argv[i] + 11) > 0 &&
+                   atoi(argv[i] + 11) <= SYNTH_MAX_VARIANTS) {
+            synthesis_options.variants = atoi(argv[i] + 11);
+        } else if (strncmp(argv[i], "--max-overlap=", 14) == 0 && atoi(argv[i] + 14) >= 0 &&
+                   atoi(argv[i] + 14) <= 100) {
+            synthesis_options.max_overlap = atoi(argv[i] + 14);
+        } else if (strncmp(argv[i], "--seed=", 7) == 0 && argv[i][7] != '\0') {
+            synthesis_options.seed = strtoull(argv[i] + 7, NULL, 10);
+        } else if (argv[i][0] == '-') {
+            print_usage(argv[0]);
+            free(job_dirs);
+            return 1;
+        } else {
+            job_dirs[job_count++] = argv[i];
+        }
+    }
+
+    JobContext defaults; // Options shared by every job
+    job_init(&defaults, NULL);
+    defaults.use_mmap = use_mmap;
+    defaults.token_formats = token_formats;
+    defaults.use_bank = use_bank;
+    defaults.bank_path = bank_path;
+    defaults.ast_page = ast_page;
+    defaults.use_cache = use_cache;
+    defaults.cache_dir = cache_dir;
+    defaults.use_incremental = use_incremental;
+    defaults.lex_threads = lex_threads;
+    defaults.use_pdflatex = use_pdflatex;
+
+    if (socket_path != NULL && job_count == 0) {
+        // Server mode: the options become the defaults for every job
+        free(job_dirs);
+        return run_server(socket_path, &defaults);
+    }
+    if (job_count == 0 || socket_path != NULL) {
+        print_usage(argv[0]);
+        free(job_dirs);
+        return 1;
+    }
+
+    if (export_only) {
+        // tokens.json is generated lazily, e.g. when a user downloads it
+        int failed = 0;
+        for (size_t i = 0; i < job_count; i++) {
+            failed |= export_tokens(job_dirs[i]);
+        }
+        free(job_dirs);
+        return failed;
+    }
+
+    if (export_ast) {
+        // The tree view asks for other pages of a long paper this way
+        int failed = 0;
+        for (size_t i = 0; i < job_count; i++) {
+            failed |= export_ast_only(job_dirs[i], &defaults);
+        }
+        free(job_dirs);
+        return failed;
+    }
+
+    if (synthesis) {
+        // One bank at a time; the search itself uses the threads
+        synthesis_options.threads = threads;
+        int failed = 0;
+        for (size_t i = 0; i < job_count; i++) {
+            failed |= synthesize(job_dirs[i], &defaults, &synthesis_options);
+        }
+        free(job_dirs);
+        return failed;
+    }
+
+    if (batch) {
+        char** dirs = NULL;
+        size_t dir_count = 0;
+        if (batch_expand(job_dirs, job_count, &dirs, &dir_count) != 0) {
+            fprintf(stderr, "Fatal Error: Out of memory listing job directories\n");
+            free(job_dirs);
+            return 1;
+        }
+        BatchStats stats;
+        size_t failed = run_batch((const char* const*)dirs, dir_count, &defaults, threads, &stats);
+        batch_print_stats(&stats);
+        batch_free_dirs(dirs, dir_count);
+        free(job_dirs);
+        return failed > 0 || dir_count == 0 ? 1 : 0;
+    }
+
+    int failed = 0;
+    if (job_count == 1) {
+        // The common case (one upload from app.py): no threads needed
+        JobContext job;
+        job_init(&job, job_dirs[0]);
+        job_copy_options(&job, &defaults);
+        failed = job_compile(&job) != 0;
+        job_cleanup(&job);
+    } else {
+        BatchStats stats;
+        failed = run_batch(job_dirs, job_count, &defaults, threads, &stats) > 0;
+    }
+    free(job_dirs);
+
+    return failed ? 1 : 0; // 0 = Success!
+}
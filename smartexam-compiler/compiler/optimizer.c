@@ -0,0 +1,263 @@
+/*
+ * compiler/optimizer.c
+ * Phase 5: rebalances marks and time and logs the proposed rewrites
+ * (see optimizer.h).
+ */
+
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "optimizer.h"
+#include "ast_helpers.h"
+#include "json_writer.h"
+#include "semantic.h"
+#include "source.h"
+
+/* --- Rebalancing --- */
+
+static int clamp_int(int v, int lo, int hi) {
+    return v < lo ? lo : v > hi ? hi : v;
+}
+
+// Sum of values[i] * factor, each kept within [lo[i], hi[i]]
+static double scaled_sum(const int* values, const int* lo, const int* hi, int n, double factor) {
+    double sum = 0.0;
+    for (int i = 0; i < n; i++) {
+        double v = values[i] * factor;
+        if (v < lo[i]) v = lo[i];
+        if (v > hi[i]) v = hi[i];
+        sum += v;
+    }
+    return sum;
+}
+
+typedef struct Remainder {
+    double fraction; // What rounding down cut off
+    int index;
+} Remainder;
+
+// Largest fraction first; ties in paper order
+static int by_fraction(const void* a, const void* b) {
+    const Remainder* x = (const Remainder*)a;
+    const Remainder* y = (const Remainder*)b;
+    if (x->fraction != y->fraction) return x->fraction < y->fraction ? 1 : -1;
+    return x->index - y->index;
+}
+
+/*
+ * Scales 'values' by one common factor so they add up to 'target', each
+ * kept within [lo[i], hi[i]], and writes the result to 'out'.
+ * Returns the sum reached: 'target', or the closest sum the bounds allow
+ * (-1 if out of memory).
+ */
+static long rebalance(const int* values, const int* lo, const int* hi, int n, long target,
+                      int* out, Arena* arena) {
+    long sum = 0, sum_lo = 0, sum_hi = 0;
+    for (int i = 0; i < n; i++) {
+        sum += values[i];
+        sum_lo += lo[i];
+        sum_hi += hi[i];
+    }
+    const int* fixed = target == sum ? values : target <= sum_lo ? lo : target >= sum_hi ? hi : NULL;
+    if (fixed != NULL) {
+        if (n > 0) memcpy(out, fixed, sizeof(int) * (size_t)n);
+        return fixed == values ? sum : fixed == lo ? sum_lo : sum_hi;
+    }
+
+    // Binary search for the largest factor whose scaled sum is <= target
+    double low = 0.0, high = 1.0;
+    while (high < 1e9 && scaled_sum(values, lo, hi, n, high) < (double)target) {
+        high *= 2.0;
+    }
+    for (int step = 0; step < 64 && high - low > high * 1e-12; step++) {
+        double mid = (low + high) / 2.0;
+        if (scaled_sum(values, lo, hi, n, mid) <= (double)target) {
+            low = mid;
+        } else {
+            high = mid;
+        }
+    }
+
+    // Round down, then hand out what is left one unit at a time,
+    // largest remainder first
+    Remainder* remainders = (Remainder*)arena_alloc(arena, sizeof(Remainder) * (size_t)n);
+    if (remainders == NULL) return -1;
+    long total = 0;
+    for (int i = 0; i < n; i++) {
+        double v = values[i] * low;
+        if (v < lo[i]) v = lo[i];
+        if (v > hi[i]) v = hi[i];
+        out[i] = (int)v;
+        total += out[i];
+        remainders[i].fraction = v - out[i];
+        remainders[i].index = i;
+    }
+    qsort(remainders, (size_t)n, sizeof(Remainder), by_fraction);
+    while (total < target) {
+        int given = 0;
+        for (int k = 0; k < n && total < target; k++) {
+            int i = remainders[k].index;
+            if (out[i] < hi[i]) {
+                out[i]++;
+                total++;
+                given = 1;
+            }
+        }
+        if (!given) break; // Can't happen: target < sum_hi
+    }
+    return total;
+}
+
+/* --- Log --- */
+
+static void write_rewrite(JsonWriter* w, const char* change, int question, int from, int to,
+                          const IRQuestion* q, const ASTNode* root, const char* message) {
+    json_begin_object(w);
+    json_key(w, "change");
+    json_string(w, change);
+    json_key(w, "question"); // Counting from 1
+    json_int(w, question + 1);
+    json_key(w, "from");
+    json_int(w, from);
+    json_key(w, "to");
+    json_int(w, to);
+    json_key(w, "difficulty");
+    json_string(w, difficulty_name(q->difficulty));
+    json_key(w, "syllabus_topic");
+    json_string(w, topic_name(&root->topics, q->topic));
+    json_key(w, "message");
+    json_string(w, message);
+    json_end_object(w);
+}
+
+/* --- Phase 5 Entry Point --- */
+
+int run_phase_5_optimize(const IR_List* ir, OptimizationPlan* plan, Arena* arena) {
+    memset(plan, 0, sizeof(*plan));
+    int n = ir->count;
+    size_t cols = n > 0 ? (size_t)n : 1;
+    // Plain int columns, so each scaling pass reads contiguous memory
+    int* marks = (int*)arena_alloc(arena, sizeof(int) * cols * 7);
+    plan->marks = (int*)arena_alloc(arena, sizeof(int) * cols);
+    plan->time = (int*)arena_alloc(arena, sizeof(int) * cols);
+    if (marks == NULL || plan->marks == NULL || plan->time == NULL) return -1;
+    int* min_marks = marks + cols;
+    int* max_marks = min_marks + cols;
+    int* time = max_marks + cols;
+    int* base_time = time + cols;
+    int* min_time = base_time + cols;
+    int* max_time = min_time + cols;
+    for (int i = 0; i < n; i++) {
+        marks[i] = ir->questions[i].marks;
+        min_marks[i] = ir->questions[i].min_marks;
+        max_marks[i] = ir->questions[i].max_marks;
+        time[i] = ir->questions[i].time;
+    }
+
+    // --- 1. Marks ---
+    plan->marks_total = ir->total_marks;
+    if (ir->target_marks > 0) {
+        plan->marks_total = rebalance(marks, min_marks, max_marks, n, ir->target_marks, plan->marks, arena);
+    } else if (n > 0) {
+        memcpy(plan->marks, marks, sizeof(int) * cols);
+    }
+
+    // --- 2. Time: re-estimated for the new marks, then fitted ---
+    // Spare time may go anywhere (up to the whole exam), but no question
+    // loses more than IR_MAX_CHANGE_PERCENT of what it needs
+    long needed = 0;
+    for (int i = 0; i < n; i++) {
+        int t = plan->marks[i] != marks[i]
+            ? estimate_question_time(plan->marks[i], (Difficulty)ir->questions[i].difficulty)
+            : time[i];
+        base_time[i] = t;
+        min_time[i] = clamp_int(t - ir_max_change(t), 1, t);
+        max_time[i] = ir->target_time > t ? ir->target_time : t;
+        needed += t;
+    }
+    plan->time_total = 0;
+    // A paper Phase 3 finds too long keeps its estimates: squeezing every
+    // question to TOTAL_TIME would only hide that (the log says PARTIAL)
+    if (ir->target_time > 0 && needed <= (long)ir->target_time + TIME_TOLERANCE) {
+        plan->time_total = rebalance(base_time, min_time, max_time, n, ir->target_time, plan->time, arena);
+    } else {
+        for (int i = 0; i < n; i++) {
+            plan->time[i] = base_time[i];
+            plan->time_total += base_time[i];
+        }
+    }
+    if (plan->marks_total < 0 || plan->time_total < 0) return -1;
+
+    for (int i = 0; i < n; i++) {
+        int marks_changed = plan->marks[i] != marks[i];
+        int time_changed = plan->time[i] != time[i];
+        plan->rewrites += marks_changed + time_changed;
+        plan->questions_changed += marks_changed || time_changed;
+    }
+    return 0;
+}
+
+int write_optimization_log(const IR_List* ir, const OptimizationPlan* plan,
+                           const ASTNode* root, const char* job_dir) {
+    char path[PATH_MAX], message[256];
+    if (source_path(path, sizeof(path), job_dir, "optimization_log.json") != 0) return -1;
+    JsonWriter w;
+    if (json_writer_open(&w, path) != 0) return -1;
+    json_begin_array(&w);
+
+    // First a summary...
+    int partial = (ir->target_marks > 0 && plan->marks_total != ir->target_marks) ||
+                  (ir->target_time > 0 && plan->time_total != ir->target_time);
+    const char* kind = partial ? "PARTIAL" : plan->rewrites > 0 ? "REBALANCE" : "NO_CHANGE";
+    if (ir->target_time > 0 && plan->time_total > (long)ir->target_time + TIME_TOLERANCE) {
+        snprintf(message, sizeof(message),
+                 "The questions need %ld minutes, more than the %d the header allows: cut questions or allow more time",
+                 plan->time_total, ir->target_time);
+    } else if (partial) {
+        snprintf(message, sizeof(message),
+                 "Within the limits per question the marks can reach %ld (header: %d) and the time %ld minutes (header: %d)",
+                 plan->marks_total, ir->target_marks, plan->time_total, ir->target_time);
+    } else if (plan->rewrites > 0) {
+        snprintf(message, sizeof(message), "%d rewrite(s) in %d question(s) make the paper add up",
+                 plan->rewrites, plan->questions_changed);
+    } else {
+        snprintf(message, sizeof(message), "Marks and time already add up to the header totals");
+    }
+    json_begin_object(&w);
+    json_key(&w, "change");
+    json_string(&w, kind);
+    json_key(&w, "message");
+    json_string(&w, message);
+    json_key(&w, "target_marks");
+    json_int(&w, ir->target_marks);
+    json_key(&w, "marks_before");
+    json_int(&w, ir->total_marks);
+    json_key(&w, "marks_after");
+    json_int(&w, plan->marks_total);
+    json_key(&w, "target_time");
+    json_int(&w, ir->target_time);
+    json_key(&w, "time_before");
+    json_int(&w, ir->total_time);
+    json_key(&w, "time_after");
+    json_int(&w, plan->time_total);
+    json_key(&w, "questions_changed");
+    json_int(&w, plan->questions_changed);
+    json_end_object(&w);
+
+    // ... then every rewrite
+    for (int i = 0; i < ir->count; i++) {
+        const IRQuestion* q = &ir->questions[i];
+        if (plan->marks[i] != q->marks) {
+            snprintf(message, sizeof(message), "%s marks from %d to %d",
+                     plan->marks[i] > q->marks ? "Raise" : "Lower", q->marks, plan->marks[i]);
+            write_rewrite(&w, "MARKS", i, q->marks, plan->marks[i], q, root, message);
+        }
+        if (plan->time[i] != q->time) {
+            snprintf(message, sizeof(message), "Allow %d minutes instead of %d", plan->time[i], q->time);
+            write_rewrite(&w, "TIME", i, q->time, plan->time[i], q, root, message);
+        }
+    }
+    json_end_array(&w);
+    return json_writer_close(&w);
+}
@@ -0,0 +1,60 @@
+/*
+ * compiler/optimizer.h
+ * Phase 5: proposes mark and time changes so the paper adds up.
+ *
+ * If the marks of the questions don't add up to TOTAL_MARKS, all of them
+ * are scaled by one common factor, so every question keeps its weight
+ * and every topic its share. Each stays within the bounds the IR gives
+ * it, and the results are rounded with the largest-remainder method so
+ * the sum comes out exact. All changes go the same way, so the total
+ * change is as small as it can be: exactly the difference. The times
+ * are then re-estimated from the new marks (the estimates Phase 3 adds
+ * up, see semantic.h) and scaled to TOTAL_TIME in the same way; spare
+ * time may go to any question, but none loses more than
+ * IR_MAX_CHANGE_PERCENT of its estimate. A paper that needs more than
+ * TIME_TOLERANCE minutes over TOTAL_TIME keeps its estimates: Phase 3
+ * reports it as too long, and so does the log.
+ *
+ * The paper itself is not changed. Every proposed rewrite is listed in
+ * optimization_log.json for the reviewer:
+ *
+ *     [ { "change": "REBALANCE", ...totals before and after... },
+ *       { "change": "MARKS", "question": 3, "from": 10, "to": 12, ... },
+ *       { "change": "TIME", "question": 3, "from": 8, "to": 10, ... } ]
+ *
+ * The first entry is "NO_CHANGE" if the paper already adds up, and
+ * "PARTIAL" if the bounds don't allow reaching a total or the paper is
+ * too long for TOTAL_TIME.
+ * Scaling costs a few passes over two int columns, so even a bank of
+ * 100,000 questions takes milliseconds.
+ */
+
+#ifndef OPTIMIZER_H
+#define OPTIMIZER_H
+
+#include "arena.h"
+#include "ast.h"
+#include "ir.h"
+
+// The proposed marks and time of every question
+typedef struct OptimizationPlan {
+    int* marks;          // New marks, per question
+    int* time;           // New time in minutes, per question
+    long marks_total;    // Sums of the above
+    long time_total;
+    int rewrites;        // Marks or times that differ from the paper
+    int questions_changed;
+} OptimizationPlan;
+
+/* --- Phase 5 Entry Point --- */
+
+// Rebalances 'ir' into 'plan' (arrays and scratch memory come from
+// 'arena'). Returns 0 on success, -1 if out of memory.
+int run_phase_5_optimize(const IR_List* ir, OptimizationPlan* plan, Arena* arena);
+
+// Writes job_dir/optimization_log.json for 'plan'.
+// Returns 0 on success, -1 on error.
+int write_optimization_log(const IR_List* ir, const OptimizationPlan* plan,
+                           const ASTNode* root, const char* job_dir);
+
+#endif // OPTIMIZER_H
@@ -0,0 +1,202 @@
+/*
+ * compiler/parallel.c
+ * Lexes and parses the questions of a big paper on several threads
+ * (see parallel.h).
+ */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "parallel.h"
+#include "ast_helpers.h"
+#include "blocks.h"
+#include "incremental.h"
+
+/* --- External Functions --- */
+
+// From lexer.l (lex.yy.c)
+ASTNode* lexer_parse_header(JobContext* job, size_t end);
+int lexer_parse_questions(JobContext* job, size_t start, size_t end, int line, QuestionList* list);
+int lexer_parse_tail(JobContext* job, size_t start, int line);
+void lexer_log_tokens(JobContext* job, const TokenRecord* tokens, size_t count);
+
+// One run of question blocks, [start, end)
+typedef struct ParseChunk {
+    JobContext job;     // The worker's copy of the job: own arena, own token list
+    size_t start;
+    size_t end;
+    int line;           // Line of 'start'
+    QuestionList list;
+    TokenList tokens;
+    int result;         // From lexer_parse_questions()
+    pthread_t thread;
+    int started;        // Did 'thread' start?
+} ParseChunk;
+
+static void* parse_chunk(void* arg) {
+    ParseChunk* chunk = (ParseChunk*)arg;
+    chunk->result = lexer_parse_questions(&chunk->job, chunk->start, chunk->end, chunk->line,
+                                          &chunk->list);
+    return NULL;
+}
+
+static int lexer_threads(const JobContext* job) {
+    if (job->lex_threads > 0) return job->lex_threads;
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    return cores > 0 ? (int)cores : 1;
+}
+
+// Cuts the blocks into at most 'max' runs of about the same size.
+// Returns the number of runs.
+static int cut_chunks(const SourceBlocks* split, ParseChunk* chunks, int max) {
+    const SourceBlock* blocks = split->blocks;
+    size_t body = split->suffix_start - split->prefix_end;
+    int first = 0, n = 0;
+    while (first < split->count && n < max) {
+        int last = split->count - 1; // The last run takes the rest
+        if (n + 1 < max) {
+            size_t target = split->prefix_end + body * (size_t)(n + 1) / (size_t)max;
+            // A run can only end where at least two blanks follow: the
+            // lexer borrows them as its end marker
+            last = first;
+            while (last + 1 < split->count &&
+                   (blocks[last].end < target || blocks[last + 1].start - blocks[last].end < 2)) {
+                last++;
+            }
+        }
+        chunks[n].start = blocks[first].start;
+        chunks[n].end = blocks[last].end;
+        chunks[n].line = blocks[first].line;
+        n++;
+        first = last + 1;
+    }
+    return n;
+}
+
+// The lexer turns the closing quote of every string it reads into a NUL.
+// Puts them back, so the normal parser sees the source as it was.
+static void restore_quotes(char* data, const TokenList* tokens) {
+    for (size_t i = 0; i < tokens->count; i++) {
+        const TokenRecord* t = &tokens->tokens[i];
+        if (t->kind == TOK_STRING) data[t->offset + t->length] = '"';
+    }
+}
+
+/* --- Parallel Parse Functions --- */
+
+int parallel_parse(JobContext* job, int* threads_used) {
+    int max = lexer_threads(job);
+    if ((size_t)max > job->source.length / PARALLEL_MIN_CHUNK) {
+        max = (int)(job->source.length / PARALLEL_MIN_CHUNK);
+    }
+    if (max < 2) return 1; // Not worth a thread
+
+    // --- 1. Find the question blocks ---
+    SourceBlocks own_split;
+    const SourceBlocks* split = &own_split;
+    if (job->incremental != NULL) {
+        split = &job->incremental->split; // Already split
+    } else if (source_split_blocks(job->source.data, job->source.length, &own_split, &job->arena) != 0) {
+        return 1;
+    }
+    ParseChunk* chunks = (ParseChunk*)calloc((size_t)max, sizeof(ParseChunk));
+    if (chunks == NULL) return 1;
+    int count = cut_chunks(split, chunks, max);
+    if (count < 2) {
+        free(chunks);
+        return 1;
+    }
+
+    // --- 2. The header, then the runs of questions, then the tail ---
+    // The header goes first: it borrows the first bytes of run 0
+    TokenList head, tail;
+    memset(&head, 0, sizeof(head));
+    memset(&tail, 0, sizeof(tail));
+    TokenList* capture = job->token_capture; // incremental.c's list, if any
+    job->token_capture = &head;
+    ASTNode* root = lexer_parse_header(job, split->prefix_end);
+
+    for (int i = 0; i < count; i++) {
+        ParseChunk* chunk = &chunks[i];
+        chunk->job = *job;
+        arena_init(&chunk->job.arena);
+        chunk->job.token_capture = &chunk->tokens;
+        chunk->job.incremental = NULL;
+        init_question_list(&chunk->list);
+        chunk->result = -1;
+    }
+    if (root != NULL) {
+        for (int i = 1; i < count; i++) {
+            chunks[i].started = pthread_create(&chunks[i].thread, NULL, parse_chunk, &chunks[i]) == 0;
+            if (!chunks[i].started) parse_chunk(&chunks[i]); // No thread: do it here
+        }
+        parse_chunk(&chunks[0]);
+        for (int i = 1; i < count; i++) {
+            if (chunks[i].started) pthread_join(chunks[i].thread, NULL);
+        }
+    }
+    // Last: run count-1 may have borrowed the first bytes of the tail
+    job->token_capture = &tail;
+    int ok = root != NULL && lexer_parse_tail(job, split->suffix_start, split->suffix_line) == 0;
+    job->token_capture = capture;
+
+    // --- 3. Stitch the parts together in source order ---
+    TokenList own_tokens;
+    memset(&own_tokens, 0, sizeof(own_tokens));
+    TokenList* tokens = capture != NULL ? capture : &own_tokens;
+    size_t tokens_before = tokens->count;
+    token_list_append(tokens, &head);
+    for (int i = 0; i < count; i++) {
+        ok &= chunks[i].result == 0;
+        token_list_append(tokens, &chunks[i].tokens);
+    }
+    token_list_append(tokens, &tail);
+    ok &= !tokens->failed;
+
+    int result = 0;
+    if (ok) {
+        QuestionList list;
+        init_question_list(&list);
+        for (int i = 0; i < count; i++) {
+            QuestionList* part = &chunks[i].list;
+            if (part->head != NULL) {
+                if (list.head == NULL) {
+                    list.head = part->head;
+                } else {
+                    list.tail->next = part->head;
+                }
+                list.tail = part->tail;
+                list.count += part->count;
+            }
+            arena_adopt(&job->arena, &chunks[i].job.arena); // The nodes now belong to the job
+        }
+        root->questions = list.head;
+        root->question_count = list.count;
+        job->root = root;
+        lexer_log_tokens(job, tokens->tokens + tokens_before, tokens->count - tokens_before);
+        *threads_used = count;
+    } else {
+        // Undo everything; the normal parser will report what is wrong
+        int restored = !head.failed && !tail.failed;
+        restore_quotes(job->source.data, &head);
+        for (int i = 0; i < count; i++) {
+            restored &= !chunks[i].tokens.failed;
+            restore_quotes(job->source.data, &chunks[i].tokens);
+            arena_free(&chunks[i].job.arena);
+        }
+        restore_quotes(job->source.data, &tail);
+        tokens->count = tokens_before;
+        result = restored ? 1 : -1; // A quote we don't know of can't be put back
+    }
+
+    token_list_free(&head);
+    token_list_free(&tail);
+    for (int i = 0; i < count; i++) {
+        token_list_free(&chunks[i].tokens);
+    }
+    token_list_free(&own_tokens);
+    free(chunks);
+    return result;
+}
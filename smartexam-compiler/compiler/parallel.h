@@ -0,0 +1,36 @@
+/*
+ * compiler/parallel.h
+ * Parallel front end: Phases 1 & 2 of a big paper on several threads.
+ *
+ * One Flex scanner reads a paper strictly from front to back, but the
+ * [QUESTION] blocks don't depend on each other. So the blocks of a big
+ * input.qp (found by blocks.h) are cut into one run per thread. The
+ * header and [/QUESTION_LIST] are lexed on the calling thread. Each run
+ * of questions is lexed and parsed on a worker thread with its own
+ * scanner, arena and token list. Afterwards the question lists are
+ * linked in order and the tokens are logged in source order. Every
+ * scanner starts counting at its run's first line, so tokens.json has
+ * the same line numbers as a serial parse.
+ *
+ * Only well-formed papers take this path: if any part is not what the
+ * grammar expects, the source is put back the way it was and the normal
+ * parser runs, so errors are reported exactly as before.
+ */
+
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include "job.h"
+
+#define PARALLEL_MIN_CHUNK (64 * 1024) // Bytes of questions worth a thread
+
+/* --- Parallel Parse Functions --- */
+
+// Builds job->root and writes the token logs using up to
+// job->lex_threads threads (0: one per core). 'threads_used' gets the
+// number of threads.
+// Returns 0 on success, 1 if the caller should run the normal parser
+// (small paper, syntax error, ...), -1 if out of memory.
+int parallel_parse(JobContext* job, int* threads_used);
+
+#endif // PARALLEL_H
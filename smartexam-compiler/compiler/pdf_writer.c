@@ -0,0 +1,519 @@
+/*
+ * compiler/pdf_writer.c
+ * Implementation of the PDF writer (see pdf_writer.h).
+ */
+
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "pdf_writer.h"
+
+#define LINE_SPACING 1.3 // Line height / font size
+#define CELL_PADDING 4.0
+
+// Object numbers that are known up front; pages come after them
+#define CATALOG_OBJECT 1
+#define PAGES_OBJECT   2
+#define FONT_OBJECT    3 // One per PdfFont
+#define FIRST_FREE_OBJECT (FONT_OBJECT + PDF_FONT_COUNT)
+
+static const char* const font_names[PDF_FONT_COUNT] = { "Helvetica", "Helvetica-Bold" };
+
+// Glyph widths (in 1/1000 of the font size) of ' ' to '~' in
+// WinAnsiEncoding, from the Adobe font metrics
+static const short ascii_widths[PDF_FONT_COUNT][95] = {
+    { // Helvetica
+        278, 278, 355, 556, 556, 889, 667, 191, 333, 333, 389, 584, 278, 333, 278, 278,
+        556, 556, 556, 556, 556, 556, 556, 556, 556, 556, 278, 278, 584, 584, 584, 556,
+        1015, 667, 667, 722, 722, 667, 611, 778, 722, 278, 500, 667, 556, 833, 722, 778,
+        667, 778, 722, 667, 611, 722, 667, 944, 667, 667, 611, 278, 278, 278, 469, 556,
+        333, 556, 556, 500, 556, 556, 278, 556, 556, 222, 222, 500, 222, 833, 556, 556,
+        556, 556, 333, 500, 278, 556, 500, 722, 500, 500, 500, 334, 260, 334, 584
+    },
+    { // Helvetica-Bold
+        278, 333, 474, 556, 556, 889, 722, 238, 333, 333, 389, 584, 278, 333, 278, 278,
+        556, 556, 556, 556, 556, 556, 556, 556, 556, 556, 333, 333, 584, 584, 584, 611,
+        975, 722, 722, 722, 722, 667, 611, 778, 722, 278, 556, 722, 611, 833, 722, 778,
+        667, 778, 722, 667, 611, 722, 667, 944, 667, 667, 611, 333, 278, 333, 584, 556,
+        333, 556, 611, 556, 611, 556, 333, 611, 611, 278, 278, 556, 278, 889, 611, 611,
+        611, 611, 389, 556, 333, 611, 556, 778, 556, 556, 500, 389, 280, 389, 584
+    }
+};
+
+// Unicode punctuation WinAnsiEncoding has outside Latin-1
+typedef struct WinAnsiExtra {
+    unsigned int code_point;
+    unsigned char byte;
+    short width;           // Both fonts
+} WinAnsiExtra;
+
+static const WinAnsiExtra extras[] = {
+    { 0x20AC, 0x80, 556 }, // Euro sign
+    { 0x2026, 0x85, 1000 }, // Ellipsis
+    { 0x2018, 0x91, 278 }, { 0x2019, 0x92, 278 }, // Single quotes
+    { 0x201C, 0x93, 500 }, { 0x201D, 0x94, 500 }, // Double quotes
+    { 0x2022, 0x95, 350 }, // Bullet
+    { 0x2013, 0x96, 556 }, { 0x2014, 0x97, 1000 }, // En and em dash
+};
+
+static double char_width(PdfFont font, unsigned char c) {
+    if (c >= ' ' && c <= '~') return ascii_widths[font][c - ' '];
+    for (size_t i = 0; i < sizeof(extras) / sizeof(extras[0]); i++) {
+        if (extras[i].byte == c) return extras[i].width;
+    }
+    return 722; // Latin-1 letters: no narrower than this
+}
+
+static double text_width(PdfFont font, double size, const char* s, size_t len) {
+    double width = 0.0;
+    for (size_t i = 0; i < len; i++) width += char_width(font, (unsigned char)s[i]);
+    return width * size / 1000.0;
+}
+
+/* --- Text Conversion --- */
+
+static unsigned char winansi_byte(unsigned int code_point) {
+    if (code_point >= 0xA0 && code_point <= 0xFF) return (unsigned char)code_point; // Latin-1
+    for (size_t i = 0; i < sizeof(extras) / sizeof(extras[0]); i++) {
+        if (extras[i].code_point == code_point) return extras[i].byte;
+    }
+    return '?';
+}
+
+// Converts UTF-8 'text' into w->text. Returns the new length (never
+// more than 'len'), or -1 if out of memory. Newlines are kept; other
+// control characters become spaces.
+static long to_winansi(PdfWriter* w, const char* text, size_t len) {
+    if (len + 1 > w->text_capacity) {
+        char* grown = (char*)realloc(w->text, len + 1);
+        if (grown == NULL) {
+            w->failed = 1;
+            return -1;
+        }
+        w->text = grown;
+        w->text_capacity = len + 1;
+    }
+    const unsigned char* p = (const unsigned char*)text;
+    size_t n = 0;
+    for (size_t i = 0; i < len;) {
+        unsigned char c = p[i];
+        if (c < 0x80) {
+            w->text[n++] = c == '\n' ? '\n' : c < ' ' || c == 0x7F ? ' ' : (char)c;
+            i++;
+            continue;
+        }
+        int extra = c >= 0xF0 ? 3 : c >= 0xE0 ? 2 : c >= 0xC0 ? 1 : 0;
+        unsigned int code_point = c & (0x3F >> extra);
+        size_t j = i + 1;
+        for (int k = 0; k < extra && j < len && (p[j] & 0xC0) == 0x80; k++, j++) {
+            code_point = (code_point << 6) | (p[j] & 0x3F);
+        }
+        w->text[n++] = (char)(j - i == (size_t)extra + 1 && extra > 0 ? winansi_byte(code_point) : '?');
+        i = j;
+    }
+    return (long)n;
+}
+
+// Finds the line that starts at 'start': as many words as fit in
+// 'width' (a word longer than that is split). Sets *end to the end of
+// the line's text and returns where the next line starts.
+static size_t wrap(const char* s, size_t len, size_t start, PdfFont font, double size, double width,
+                   size_t* end) {
+    double line = 0.0;
+    size_t break_end = 0, break_next = 0;
+    for (size_t i = start; i < len; i++) {
+        if (s[i] == '\n') {
+            *end = i;
+            return i + 1;
+        }
+        double w = char_width(font, (unsigned char)s[i]) * size / 1000.0;
+        if (line + w > width && i > start) {
+            if (s[i] == ' ' || break_next == 0) {
+                *end = i;
+                while (i < len && s[i] == ' ') i++;
+                return i;
+            }
+            *end = break_end;
+            return break_next;
+        }
+        if (s[i] == ' ') {
+            break_end = i;
+            break_next = i + 1;
+            while (break_next < len && s[break_next] == ' ') break_next++;
+        }
+        line += w;
+    }
+    *end = len;
+    return len;
+}
+
+/* --- Output --- */
+
+static void emit(PdfWriter* w, const char* data, size_t len) {
+    if (fwrite(data, 1, len, w->out) != len) w->failed = 1;
+    w->offset += (long)len;
+}
+
+static void emitf(PdfWriter* w, const char* format, ...) {
+    char line[512];
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+    if (n > 0) emit(w, line, (size_t)n < sizeof(line) ? (size_t)n : sizeof(line) - 1);
+}
+
+// Starts object 'number' at the current offset
+static void begin_object(PdfWriter* w, int number) {
+    w->objects[number] = w->offset;
+    emitf(w, "%d 0 obj\n", number);
+}
+
+// Returns a new object number, or -1 if out of memory
+static int new_object(PdfWriter* w) {
+    if (w->object_count == w->object_capacity) {
+        int capacity = w->object_capacity * 2;
+        long* grown = (long*)realloc(w->objects, sizeof(long) * (size_t)capacity);
+        if (grown == NULL) {
+            w->failed = 1;
+            return -1;
+        }
+        w->objects = grown;
+        w->object_capacity = capacity;
+    }
+    w->objects[w->object_count] = 0;
+    return w->object_count++;
+}
+
+// Appends to the current page's content stream
+static void put(PdfWriter* w, const char* data, size_t len) {
+    if (w->content_length + len > w->content_capacity) {
+        size_t capacity = w->content_capacity * 2 + len;
+        char* grown = (char*)realloc(w->content, capacity);
+        if (grown == NULL) {
+            w->failed = 1;
+            return;
+        }
+        w->content = grown;
+        w->content_capacity = capacity;
+    }
+    memcpy(w->content + w->content_length, data, len);
+    w->content_length += len;
+}
+
+// Appends 'value' (to 1/100 point) and a space. Called for every
+// coordinate, so it avoids printf.
+static void put_number(PdfWriter* w, double value) {
+    char digits[32];
+    char* p = digits + sizeof(digits);
+    long hundredths = (long)(value * 100.0 + (value < 0 ? -0.5 : 0.5));
+    int negative = hundredths < 0;
+    unsigned long v = (unsigned long)(negative ? -hundredths : hundredths);
+    *--p = ' ';
+    if (v % 100 != 0) { // "56 ", "727.4 ", "60.25 "
+        if (v % 10 != 0) *--p = (char)('0' + v % 10);
+        *--p = (char)('0' + v / 10 % 10);
+        *--p = '.';
+    }
+    v /= 100;
+    do {
+        *--p = (char)('0' + v % 10);
+        v /= 10;
+    } while (v > 0);
+    if (negative) *--p = '-';
+    put(w, p, (size_t)(digits + sizeof(digits) - p));
+}
+
+// Shows s[0..len) with its baseline at (x, y). The font stays set
+// between text objects, so it is only given when it changes.
+static void draw_text(PdfWriter* w, PdfFont font, double size, double x, double y, const char* s, size_t len) {
+    if (len == 0) return;
+    put(w, "BT ", 3);
+    if ((int)font != w->font || size != w->font_size) {
+        put(w, font == PDF_BOLD ? "/F2 " : "/F1 ", 4);
+        put_number(w, size);
+        put(w, "Tf ", 3);
+        w->font = (int)font;
+        w->font_size = size;
+    }
+    put_number(w, x);
+    put_number(w, y);
+    put(w, "Td (", 4);
+    size_t run = 0;
+    for (size_t i = 0; i < len; i++) {
+        unsigned char c = (unsigned char)s[i];
+        if (c != '(' && c != ')' && c != '\\' && c < 0x80) continue;
+        put(w, s + run, i - run);
+        if (c < 0x80) {
+            char escaped[2] = { '\\', (char)c };
+            put(w, escaped, 2);
+        } else {
+            char octal[4] = { '\\', (char)('0' + (c >> 6)), (char)('0' + ((c >> 3) & 7)), (char)('0' + (c & 7)) };
+            put(w, octal, 4);
+        }
+        run = i + 1;
+    }
+    put(w, s + run, len - run);
+    put(w, ") Tj ET\n", 8);
+}
+
+static void draw_rule(PdfWriter* w, double y) {
+    put(w, "0.5 w ", 6);
+    put_number(w, PDF_MARGIN);
+    put_number(w, y);
+    put(w, "m ", 2);
+    put_number(w, PDF_MARGIN + PDF_TEXT_WIDTH);
+    put_number(w, y);
+    put(w, "l S\n", 4);
+}
+
+static void finish_page(PdfWriter* w) {
+    if (w->y < 0) return;
+    if (w->page_count == w->page_capacity) {
+        int capacity = w->page_capacity * 2;
+        int* grown = (int*)realloc(w->pages, sizeof(int) * (size_t)capacity);
+        if (grown == NULL) {
+            w->failed = 1;
+            return;
+        }
+        w->pages = grown;
+        w->page_capacity = capacity;
+    }
+    int content = new_object(w);
+    int page = new_object(w);
+    if (content < 0 || page < 0) return;
+    begin_object(w, content);
+    emitf(w, "<< /Length %zu >>\nstream\n", w->content_length);
+    emit(w, w->content, w->content_length);
+    emitf(w, "\nendstream\nendobj\n");
+    begin_object(w, page);
+    emitf(w, "<< /Type /Page /Parent %d 0 R /MediaBox [0 0 %.0f %.0f] /Contents %d 0 R /Resources << /Font <<",
+          PAGES_OBJECT, PDF_PAGE_WIDTH, PDF_PAGE_HEIGHT, content);
+    for (int f = 0; f < PDF_FONT_COUNT; f++) emitf(w, " /F%d %d 0 R", f + 1, FONT_OBJECT + f);
+    emitf(w, " >> >> >>\nendobj\n");
+    w->pages[w->page_count++] = page;
+    w->content_length = 0;
+    w->font = -1; // Each page starts without one
+    w->y = -1.0;
+}
+
+static void draw_table_header(PdfWriter* w);
+
+// Makes room for 'height' points, on a new page if need be.
+// Returns 1 if a new page was started.
+static int ensure(PdfWriter* w, double height) {
+    if (w->y >= 0 && w->y - height >= PDF_MARGIN) return 0;
+    finish_page(w);
+    w->y = PDF_PAGE_HEIGHT - PDF_MARGIN;
+    if (w->column_count > 0) draw_table_header(w);
+    return 1;
+}
+
+/* --- Pdf Writer Functions --- */
+
+int pdf_writer_begin(PdfWriter* w, const char* path) {
+    memset(w, 0, sizeof(*w));
+    unlink(path); // May be a link into the compile cache
+    w->out = fopen(path, "wb");
+    if (w->out == NULL) {
+        perror(path);
+        return -1;
+    }
+    w->buf = (char*)malloc(PDF_WRITER_BUFFER_SIZE);
+    if (w->buf != NULL) setvbuf(w->out, w->buf, _IOFBF, PDF_WRITER_BUFFER_SIZE);
+    w->object_capacity = 64;
+    w->page_capacity = 16;
+    w->content_capacity = 16 * 1024;
+    w->objects = (long*)malloc(sizeof(long) * (size_t)w->object_capacity);
+    w->pages = (int*)malloc(sizeof(int) * (size_t)w->page_capacity);
+    w->content = (char*)malloc(w->content_capacity);
+    if (w->objects == NULL || w->pages == NULL || w->content == NULL) {
+        fprintf(stderr, "Out of memory writing %s\n", path);
+        w->failed = 1;
+        pdf_writer_end(w);
+        return -1;
+    }
+    w->object_count = FIRST_FREE_OBJECT;
+    w->font = -1;
+    w->y = -1.0;
+
+    emit(w, "%PDF-1.4\n%\xE2\xE3\xCF\xD3\n", 15); // Binary marker, as the spec suggests
+    for (int f = 0; f < PDF_FONT_COUNT; f++) {
+        begin_object(w, FONT_OBJECT + f);
+        emitf(w, "<< /Type /Font /Subtype /Type1 /BaseFont /%s /Encoding /WinAnsiEncoding >>\nendobj\n",
+              font_names[f]);
+    }
+    return 0;
+}
+
+int pdf_writer_end(PdfWriter* w) {
+    if (w->out == NULL) return -1;
+    if (!w->failed) {
+        if (w->page_count == 0) ensure(w, 0); // An empty document still has a page
+        finish_page(w);
+    }
+    if (!w->failed) {
+        begin_object(w, PAGES_OBJECT);
+        emitf(w, "<< /Type /Pages /Count %d /Kids [", w->page_count);
+        for (int i = 0; i < w->page_count; i++) emitf(w, "%s%d 0 R", i > 0 ? " " : "", w->pages[i]);
+        emitf(w, "] >>\nendobj\n");
+        begin_object(w, CATALOG_OBJECT);
+        emitf(w, "<< /Type /Catalog /Pages %d 0 R >>\nendobj\n", PAGES_OBJECT);
+
+        long xref = w->offset;
+        emitf(w, "xref\n0 %d\n0000000000 65535 f \n", w->object_count);
+        for (int i = 1; i < w->object_count; i++) emitf(w, "%010ld 00000 n \n", w->objects[i]);
+        emitf(w, "trailer\n<< /Size %d /Root %d 0 R >>\nstartxref\n%ld\n%%%%EOF\n",
+              w->object_count, CATALOG_OBJECT, xref);
+    }
+    if (ferror(w->out)) w->failed = 1;
+    if (fclose(w->out) != 0) w->failed = 1;
+    w->out = NULL;
+    free(w->buf); // Only after fclose: stdio uses it until then
+    free(w->objects);
+    free(w->pages);
+    free(w->content);
+    free(w->text);
+    int failed = w->failed;
+    memset(w, 0, sizeof(*w));
+    if (failed) {
+        fprintf(stderr, "Failed to write PDF document\n");
+        return -1;
+    }
+    return 0;
+}
+
+void pdf_space(PdfWriter* w, double points) {
+    if (w->y >= 0 && w->y < PDF_PAGE_HEIGHT - PDF_MARGIN) w->y -= points; // Not at the top of a page
+}
+
+// Wrapped text in one font, 'lead' (bold) in front of the first line
+static void flow(PdfWriter* w, const char* lead, PdfFont font, double size, const char* text, size_t len) {
+    double line_height = size * LINE_SPACING;
+    double indent = 0.0;
+    if (lead != NULL) {
+        indent = text_width(PDF_BOLD, size, lead, strlen(lead)) + text_width(font, size, " ", 1);
+    }
+    long n = to_winansi(w, text, len);
+    if (n < 0) return;
+    size_t start = 0;
+    while (start < (size_t)n && w->text[start] == ' ') start++;
+    int first = 1;
+    do {
+        size_t end;
+        size_t next = wrap(w->text, (size_t)n, start, font, size, PDF_TEXT_WIDTH - (first ? indent : 0.0), &end);
+        ensure(w, line_height);
+        double baseline = w->y - size;
+        if (first && lead != NULL) {
+            // Converted into a scratch copy: w->text holds the paragraph
+            char lead_text[128];
+            size_t lead_len = 0;
+            for (const unsigned char* p = (const unsigned char*)lead; *p && lead_len < sizeof(lead_text); p++) {
+                lead_text[lead_len++] = *p < 0x80 ? (char)*p : '?';
+            }
+            draw_text(w, PDF_BOLD, size, PDF_MARGIN, baseline, lead_text, lead_len);
+        }
+        draw_text(w, font, size, PDF_MARGIN + (first ? indent : 0.0), baseline, w->text + start, end - start);
+        w->y -= line_height;
+        start = next;
+        first = 0;
+    } while (start < (size_t)n);
+}
+
+void pdf_heading(PdfWriter* w, const char* text, double size) {
+    pdf_space(w, size * 0.6);
+    ensure(w, size * LINE_SPACING * 2); // Not alone at the bottom of a page
+    flow(w, NULL, PDF_BOLD, size, text, strlen(text));
+    w->y -= size * 0.3;
+}
+
+void pdf_paragraph(PdfWriter* w, const char* lead, const char* text, size_t len) {
+    flow(w, lead, PDF_REGULAR, PDF_TEXT_SIZE, text, len);
+    w->y -= PDF_TEXT_SIZE * 0.6;
+}
+
+void pdf_line_lr(PdfWriter* w, const char* left, const char* right) {
+    double line_height = PDF_TEXT_SIZE * LINE_SPACING;
+    ensure(w, line_height);
+    double baseline = w->y - PDF_TEXT_SIZE;
+    long n = to_winansi(w, left, strlen(left));
+    if (n > 0) draw_text(w, PDF_REGULAR, PDF_TEXT_SIZE, PDF_MARGIN, baseline, w->text, (size_t)n);
+    n = to_winansi(w, right, strlen(right));
+    if (n > 0) {
+        double x = PDF_MARGIN + PDF_TEXT_WIDTH - text_width(PDF_REGULAR, PDF_TEXT_SIZE, w->text, (size_t)n);
+        draw_text(w, PDF_REGULAR, PDF_TEXT_SIZE, x, baseline, w->text, (size_t)n);
+    }
+    w->y -= line_height;
+}
+
+/* --- Tables --- */
+
+// Lines cell 'text' needs in a column 'width' wide
+static int cell_lines(PdfWriter* w, PdfFont font, double width, const char* text) {
+    long n = to_winansi(w, text, strlen(text));
+    if (n <= 0) return 1;
+    int lines = 0;
+    size_t start = 0, end;
+    do {
+        start = wrap(w->text, (size_t)n, start, font, PDF_TABLE_SIZE, width - 2 * CELL_PADDING, &end);
+        lines++;
+    } while (start < (size_t)n);
+    return lines;
+}
+
+static void draw_row(PdfWriter* w, PdfFont font, const char* const* cells) {
+    double line_height = PDF_TABLE_SIZE * LINE_SPACING;
+    int lines = 1;
+    for (int c = 0; c < w->column_count; c++) {
+        int l = cell_lines(w, font, w->columns[c].width, cells[c]);
+        if (l > lines) lines = l;
+    }
+    double height = lines * line_height + CELL_PADDING;
+    if (font == PDF_REGULAR) ensure(w, height); // Header rows are placed by the caller
+
+    double x = PDF_MARGIN;
+    for (int c = 0; c < w->column_count; c++) {
+        const PdfColumn* col = &w->columns[c];
+        long n = to_winansi(w, cells[c], strlen(cells[c]));
+        size_t start = 0, end;
+        double baseline = w->y - PDF_TABLE_SIZE;
+        while (n > 0 && start < (size_t)n) {
+            size_t next = wrap(w->text, (size_t)n, start, font, PDF_TABLE_SIZE, col->width - 2 * CELL_PADDING, &end);
+            double tx = x + CELL_PADDING;
+            if (col->align_right) {
+                tx = x + col->width - CELL_PADDING - text_width(font, PDF_TABLE_SIZE, w->text + start, end - start);
+            }
+            draw_text(w, font, PDF_TABLE_SIZE, tx, baseline, w->text + start, end - start);
+            baseline -= line_height;
+            start = next;
+        }
+        x += col->width;
+    }
+    w->y -= height;
+}
+
+static void draw_table_header(PdfWriter* w) {
+    const char* titles[PDF_MAX_COLUMNS];
+    for (int c = 0; c < w->column_count; c++) titles[c] = w->columns[c].title;
+    draw_row(w, PDF_BOLD, titles);
+    draw_rule(w, w->y + CELL_PADDING / 2);
+}
+
+void pdf_table_begin(PdfWriter* w, const PdfColumn* columns, int count) {
+    if (count > PDF_MAX_COLUMNS) count = PDF_MAX_COLUMNS;
+    memcpy(w->columns, columns, sizeof(PdfColumn) * (size_t)count);
+    w->column_count = 0; // No header on a page break before the first one
+    ensure(w, 3 * PDF_TABLE_SIZE * LINE_SPACING); // The header and a row
+    w->column_count = count;
+    draw_table_header(w);
+}
+
+void pdf_table_row(PdfWriter* w, const char* const* cells) {
+    draw_row(w, PDF_REGULAR, cells);
+}
+
+void pdf_table_end(PdfWriter* w) {
+    w->column_count = 0;
+    w->y -= PDF_TEXT_SIZE * 0.6;
+}
@@ -0,0 +1,98 @@
+/*
+ * compiler/pdf_writer.h
+ * Small PDF writer for the compiler's printable documents.
+ *
+ * Enough layout for a question paper and a report: headings, paragraphs
+ * that wrap, a line with text at both margins, and tables whose cells
+ * wrap and whose header row is repeated on every page. Text is set in
+ * Helvetica and Helvetica-Bold, two of the 14 fonts every PDF viewer
+ * has, so nothing is embedded and the widths needed for wrapping are
+ * compiled in. Input text is UTF-8; what WinAnsiEncoding (Latin-1 and a
+ * few punctuation marks) can't show becomes '?'.
+ *
+ * Pages are A4. Each page's content is built in memory and written as
+ * soon as the page is full, so a document of any length needs one page
+ * of memory:
+ *
+ *     pdf_writer_begin(&w, "EnhancedPaper.pdf");
+ *     pdf_heading(&w, "Compilers", PDF_TITLE_SIZE);
+ *     pdf_paragraph(&w, "Q1 (10 marks)", text, strlen(text));
+ *     pdf_writer_end(&w);
+ */
+
+#ifndef PDF_WRITER_H
+#define PDF_WRITER_H
+
+#include <stdio.h>
+#include <stddef.h>
+
+#define PDF_PAGE_WIDTH   595.0 // A4, in points
+#define PDF_PAGE_HEIGHT  842.0
+#define PDF_MARGIN       56.0  // About 2 cm all round
+#define PDF_TEXT_WIDTH   (PDF_PAGE_WIDTH - 2 * PDF_MARGIN)
+#define PDF_TITLE_SIZE   16.0
+#define PDF_HEADING_SIZE 13.0
+#define PDF_TEXT_SIZE    10.0
+#define PDF_TABLE_SIZE   8.5
+#define PDF_MAX_COLUMNS  8
+#define PDF_WRITER_BUFFER_SIZE (64 * 1024)
+
+typedef enum PdfFont {
+    PDF_REGULAR = 0, // Helvetica
+    PDF_BOLD,        // Helvetica-Bold
+    PDF_FONT_COUNT
+} PdfFont;
+
+typedef struct PdfColumn {
+    const char* title;
+    double width;    // In points; the widths should add up to PDF_TEXT_WIDTH
+    int align_right; // Numbers: 1
+} PdfColumn;
+
+typedef struct PdfWriter {
+    FILE* out;
+    char* buf;            // stdio buffer for 'out'
+    long offset;          // Bytes written so far
+    long* objects;        // File offset of each object, by number
+    int object_count;
+    int object_capacity;
+    int* pages;           // Object number of each page
+    int page_count;
+    int page_capacity;
+    char* content;        // The current page's content stream
+    size_t content_length;
+    size_t content_capacity;
+    int font;             // Font set on the current page (-1: none yet) ...
+    double font_size;     // ... and its size
+    char* text;           // Scratch: text converted to WinAnsiEncoding
+    size_t text_capacity;
+    double y;             // Top of the next line; < 0: no page started
+    PdfColumn columns[PDF_MAX_COLUMNS]; // The table being written
+    int column_count;
+    int failed;
+} PdfWriter;
+
+/* --- Pdf Writer Functions --- */
+
+// Creates 'path'. Returns 0 on success, -1 on error.
+int pdf_writer_begin(PdfWriter* w, const char* path);
+
+// Writes the page tree and cross-reference table, closes the file and
+// frees everything. Returns 0 if everything was written.
+int pdf_writer_end(PdfWriter* w);
+
+// --- Layout ---
+void pdf_heading(PdfWriter* w, const char* text, double size);
+// 'lead' (may be NULL) in bold, then 'text' (need not be NUL-terminated)
+void pdf_paragraph(PdfWriter* w, const char* lead, const char* text, size_t len);
+// One line, 'left' at the left margin and 'right' at the right one
+void pdf_line_lr(PdfWriter* w, const char* left, const char* right);
+void pdf_space(PdfWriter* w, double points);
+
+// A table with 'count' columns (at most PDF_MAX_COLUMNS); the titles
+// are the header row
+void pdf_table_begin(PdfWriter* w, const PdfColumn* columns, int count);
+void pdf_table_row(PdfWriter* w, const char* const* cells);
+void pdf_table_end(PdfWriter* w);
+
+#endif // PDF_WRITER_H
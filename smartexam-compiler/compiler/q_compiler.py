@@ -158,7 +158,8 @@ def phase6_tex_and_pdf(job_dir, semantic):
         f.write("\\section*{Analysis Report - Stub}\n")
         f.write(f"Total marks: {semantic.get('total_marks',0)}\\\\\n")
         for q in semantic["questions"]:
-            f.write(f"{q['difficulty']} - {q['text'][:120].replace('%','\\%')} ({q['marks']} marks)\\\\\n")
+            text = q['text'][:120].replace('%', '\\%')
+            f.write(f"{q['difficulty']} - {text} ({q['marks']} marks)\\\\\n")
         f.write("\\end{document}\n")
     # try to compile with pdflatex if present
     def try_pdflatex(texpath):
@@ -0,0 +1,297 @@
+/*
+ * compiler/question_bank.c
+ * Reading and updating question_bank.idx (see question_bank.h).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "question_bank.h"
+
+static size_t align8(size_t n) {
+    return (n + 7) & ~(size_t)7;
+}
+
+/* --- Reading --- */
+
+// Whether 'size' bytes at 'map' are a bank that lookups and merges can
+// index without further checks: sections inside the file and aligned,
+// job ids terminated, and every job and entry index in range
+static int bank_is_valid(const char* map, size_t size) {
+    const BankHeader* h = (const BankHeader*)map;
+    if (memcmp(h->magic, QUESTION_BANK_MAGIC, sizeof(QUESTION_BANK_MAGIC)) != 0 ||
+        h->version != QUESTION_BANK_VERSION ||
+        h->key_count != (uint64_t)h->entry_count * LSH_BANDS) {
+        return 0;
+    }
+    // Offsets are checked first so the sums below can't overflow
+    if (h->jobs_offset > size || h->entries_offset > size || h->keys_offset > size ||
+        h->jobs_offset % 8 != 0 || h->entries_offset % 8 != 0 || h->keys_offset % 8 != 0 ||
+        h->jobs_offset + (uint64_t)h->job_count * sizeof(BankJob) > size ||
+        h->entries_offset + (uint64_t)h->entry_count * sizeof(BankEntry) > size ||
+        h->keys_offset + (uint64_t)h->key_count * sizeof(BankKey) > size) {
+        return 0;
+    }
+
+    const BankJob* jobs = (const BankJob*)(map + h->jobs_offset);
+    const BankEntry* entries = (const BankEntry*)(map + h->entries_offset);
+    const BankKey* keys = (const BankKey*)(map + h->keys_offset);
+    for (uint32_t j = 0; j < h->job_count; j++) {
+        if (memchr(jobs[j].id, '\0', sizeof(jobs[j].id)) == NULL) return 0;
+    }
+    for (uint32_t e = 0; e < h->entry_count; e++) {
+        if (entries[e].job >= h->job_count) return 0;
+    }
+    for (uint32_t k = 0; k < h->key_count; k++) {
+        if (keys[k].entry >= h->entry_count) return 0;
+        if (k > 0 && keys[k].key < keys[k - 1].key) return 0; // Lookups binary search
+    }
+    return 1;
+}
+
+int question_bank_open(QuestionBank* bank, const char* path) {
+    memset(bank, 0, sizeof(*bank));
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return errno == ENOENT ? 0 : -1; // No bank yet: nothing to match
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(BankHeader)) {
+        close(fd);
+        errno = EINVAL;
+        return -1;
+    }
+    size_t size = (size_t)st.st_size;
+    void* map = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return -1;
+
+    const BankHeader* h = (const BankHeader*)map;
+    if (!bank_is_valid((const char*)map, size)) {
+        munmap(map, size);
+        errno = EINVAL;
+        return -1;
+    }
+
+    bank->header = h;
+    bank->jobs = (const BankJob*)((const char*)map + h->jobs_offset);
+    bank->entries = (const BankEntry*)((const char*)map + h->entries_offset);
+    bank->keys = (const BankKey*)((const char*)map + h->keys_offset);
+    bank->map = map;
+    bank->map_length = size;
+    return 0;
+}
+
+void question_bank_close(QuestionBank* bank) {
+    if (bank->map != NULL) {
+        munmap(bank->map, bank->map_length);
+    }
+    memset(bank, 0, sizeof(*bank));
+}
+
+// Index of the first key >= 'key'
+static uint32_t lower_bound(const BankKey* keys, uint32_t count, uint64_t key) {
+    uint32_t lo = 0, hi = count;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (keys[mid].key < key) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+int question_bank_lookup(const QuestionBank* bank, const MinHash* sig,
+                         const char* skip_job, BankMatch* match) {
+    if (bank->header == NULL) return 0;
+
+    const BankHeader* h = bank->header;
+    int found = 0;
+    match->similarity = 0.0;
+
+    for (int band = 0; band < LSH_BANDS; band++) {
+        uint64_t key = minhash_band_key(sig, band);
+        for (uint32_t k = lower_bound(bank->keys, h->key_count, key);
+             k < h->key_count && bank->keys[k].key == key; k++) {
+            const BankEntry* e = &bank->entries[bank->keys[k].entry];
+            const char* job_id = bank->jobs[e->job].id;
+            if (skip_job != NULL && strcmp(job_id, skip_job) == 0) continue;
+
+            double similarity = minhash_similarity(sig, &e->signature);
+            if (similarity >= DUPLICATE_THRESHOLD && similarity > match->similarity) {
+                match->job_id = job_id;
+                match->question = (int)e->question;
+                match->similarity = similarity;
+                found = 1;
+            }
+        }
+    }
+    return found;
+}
+
+/* --- Updating --- */
+
+static int compare_keys(const void* a, const void* b) {
+    uint64_t x = ((const BankKey*)a)->key, y = ((const BankKey*)b)->key;
+    return x < y ? -1 : x > y;
+}
+
+// Writes the merged bank to 'out': every entry of 'old' except those of
+// 'job_id', then the new job's entries
+static int write_bank(FILE* out, const QuestionBank* old, const char* job_id,
+                      const MinHash* sigs, int count) {
+    const BankHeader* oh = old->header;
+    uint32_t old_jobs = oh != NULL ? oh->job_count : 0;
+    uint32_t old_entries = oh != NULL ? oh->entry_count : 0;
+
+    // --- 1. Job table, dropping 'job_id' (it is re-added at the end) ---
+    uint32_t* job_map = (uint32_t*)malloc(sizeof(uint32_t) * (old_jobs + 1));
+    uint32_t* entry_map = (uint32_t*)malloc(sizeof(uint32_t) * (old_entries + 1));
+    BankKey* new_keys = (BankKey*)malloc(sizeof(BankKey) * ((size_t)count * LSH_BANDS + 1));
+    if (job_map == NULL || entry_map == NULL || new_keys == NULL) {
+        free(job_map);
+        free(entry_map);
+        free(new_keys);
+        return -1;
+    }
+    BankHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, QUESTION_BANK_MAGIC, sizeof(QUESTION_BANK_MAGIC));
+    h.version = QUESTION_BANK_VERSION;
+    for (uint32_t j = 0; j < old_jobs; j++) {
+        job_map[j] = strcmp(old->jobs[j].id, job_id) == 0 ? UINT32_MAX : h.job_count++;
+    }
+    uint32_t this_job = h.job_count++;
+
+    for (uint32_t e = 0; e < old_entries; e++) {
+        entry_map[e] = job_map[old->entries[e].job] == UINT32_MAX ? UINT32_MAX : h.entry_count++;
+    }
+    uint32_t first_new = h.entry_count;
+    h.entry_count += (uint32_t)count;
+    h.key_count = h.entry_count * LSH_BANDS;
+    h.jobs_offset = align8(sizeof(BankHeader));
+    h.entries_offset = h.jobs_offset + align8(sizeof(BankJob) * h.job_count);
+    h.keys_offset = h.entries_offset + align8(sizeof(BankEntry) * h.entry_count);
+
+    // --- 2. Header, jobs, entries (all sections are already 8-aligned) ---
+    fwrite(&h, sizeof(h), 1, out);
+    for (uint32_t j = 0; j < old_jobs; j++) {
+        if (job_map[j] != UINT32_MAX) fwrite(&old->jobs[j], sizeof(BankJob), 1, out);
+    }
+    BankJob job;
+    memset(&job, 0, sizeof(job));
+    strncpy(job.id, job_id, sizeof(job.id) - 1);
+    fwrite(&job, sizeof(job), 1, out);
+
+    for (uint32_t e = 0; e < old_entries; e++) {
+        if (entry_map[e] == UINT32_MAX) continue;
+        BankEntry entry = old->entries[e];
+        entry.job = job_map[entry.job];
+        fwrite(&entry, sizeof(entry), 1, out);
+    }
+    for (int i = 0; i < count; i++) {
+        BankEntry entry;
+        entry.job = this_job;
+        entry.question = (uint32_t)i + 1;
+        entry.signature = sigs[i];
+        fwrite(&entry, sizeof(entry), 1, out);
+
+        for (int band = 0; band < LSH_BANDS; band++) {
+            BankKey* k = &new_keys[(size_t)i * LSH_BANDS + band];
+            k->key = minhash_band_key(&sigs[i], band);
+            k->entry = first_new + (uint32_t)i;
+            k->reserved = 0;
+        }
+    }
+
+    // --- 3. Keys: the old ones are sorted already, so sort only the new
+    // ones and merge the two lists ---
+    size_t new_count = (size_t)count * LSH_BANDS;
+    qsort(new_keys, new_count, sizeof(BankKey), compare_keys);
+    uint32_t old_key_count = oh != NULL ? oh->key_count : 0;
+    uint32_t a = 0;
+    size_t b = 0;
+    while (a < old_key_count || b < new_count) {
+        // Skip keys of dropped entries
+        if (a < old_key_count && entry_map[old->keys[a].entry] == UINT32_MAX) {
+            a++;
+            continue;
+        }
+        BankKey k;
+        if (b == new_count || (a < old_key_count && old->keys[a].key <= new_keys[b].key)) {
+            k = old->keys[a++];
+            k.entry = entry_map[k.entry];
+        } else {
+            k = new_keys[b++];
+        }
+        fwrite(&k, sizeof(k), 1, out);
+    }
+
+    free(job_map);
+    free(entry_map);
+    free(new_keys);
+    return ferror(out) ? -1 : 0;
+}
+
+int question_bank_add_job(const char* path, const char* job_id,
+                          const MinHash* sigs, int count) {
+    // A cut-off tmp_path could be 'path' itself, and opening it would
+    // truncate the live bank
+    char lock_path[PATH_MAX], tmp_path[PATH_MAX];
+    int n = snprintf(lock_path, sizeof(lock_path), "%s.lock", path);
+    int m = snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+    if (n < 0 || (size_t)n >= sizeof(lock_path) || m < 0 || (size_t)m >= sizeof(tmp_path)) {
+        fprintf(stderr, "Error: Question bank path too long: %s\n", path);
+        return -1;
+    }
+
+    // One writer at a time (other processes and other threads alike)
+    int lock_fd = open(lock_path, O_WRONLY | O_CREAT, 0644);
+    if (lock_fd < 0 || flock(lock_fd, LOCK_EX) != 0) {
+        perror(lock_path);
+        if (lock_fd >= 0) close(lock_fd);
+        return -1;
+    }
+
+    int result = -1;
+    QuestionBank old;
+    if (question_bank_open(&old, path) != 0) {
+        if (errno != EINVAL) {
+            // Unreadable just now (permissions, out of fds or memory):
+            // the earlier jobs' questions are still in it, so leave it be
+            perror(path);
+            flock(lock_fd, LOCK_UN);
+            close(lock_fd);
+            return -1;
+        }
+        // A damaged bank is rebuilt from this job rather than failing it
+        fprintf(stderr, "Warning: Rebuilding damaged question bank %s\n", path);
+        memset(&old, 0, sizeof(old));
+    }
+
+    FILE* out = fopen(tmp_path, "wb");
+    if (out == NULL) {
+        perror(tmp_path);
+    } else {
+        result = write_bank(out, &old, job_id, sigs, count);
+        if (fclose(out) != 0) result = -1;
+        // Readers that still map the old file keep seeing it until they close
+        if (result == 0 && rename(tmp_path, path) != 0) {
+            perror(path);
+            result = -1;
+        }
+        if (result != 0) unlink(tmp_path);
+    }
+
+    question_bank_close(&old);
+    flock(lock_fd, LOCK_UN);
+    close(lock_fd);
+    return result;
+}
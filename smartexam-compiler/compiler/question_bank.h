@@ -0,0 +1,96 @@
+/*
+ * compiler/question_bank.h
+ * On-disk index of the questions of every compiled paper.
+ *
+ * After each job its MinHash signatures (see duplicates.h) are added to
+ * one shared file, by default question_bank.idx next to the job
+ * directories. The file is memory-mapped for lookups: its LSH band keys
+ * are kept sorted, so finding earlier papers that contain a question is
+ * a few binary searches, and nothing has to be parsed at start-up.
+ *
+ * Layout (native byte order, every section 8-byte aligned):
+ *     BankHeader
+ *     BankJob[job_count]        job ids
+ *     BankEntry[entry_count]    one signature per question
+ *     BankKey[key_count]        LSH_BANDS keys per entry, sorted by key
+ */
+
+#ifndef QUESTION_BANK_H
+#define QUESTION_BANK_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "duplicates.h"
+
+#define QUESTION_BANK_MAGIC   "QBANK"
+#define QUESTION_BANK_VERSION 1
+#define BANK_JOB_ID_SIZE      48 // Job ids are directory names (UUIDs)
+
+typedef struct BankHeader {
+    char magic[8];          // "QBANK"
+    uint32_t version;       // QUESTION_BANK_VERSION
+    uint32_t job_count;
+    uint32_t entry_count;
+    uint32_t key_count;     // entry_count * LSH_BANDS
+    uint64_t jobs_offset;   // Byte offsets of the sections
+    uint64_t entries_offset;
+    uint64_t keys_offset;
+} BankHeader;
+
+typedef struct BankJob {
+    char id[BANK_JOB_ID_SIZE]; // NUL-terminated
+} BankJob;
+
+typedef struct BankEntry {
+    uint32_t job;           // Index into the job table
+    uint32_t question;      // 1-based question number in that job
+    MinHash signature;
+} BankEntry;
+
+typedef struct BankKey {
+    uint64_t key;           // minhash_band_key()
+    uint32_t entry;         // Index into the entry table
+    uint32_t reserved;
+} BankKey;
+
+typedef struct QuestionBank {
+    const BankHeader* header; // NULL when the bank is empty
+    const BankJob* jobs;
+    const BankEntry* entries;
+    const BankKey* keys;
+    void* map;
+    size_t map_length;
+} QuestionBank;
+
+// Best earlier occurrence of a question
+typedef struct BankMatch {
+    const char* job_id;     // Points into the mapped file
+    int question;           // 1-based question number in that job
+    double similarity;
+} BankMatch;
+
+/* --- Question Bank Functions --- */
+
+// Maps the bank at 'path'. A missing file is an empty bank. The whole
+// file is checked once here (every index in range, keys sorted), so a
+// damaged bank is refused rather than read out of bounds later.
+// Returns 0 on success, -1 if the file exists but cannot be used
+// (errno EINVAL if it is damaged).
+int question_bank_open(QuestionBank* bank, const char* path);
+void question_bank_close(QuestionBank* bank);
+
+// Looks for a question similar to 'sig' (DUPLICATE_THRESHOLD or more)
+// in any job except 'skip_job'. Returns 1 and fills 'match' if found.
+int question_bank_lookup(const QuestionBank* bank, const MinHash* sig,
+                         const char* skip_job, BankMatch* match);
+
+// Adds (or replaces) the questions of 'job_id'. The new file is written
+// next to the old one and renamed over it, under a lock, so concurrent
+// jobs and readers always see a complete bank. A damaged bank (EINVAL
+// from question_bank_open) is started again from this job; one that
+// can't be read for any other reason is left alone and -1 returned.
+// Returns 0 on success.
+int question_bank_add_job(const char* path, const char* job_id,
+                          const MinHash* sigs, int count);
+
+#endif // QUESTION_BANK_H
@@ -0,0 +1,115 @@
+/*
+ * compiler/question_store.c
+ * Builds and aggregates the columnar question store.
+ */
+
+#include <string.h>
+#include "question_store.h"
+#include "duplicates.h"
+
+int question_store_build(QuestionStore* store, const ASTNode* root, Arena* arena) {
+    memset(store, 0, sizeof(*store));
+
+    int n = root->question_count;
+    store->count = n;
+
+    // First pass: size of the text blob
+    size_t text_size = 0;
+    for (const QuestionNode* q = root->questions; q != NULL; q = q->next) {
+        text_size += strlen(q->text) + 1;
+    }
+
+    size_t cols = n > 0 ? (size_t)n : 1;
+    store->marks = (int*)arena_alloc(arena, sizeof(int) * cols);
+    store->estimated_time = (int*)arena_alloc(arena, sizeof(int) * cols);
+    store->difficulty = (uint8_t*)arena_alloc(arena, sizeof(uint8_t) * cols);
+    store->topic = (uint16_t*)arena_alloc(arena, sizeof(uint16_t) * cols);
+    store->status = (uint8_t*)arena_alloc(arena, sizeof(uint8_t) * cols);
+    store->crispness = (uint8_t*)arena_alloc(arena, sizeof(uint8_t) * cols);
+    store->unit_count = (uint16_t*)arena_alloc(arena, sizeof(uint16_t) * cols);
+    store->units = (const uint16_t**)arena_alloc(arena, sizeof(uint16_t*) * cols);
+    store->signature = (struct MinHash*)arena_alloc(arena, sizeof(MinHash) * cols);
+    store->reused = (uint8_t*)arena_alloc(arena, sizeof(uint8_t) * cols);
+    store->text_offset = (uint32_t*)arena_alloc(arena, sizeof(uint32_t) * cols);
+    store->text_length = (uint32_t*)arena_alloc(arena, sizeof(uint32_t) * cols);
+    store->nodes = (QuestionNode**)arena_alloc(arena, sizeof(QuestionNode*) * cols);
+    store->text = (char*)arena_alloc(arena, text_size > 0 ? text_size : 1);
+    if (store->marks == NULL || store->estimated_time == NULL || store->difficulty == NULL ||
+        store->topic == NULL || store->status == NULL || store->text_offset == NULL ||
+        store->text_length == NULL || store->nodes == NULL || store->text == NULL ||
+        store->crispness == NULL || store->unit_count == NULL || store->units == NULL ||
+        store->signature == NULL || store->reused == NULL) {
+        return -1;
+    }
+    memset(store->reused, 0, sizeof(uint8_t) * cols); // Nothing reused unless incremental.c says so
+
+    // Second pass: scatter each node into the columns
+    size_t offset = 0;
+    int i = 0;
+    for (QuestionNode* q = root->questions; q != NULL && i < n; q = q->next, i++) {
+        size_t len = strlen(q->text);
+        memcpy(store->text + offset, q->text, len + 1);
+        store->text_offset[i] = (uint32_t)offset;
+        store->text_length[i] = (uint32_t)len;
+        offset += len + 1;
+
+        store->marks[i] = q->marks;
+        store->estimated_time[i] = q->estimated_time;
+        store->difficulty[i] = q->difficulty;
+        store->topic[i] = q->syllabus_topic;
+        store->status[i] = q->status_flag;
+        store->nodes[i] = q;
+    }
+    store->count = i;
+    store->text_size = offset;
+    return 0;
+}
+
+void question_store_sync_to_ast(const QuestionStore* store) {
+    for (int i = 0; i < store->count; i++) {
+        QuestionNode* q = store->nodes[i];
+        q->estimated_time = store->estimated_time[i];
+        q->difficulty = store->difficulty[i];
+        q->syllabus_topic = store->topic[i];
+        q->status_flag = store->status[i];
+    }
+}
+
+/* --- Column Aggregates --- */
+// Plain loops over one array each, with no branches or calls, so gcc can
+// vectorize them (it does at -O3; -O2 keeps them scalar).
+
+long question_store_total_marks(const QuestionStore* store) {
+    const int* marks = store->marks;
+    long total = 0;
+    for (int i = 0; i < store->count; i++) {
+        total += marks[i];
+    }
+    return total;
+}
+
+long question_store_total_time(const QuestionStore* store) {
+    const int* time = store->estimated_time;
+    long total = 0;
+    for (int i = 0; i < store->count; i++) {
+        total += time[i];
+    }
+    return total;
+}
+
+void question_store_count_difficulty(const QuestionStore* store, int* counts) {
+    // Separate counters instead of counts[d[i]]++: no data-dependent
+    // store per question, so the loop stays free of memory dependencies
+    int easy = 0, medium = 0, hard = 0, unknown = 0;
+    const uint8_t* d = store->difficulty;
+    for (int i = 0; i < store->count; i++) {
+        easy += d[i] == DIFFICULTY_EASY;
+        medium += d[i] == DIFFICULTY_MEDIUM;
+        hard += d[i] == DIFFICULTY_HARD;
+        unknown += d[i] == DIFFICULTY_UNKNOWN;
+    }
+    counts[DIFFICULTY_UNKNOWN] = unknown;
+    counts[DIFFICULTY_EASY] = easy;
+    counts[DIFFICULTY_MEDIUM] = medium;
+    counts[DIFFICULTY_HARD] = hard;
+}
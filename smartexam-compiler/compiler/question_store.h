@@ -0,0 +1,68 @@
+/*
+ * compiler/question_store.h
+ * Columnar ("struct of arrays") copy of the question list for Phase 3.
+ *
+ * The semantic passes mostly loop over one or two fields of every
+ * question (sum the marks, count difficulties, ...). Walking the linked
+ * QuestionNode list for that touches a whole node per question; here each
+ * field is its own contiguous array, so those loops read only the bytes
+ * they need, a cache line at a time.
+ *
+ * Question i of the store is the i-th node of the AST question list.
+ */
+
+#ifndef QUESTION_STORE_H
+#define QUESTION_STORE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "ast.h"
+
+struct MinHash; // duplicates.h
+
+typedef struct QuestionStore {
+    int count;
+
+    // --- Columns (each 'count' long) ---
+    int* marks;
+    int* estimated_time;
+    uint8_t* difficulty;     // Difficulty codes
+    uint16_t* topic;         // Topic ids (see ASTNode.topics)
+    uint8_t* status;         // StatusFlag codes
+
+    // --- What Phase 3 learns from each question on its own ---
+    // Saved between compiles (see incremental.h); 'reused' marks the
+    // questions whose columns were filled in from the last compile.
+    uint8_t* crispness;      // Crispness codes (semantic.c)
+    uint16_t* unit_count;    // Syllabus units the text mentions ...
+    const uint16_t** units;  // ... (units[i][0] decides its topic)
+    struct MinHash* signature; // MinHash of the text (duplicates.h)
+    uint8_t* reused;
+
+    // --- Question text ---
+    // All texts back to back in one blob, each followed by a NUL.
+    // Question i is text + text_offset[i], text_length[i] bytes long.
+    char* text;
+    size_t text_size;
+    uint32_t* text_offset;
+    uint32_t* text_length;
+
+    QuestionNode** nodes;    // nodes[i] is the AST node of question i
+} QuestionStore;
+
+/* --- Question Store Functions --- */
+
+// Fills 'store' from the AST. All memory comes from 'arena', so the
+// store is released together with the AST. Returns 0 on success.
+int question_store_build(QuestionStore* store, const ASTNode* root, Arena* arena);
+
+// Copies the annotation columns back into the AST nodes
+void question_store_sync_to_ast(const QuestionStore* store);
+
+// --- Column aggregates ---
+long question_store_total_marks(const QuestionStore* store);
+long question_store_total_time(const QuestionStore* store);
+// counts[d] = number of questions with difficulty d (DIFFICULTY_COUNT entries)
+void question_store_count_difficulty(const QuestionStore* store, int* counts);
+
+#endif // QUESTION_STORE_H
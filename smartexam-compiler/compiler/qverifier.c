@@ -0,0 +1,274 @@
+/*
+ * compiler/qverifier.c
+ * libqverifier (see qverifier.h): runs the job phases on an in-memory
+ * JobContext whose outputs go to open_memstream() buffers.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "qverifier.h"
+#include "job.h"
+
+/* --- External Functions --- */
+
+// From lexer.l (lex.yy.c)
+long lexer_tokenize(JobContext* job);
+
+#define PHASE_NOT_RUN (-1)
+
+struct QvCompiler {
+    SemanticCache cache;
+};
+
+// One output file, built in memory
+typedef struct QvOutput {
+    char* data;     // Set by open_memstream(), NUL-terminated
+    size_t length;
+    FILE* stream;   // Open while the phase writes to it
+} QvOutput;
+
+struct QvPaper {
+    QvCompiler* compiler;
+    char* source;          // The DSL text (the job's buffer gets modified)
+    size_t length;
+    char* base_dir;        // NULL: no syllabus files
+    JobContext job;
+
+    int lexed;             // Result of each phase, or PHASE_NOT_RUN
+    int parsed;
+    int exported;
+    int analyzed;
+
+    QvOutput tokens;
+    QvOutput dot;
+    QvOutput ast_json;
+    QvOutput report;
+    char error[256];
+};
+
+/* --- Helpers --- */
+
+static FILE* output_begin(QvOutput* out) {
+    free(out->data);
+    out->data = NULL;
+    out->length = 0;
+    out->stream = open_memstream(&out->data, &out->length);
+    return out->stream;
+}
+
+// Closes the stream; the text is kept only if the phase worked
+static int output_end(QvOutput* out, int ok) {
+    if (out->stream != NULL && fclose(out->stream) != 0) ok = 0;
+    out->stream = NULL;
+    if (!ok) {
+        free(out->data);
+        out->data = NULL;
+        out->length = 0;
+    }
+    return ok;
+}
+
+// JobProgressFn: remembers why a phase failed. The first message is the
+// most specific one (e.g. the parser's line number).
+static void record_failure(void* ctx, const char* phase, const char* status, const char* message) {
+    QvPaper* paper = (QvPaper*)ctx;
+    if (strcmp(status, "failed") == 0 && paper->error[0] == '\0') {
+        snprintf(paper->error, sizeof(paper->error), "%s: %s", phase, message);
+    }
+}
+
+static QvStatus fail(QvPaper* paper, QvStatus status, const char* message) {
+    snprintf(paper->error, sizeof(paper->error), "%s", message);
+    return status;
+}
+
+static const char* output_text(const QvOutput* out, size_t* length) {
+    if (length != NULL) *length = out->data != NULL ? out->length : 0;
+    return out->data;
+}
+
+/* --- Compiler --- */
+
+int qv_api_version(void) {
+    return QV_API_VERSION;
+}
+
+QvCompiler* qv_compiler_new(void) {
+    QvCompiler* compiler = (QvCompiler*)malloc(sizeof(QvCompiler));
+    if (compiler == NULL) return NULL;
+    if (semantic_cache_init(&compiler->cache) != 0) {
+        free(compiler);
+        return NULL;
+    }
+    return compiler;
+}
+
+void qv_compiler_free(QvCompiler* compiler) {
+    if (compiler == NULL) return;
+    semantic_cache_free(&compiler->cache);
+    free(compiler);
+}
+
+/* --- Papers --- */
+
+QvPaper* qv_paper_new(QvCompiler* compiler, const char* source, size_t length,
+                      const char* base_dir) {
+    QvPaper* paper = (QvPaper*)calloc(1, sizeof(QvPaper));
+    if (paper == NULL) return NULL;
+    paper->compiler = compiler;
+    paper->source = (char*)malloc(length + 1);
+    paper->base_dir = base_dir != NULL ? strdup(base_dir) : NULL;
+    if (paper->source == NULL || (base_dir != NULL && paper->base_dir == NULL)) {
+        free(paper->source);
+        free(paper->base_dir);
+        free(paper);
+        return NULL;
+    }
+    memcpy(paper->source, source, length);
+    paper->source[length] = '\0';
+    paper->length = length;
+
+    paper->lexed = paper->parsed = paper->exported = paper->analyzed = PHASE_NOT_RUN;
+
+    // Same options as "q_compiler --no-bank", but nothing goes to disk
+    job_init(&paper->job, paper->base_dir != NULL ? paper->base_dir : ".");
+    paper->job.in_memory = 1; // Not even fingerprints.bin, whatever streams are open
+    paper->job.syllabus_dir = paper->base_dir != NULL ? paper->base_dir : ""; // "": none
+    paper->job.use_bank = 0;
+    paper->job.token_formats = 0;
+    paper->job.cache = compiler != NULL ? &compiler->cache : NULL;
+    paper->job.progress = record_failure;
+    paper->job.progress_ctx = paper;
+    return paper;
+}
+
+void qv_paper_free(QvPaper* paper) {
+    if (paper == NULL) return;
+    job_cleanup(&paper->job);
+    free(paper->tokens.data);
+    free(paper->dot.data);
+    free(paper->ast_json.data);
+    free(paper->report.data);
+    free(paper->source);
+    free(paper->base_dir);
+    free(paper);
+}
+
+/* --- Phases --- */
+
+QvStatus qv_lex(QvPaper* paper) {
+    if (paper->lexed != PHASE_NOT_RUN) return (QvStatus)paper->lexed;
+    if (paper->parsed != PHASE_NOT_RUN) return QV_OK; // The parser logged the tokens
+
+    // A throwaway context: scanning writes into the source buffer, which
+    // qv_parse() still needs untouched
+    JobContext lex_job;
+    job_init(&lex_job, paper->base_dir);
+    lex_job.in_memory = 1;
+    int ok = source_from_memory(&lex_job.source, paper->source, paper->length) == 0 &&
+             (lex_job.tokens_out = output_begin(&paper->tokens)) != NULL;
+    if (ok) ok = lexer_tokenize(&lex_job) >= 0;
+    ok = output_end(&paper->tokens, ok);
+    job_cleanup(&lex_job);
+
+    paper->lexed = ok ? QV_OK : fail(paper, QV_ERROR_MEMORY, "phase1: out of memory");
+    return (QvStatus)paper->lexed;
+}
+
+QvStatus qv_parse(QvPaper* paper) {
+    if (paper->parsed != PHASE_NOT_RUN) return (QvStatus)paper->parsed;
+
+    JobContext* job = &paper->job;
+    if (source_from_memory(&job->source, paper->source, paper->length) != 0) {
+        paper->parsed = fail(paper, QV_ERROR_MEMORY, "phase1: out of memory");
+        return (QvStatus)paper->parsed;
+    }
+    // Log the tokens unless qv_lex() already did
+    int log = paper->lexed == PHASE_NOT_RUN;
+    job->tokens_out = log ? output_begin(&paper->tokens) : NULL;
+
+    int ok = job_parse(job) == 0;
+    if (log) {
+        // After a syntax error the tokens up to it are kept (that's
+        // usually what a user wants to see)
+        output_end(&paper->tokens, job->tokens_out != NULL);
+        job->tokens_out = NULL;
+        paper->lexed = QV_OK;
+    }
+    paper->parsed = ok ? QV_OK : QV_ERROR_SYNTAX;
+    return (QvStatus)paper->parsed;
+}
+
+QvStatus qv_export_dot(QvPaper* paper) {
+    if (paper->exported != PHASE_NOT_RUN) return (QvStatus)paper->exported;
+    QvStatus parsed = qv_parse(paper);
+    if (parsed != QV_OK) return parsed;
+
+    // Both forms come out of the same walk over the AST
+    JobContext* job = &paper->job;
+    job->dot_out = output_begin(&paper->dot);
+    job->ast_json_out = output_begin(&paper->ast_json);
+    int ok = job->dot_out != NULL && job->ast_json_out != NULL && job_export_ast(job) == 0;
+    ok = output_end(&paper->dot, ok);
+    ok = output_end(&paper->ast_json, ok);
+    if (!ok) output_end(&paper->dot, 0); // Keep both or neither
+    job->dot_out = NULL;
+    job->ast_json_out = NULL;
+
+    paper->exported = ok ? QV_OK : fail(paper, QV_ERROR_MEMORY, "phase2: out of memory");
+    return (QvStatus)paper->exported;
+}
+
+QvStatus qv_analyze(QvPaper* paper) {
+    if (paper->analyzed != PHASE_NOT_RUN) return (QvStatus)paper->analyzed;
+    QvStatus parsed = qv_parse(paper);
+    if (parsed != QV_OK) return parsed;
+
+    JobContext* job = &paper->job;
+    job->report_out = output_begin(&paper->report);
+    int ok;
+    if (job->report_out == NULL) {
+        ok = 0;
+        fail(paper, QV_ERROR_MEMORY, "phase3: out of memory");
+    } else {
+        ok = job_analyze(job) == 0; // Sets the error message itself
+    }
+    ok = output_end(&paper->report, ok);
+    job->report_out = NULL;
+
+    paper->analyzed = ok ? QV_OK : QV_ERROR_PHASE;
+    return (QvStatus)paper->analyzed;
+}
+
+QvStatus qv_compile(QvPaper* paper) {
+    QvStatus status = qv_export_dot(paper); // Parses first
+    if (status != QV_OK) return status;
+    return qv_analyze(paper);
+}
+
+/* --- Results --- */
+
+const char* qv_tokens_json(const QvPaper* paper, size_t* length) {
+    return output_text(&paper->tokens, length);
+}
+
+const char* qv_ast_dot(const QvPaper* paper, size_t* length) {
+    return output_text(&paper->dot, length);
+}
+
+const char* qv_ast_json(const QvPaper* paper, size_t* length) {
+    return output_text(&paper->ast_json, length);
+}
+
+const char* qv_report_json(const QvPaper* paper, size_t* length) {
+    return output_text(&paper->report, length);
+}
+
+int qv_question_count(const QvPaper* paper) {
+    return paper->parsed == QV_OK ? paper->job.root->question_count : -1;
+}
+
+const char* qv_error(const QvPaper* paper) {
+    return paper->error;
+}
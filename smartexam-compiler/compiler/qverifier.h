@@ -0,0 +1,105 @@
+/*
+ * compiler/qverifier.h
+ * libqverifier: the compiler as a library (libqverifier.so).
+ *
+ * q_compiler reads input.qp from a job directory and writes its results
+ * there. The library runs the same phases on a DSL string in memory and
+ * hands the results back as strings, so a web server can compile a paper
+ * without starting a process or touching the disk:
+ *
+ *     QvCompiler* c = qv_compiler_new();        // once per process
+ *     QvPaper* p = qv_paper_new(c, dsl, strlen(dsl), NULL);
+ *     if (qv_compile(p) == QV_OK) {
+ *         puts(qv_report_json(p, NULL));        // semantic_report.json
+ *     } else {
+ *         puts(qv_error(p));
+ *     }
+ *     qv_paper_free(p);
+ *     qv_compiler_free(c);
+ *
+ * A QvCompiler keeps the keyword automata and compiled syllabi warm and
+ * may be shared by any number of threads. A QvPaper belongs to one thread
+ * at a time. The library does not check or update the question bank.
+ *
+ * Only the functions below are part of the API; the layout of the two
+ * structs is private, so it can change without breaking callers.
+ * analysis/qverifier.py is the Python binding.
+ */
+
+#ifndef QVERIFIER_H
+#define QVERIFIER_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Bumped whenever a function is added or changed
+#define QV_API_VERSION 3
+
+typedef struct QvCompiler QvCompiler;
+typedef struct QvPaper QvPaper;
+
+// Return codes
+typedef enum QvStatus {
+    QV_OK = 0,
+    QV_ERROR_MEMORY = 1,   // Out of memory
+    QV_ERROR_SYNTAX = 2,   // The DSL could not be parsed
+    QV_ERROR_PHASE = 3     // A later phase failed (see qv_error())
+} QvStatus;
+
+int qv_api_version(void);
+
+/* --- Compiler --- */
+
+// Returns NULL if out of memory
+QvCompiler* qv_compiler_new(void);
+// Every paper made with it must be freed first
+void qv_compiler_free(QvCompiler* compiler);
+
+/* --- Papers --- */
+
+// Copies 'length' bytes of DSL text. SYLLABUS_PATH must be a bare file
+// name in 'base_dir'; other paths are ignored, so DSL from anyone can't
+// read files elsewhere. With 'base_dir' NULL no syllabus file is read
+// (the built-in topics are used). Since version 3.
+// Returns NULL if out of memory.
+QvPaper* qv_paper_new(QvCompiler* compiler, const char* source, size_t length,
+                      const char* base_dir);
+void qv_paper_free(QvPaper* paper);
+
+// --- Phases ---
+// Each runs at most once per paper; running it again returns the first
+// result. Later phases run the earlier ones they need.
+
+// Phase 1 alone: tokens only, even if the paper has syntax errors
+QvStatus qv_lex(QvPaper* paper);
+// Phases 1 & 2: tokens and the AST
+QvStatus qv_parse(QvPaper* paper);
+// Phase 3: the semantic report
+QvStatus qv_analyze(QvPaper* paper);
+// The AST as Graphviz DOT (ast.dot) and as JSON (ast.json)
+QvStatus qv_export_dot(QvPaper* paper);
+// All of the above, like q_compiler does for a job directory
+QvStatus qv_compile(QvPaper* paper);
+
+// --- Results ---
+// NUL-terminated strings owned by the paper, or NULL if that phase has
+// not run successfully. 'length' (may be NULL) receives the size.
+const char* qv_tokens_json(const QvPaper* paper, size_t* length);
+const char* qv_ast_dot(const QvPaper* paper, size_t* length);
+const char* qv_ast_json(const QvPaper* paper, size_t* length);  // Since version 2
+const char* qv_report_json(const QvPaper* paper, size_t* length);
+
+// Number of questions, or -1 before a successful qv_parse()
+int qv_question_count(const QvPaper* paper);
+
+// What went wrong in the last failed phase ("" if nothing failed)
+const char* qv_error(const QvPaper* paper);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // QVERIFIER_H
@@ -1,60 +1,769 @@
-/*
- * semantic.c - Optional C semantic analysis integration for SmartExam Compiler
- * You can compile this via: gcc -c semantic.c
- * Intended for use in the Yacc actions or as a validation utility
- */
-
-#include <stdio.h>
-#include <stdlib.h>
-#include <string.h>
-
-// Example structure for a parsed question
-typedef struct Question {
-    int number;
-    char text[256];
-    int marks;
-    char difficulty[16];
-    struct Question *next;
-} Question;
-
-// Validate sum of marks (very basic example)
-int validate_marks(Question *head, int declared_total) {
-    int sum = 0;
-    Question *ptr = head;
-    while (ptr) {
-        sum += ptr->marks;
-        ptr = ptr->next;
-    }
-    if (sum == declared_total) {
-        printf("PASS: Marks sum matches declared total (%d)\n", declared_total);
-        return 1;
-    } else {
-        printf("FAIL: Marks sum %d does not match declared total %d\n", sum, declared_total);
-        return 0;
-    }
-}
-
-// Classify difficulty (very basic, keyword-based)
-const char* classify_difficulty(const char *text) {
-    if (strstr(text, "define") || strstr(text, "state"))
-        return "EASY";
-    if (strstr(text, "explain") || strstr(text, "prove"))
-        return "MEDIUM";
-    if (strstr(text, "design") || strstr(text, "construct") || strstr(text, "optimize"))
-        return "HARD";
-    return "MEDIUM"; // Default
-}
-
-// Example usage
-int main() {
-    Question q1 = {1, "Define compiler and interpreter.", 10, "", NULL};
-    Question q2 = {2, "Explain the phases of compiler design.", 10, "", NULL};
-    Question q3 = {3, "Construct DFA for (a|b)*abb.", 12, "", NULL};
-    q1.next = &q2;
-    q2.next = &q3;
-    int declared_total = 32;
-    validate_marks(&q1, declared_total);
-    printf("Q1 difficulty: %s\n", classify_difficulty(q1.text));
-    printf("Q3 difficulty: %s\n", classify_difficulty(q3.text));
-    return 0;
-}
\ No newline at end of file
+/*
+ * semantic.c - C semantic analysis for SmartExam Compiler (Phase 3)
+ * The checks run on the columnar QuestionStore (question_store.h)
+ * rather than walking the AST's linked list.
+ *
+ * The rules follow analysis/semantic_analysis.py, so the report has the
+ * same keys and numbers the Python version produced.
+ */
+
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "semantic.h"
+#include "json_writer.h"
+#include "syllabus.h"
+#include "duplicates.h"
+#include "question_bank.h"
+
+/* --- Keyword Tables --- */
+// Same lists as analysis/semantic_analysis.py
+
+static const char* const easy_keywords[] = {
+    "define", "state", "list", "identify", "name", "mention", "label", "write", NULL
+};
+static const char* const medium_keywords[] = {
+    "explain", "prove", "derive", "compare", "discuss", "describe", "illustrate",
+    "differentiate", "outline", NULL
+};
+static const char* const hard_keywords[] = {
+    "design", "construct", "develop", "implement", "optimize", "synthesize",
+    "analyze", "evaluate", "create", "formulate", NULL
+};
+
+// Words that make a question ambiguous
+static const char* const unclear_terms[] = {
+    "something", "anything", "etc", "and so on", NULL
+};
+
+#define VERBOSE_WORD_LIMIT 100 // More words than this is "VERBOSE"
+
+// Case-insensitive substring search ('keyword' must be lower case)
+static int contains_keyword(const char* text, const char* keyword) {
+    size_t klen = strlen(keyword);
+    for (const char* p = text; *p != '\0'; p++) {
+        size_t i = 0;
+        while (i < klen && tolower((unsigned char)p[i]) == keyword[i]) {
+            i++;
+        }
+        if (i == klen) return 1;
+    }
+    return 0;
+}
+
+// Returns the index of the first keyword found in 'text', or -1
+static int find_keyword(const char* text, const char* const* keywords) {
+    for (int i = 0; keywords[i] != NULL; i++) {
+        if (contains_keyword(text, keywords[i])) return i;
+    }
+    return -1;
+}
+
+/* --- Per-Question Checks --- */
+
+// Validate sum of marks (very basic example)
+int validate_marks(const QuestionStore* store, int declared_total) {
+    // A single pass over the contiguous marks column
+    long sum = question_store_total_marks(store);
+    if (sum == declared_total) {
+        printf("PASS: Marks sum matches declared total (%d)\n", declared_total);
+        return 1;
+    } else {
+        printf("FAIL: Marks sum %ld does not match declared total %d\n", sum, declared_total);
+        return 0;
+    }
+}
+
+// Compiles the three keyword lists into one automaton; each keyword's
+// value is its Difficulty
+int difficulty_matcher_build(KeywordMatcher* m, Arena* arena) {
+    static const char* const* const lists[DIFFICULTY_COUNT] = {
+        NULL, easy_keywords, medium_keywords, hard_keywords
+    };
+    keyword_matcher_init(m, arena);
+    for (int d = DIFFICULTY_EASY; d < DIFFICULTY_COUNT; d++) {
+        for (int i = 0; lists[d][i] != NULL; i++) {
+            if (keyword_matcher_add(m, lists[d][i], d) != 0) return -1;
+        }
+    }
+    return keyword_matcher_build(m);
+}
+
+// Classify difficulty (keyword-based). Hard words win over medium ones,
+// medium over easy; a question with none of them counts as medium.
+// One pass over the text finds the keywords of all three lists.
+Difficulty classify_difficulty(const KeywordMatcher* m, const char* text, size_t len) {
+    unsigned int found = keyword_matcher_classes(m, text, len);
+    if (found & (1u << DIFFICULTY_HARD))
+        return DIFFICULTY_HARD;
+    if (found & (1u << DIFFICULTY_MEDIUM))
+        return DIFFICULTY_MEDIUM;
+    if (found & (1u << DIFFICULTY_EASY))
+        return DIFFICULTY_EASY;
+    return DIFFICULTY_MEDIUM; // Default
+}
+
+int estimate_question_time(int marks, Difficulty difficulty) {
+    // 2/3/4 minutes per mark by difficulty, plus 10%, rounded. The Python
+    // version applied this to the paper total; per question the report,
+    // the optimizer and synthesis all add up the same numbers.
+    static const int minutes_per_mark[DIFFICULTY_COUNT] = { 3, 2, 3, 4 }; // Indexed by Difficulty
+    int minutes = (marks * minutes_per_mark[difficulty] * 11 + 5) / 10;
+    return minutes < 1 ? 1 : minutes;
+}
+
+/* --- Crispness --- */
+
+typedef enum {
+    CRISP = 0,
+    VERBOSE,
+    AMBIGUOUS
+} Crispness;
+
+static const char* const crispness_names[] = { "CRISP", "VERBOSE", "AMBIGUOUS" };
+
+static int count_words(const char* text, size_t len) {
+    int words = 0;
+    int in_word = 0;
+    for (size_t i = 0; i < len; i++) {
+        int space = isspace((unsigned char)text[i]);
+        if (!space && !in_word) words++;
+        in_word = !space;
+    }
+    return words;
+}
+
+static Crispness classify_crispness(const char* text, size_t len) {
+    if (count_words(text, len) > VERBOSE_WORD_LIMIT) return VERBOSE;
+    if (find_keyword(text, unclear_terms) >= 0) return AMBIGUOUS;
+    return CRISP;
+}
+
+/* --- Paper-Level Results --- */
+
+// Everything the report needs besides the per-question columns
+typedef struct SemanticSummary {
+    long marks_total;
+    int marks_ok;
+
+    long time_needed;      // Paper-level estimate in minutes
+    int time_difference;
+    int time_ok;
+
+    int difficulty_counts[DIFFICULTY_COUNT];
+    int balanced;
+
+    const SyllabusCoverage* coverage;
+    int* duplicate_of;     // Earlier question this one repeats, or -1
+    int duplicate_count;
+    BankMatch* bank_match; // Earlier paper with this question (job_id NULL if none)
+    int bank_checked;      // Was a question bank available?
+    int reused_count;
+    int crispness_counts[3];
+    double crisp_percentage;
+
+    int score;             // Overall "crispness score", 0-100
+} SemanticSummary;
+
+// round(part / total * 100, 1) in Python
+static double percentage(int part, int total) {
+    if (total <= 0) return 0.0;
+    // printf rounds the exact binary value, just like Python's round()
+    char text[32];
+    snprintf(text, sizeof(text), "%.1f", (double)part / total * 100.0);
+    return strtod(text, NULL);
+}
+
+static int in_band(int part, int total, double low, double high) {
+    double ratio = (double)part / total;
+    return ratio >= low && ratio <= high;
+}
+
+static void summarize(const QuestionStore* store, int declared_marks, int declared_time,
+                      SemanticSummary* s) {
+    int n = store->count;
+
+    s->marks_total = question_store_total_marks(store);
+    s->marks_ok = declared_marks > 0 ? validate_marks(store, declared_marks) : 1;
+
+    s->time_needed = question_store_total_time(store); // See estimate_question_time()
+    s->time_difference = (int)labs(s->time_needed - declared_time);
+    s->time_ok = declared_time > 0 ? s->time_difference <= TIME_TOLERANCE : 1;
+
+    question_store_count_difficulty(store, s->difficulty_counts);
+    s->balanced = n > 0 &&
+        in_band(s->difficulty_counts[DIFFICULTY_EASY], n, 0.2, 0.4) &&
+        in_band(s->difficulty_counts[DIFFICULTY_MEDIUM], n, 0.4, 0.6) &&
+        in_band(s->difficulty_counts[DIFFICULTY_HARD], n, 0.1, 0.3);
+
+    for (int i = 0; i < n; i++) {
+        s->crispness_counts[store->crispness[i]]++;
+    }
+    s->crisp_percentage = percentage(s->crispness_counts[CRISP], n);
+
+    s->score = 100;
+    if (!s->marks_ok) s->score -= 20;
+    if (!s->time_ok) s->score -= 10;
+    if (!s->balanced) s->score -= 15;
+    s->score -= (int)((100.0 - s->crisp_percentage) * 0.3);
+    if (s->score < 0) s->score = 0;
+}
+
+/* --- Report Output --- */
+
+// Unclassified questions count as MEDIUM, like the Python default
+static const char* const difficulty_codes[DIFFICULTY_COUNT] = { "MEDIUM", "EASY", "MEDIUM", "HARD" };
+
+static void write_status(JsonWriter* w, int ok, const char* not_ok) {
+    json_key(w, "status");
+    json_string(w, ok ? "PASS" : not_ok);
+}
+
+static void write_questions(JsonWriter* w, const ASTNode* root, const QuestionStore* store,
+                            const SemanticSummary* s) {
+    json_key(w, "questions");
+    json_begin_array(w);
+    for (int i = 0; i < store->count; i++) {
+        json_begin_object(w);
+        json_key(w, "text");
+        json_string_n(w, store->text + store->text_offset[i], store->text_length[i]);
+        json_key(w, "marks");
+        json_int(w, store->marks[i]);
+        json_key(w, "difficulty");
+        json_string(w, difficulty_codes[store->difficulty[i]]);
+        json_key(w, "estimated_time");
+        json_int(w, store->estimated_time[i]);
+        json_key(w, "syllabus_topic");
+        json_string(w, topic_name(&root->topics, store->topic[i]));
+        json_key(w, "status_flag");
+        json_int(w, store->status[i]);
+        if (s->duplicate_of[i] >= 0) {
+            json_key(w, "duplicate_of"); // Question number, counting from 1
+            json_int(w, s->duplicate_of[i] + 1);
+        }
+        const BankMatch* m = &s->bank_match[i];
+        if (m->job_id != NULL) {
+            json_key(w, "bank_match");
+            json_begin_object(w);
+            json_key(w, "job_id");
+            json_string(w, m->job_id);
+            json_key(w, "question");
+            json_int(w, m->question);
+            json_key(w, "similarity");
+            json_double(w, m->similarity * 100.0); // Percent
+            json_end_object(w);
+        }
+        json_key(w, "crispness");
+        json_string(w, crispness_names[store->crispness[i]]);
+        json_end_object(w);
+    }
+    json_end_array(w);
+}
+
+static void write_coverage(JsonWriter* w, const ASTNode* root, const SyllabusCoverage* coverage) {
+    const Syllabus* syllabus = coverage->syllabus;
+    json_key(w, "syllabus_coverage");
+    json_begin_object(w);
+    if (!syllabus->loaded) {
+        json_key(w, "status");
+        json_string(w, "SKIP");
+        json_key(w, "message");
+        json_string(w, "No syllabus information available");
+        json_end_object(w);
+        return;
+    }
+
+    int units = syllabus->unit_count;
+    int covered = syllabus_covered_count(coverage);
+    double percent = percentage(covered, units);
+    char message[64];
+
+    write_status(w, percent >= 70.0, "WARN");
+    for (int pass = 1; pass >= 0; pass--) {
+        json_key(w, pass ? "covered_topics" : "uncovered_topics");
+        json_begin_array(w);
+        for (int u = 0; u < units; u++) {
+            if (syllabus_is_covered(coverage, u) == pass) {
+                json_string(w, topic_name(&root->topics, coverage->unit_topic[u]));
+            }
+        }
+        json_end_array(w);
+    }
+    json_key(w, "coverage_percentage");
+    json_double(w, percent);
+    json_key(w, "message");
+    snprintf(message, sizeof(message), "%d/%d topics covered", covered, units);
+    json_string(w, message);
+    json_end_object(w);
+}
+
+static void write_checks(JsonWriter* w, const ASTNode* root, const QuestionStore* store,
+                         const SemanticSummary* s) {
+    char message[128];
+    int n = store->count;
+    const int* counts = s->difficulty_counts;
+
+    json_key(w, "checks");
+    json_begin_object(w);
+
+    json_key(w, "marks_validation");
+    json_begin_object(w);
+    write_status(w, s->marks_ok, "FAIL");
+    json_key(w, "calculated_total");
+    json_int(w, s->marks_total);
+    json_key(w, "declared_total");
+    json_int(w, root->total_marks);
+    json_key(w, "difference");
+    json_int(w, labs(s->marks_total - root->total_marks));
+    json_key(w, "message");
+    if (s->marks_ok) {
+        json_string(w, "Marks sum matches declared total");
+    } else {
+        snprintf(message, sizeof(message), "Marks mismatch: %ld marks difference",
+                 labs(s->marks_total - root->total_marks));
+        json_string(w, message);
+    }
+    json_end_object(w);
+
+    json_key(w, "time_estimation");
+    json_begin_object(w);
+    write_status(w, s->time_ok, "WARN");
+    json_key(w, "estimated_time");
+    json_int(w, s->time_needed);
+    json_key(w, "declared_time");
+    json_int(w, root->total_time);
+    json_key(w, "difference");
+    json_int(w, s->time_difference);
+    json_key(w, "message");
+    snprintf(message, sizeof(message), "Estimated time: %ld minutes vs declared: %d minutes",
+             s->time_needed, root->total_time);
+    json_string(w, message);
+    json_end_object(w);
+
+    json_key(w, "difficulty_distribution");
+    json_begin_object(w);
+    write_status(w, s->balanced, "WARN");
+    json_key(w, "easy_count");
+    json_int(w, counts[DIFFICULTY_EASY]);
+    json_key(w, "medium_count");
+    json_int(w, counts[DIFFICULTY_MEDIUM]);
+    json_key(w, "hard_count");
+    json_int(w, counts[DIFFICULTY_HARD]);
+    json_key(w, "easy_percentage");
+    json_double(w, percentage(counts[DIFFICULTY_EASY], n));
+    json_key(w, "medium_percentage");
+    json_double(w, percentage(counts[DIFFICULTY_MEDIUM], n));
+    json_key(w, "hard_percentage");
+    json_double(w, percentage(counts[DIFFICULTY_HARD], n));
+    json_key(w, "message");
+    json_string(w, s->balanced ? "Difficulty distribution is balanced"
+                               : "Difficulty distribution needs improvement");
+    json_end_object(w);
+
+    write_coverage(w, root, s->coverage);
+
+    json_key(w, "duplicate_detection");
+    json_begin_object(w);
+    write_status(w, s->duplicate_count == 0, "WARN");
+    json_key(w, "duplicate_count");
+    json_int(w, s->duplicate_count);
+    json_key(w, "message");
+    snprintf(message, sizeof(message), "%d near-duplicate question(s) found", s->duplicate_count);
+    json_string(w, message);
+    json_end_object(w);
+
+    json_key(w, "question_bank");
+    json_begin_object(w);
+    if (!s->bank_checked) {
+        json_key(w, "status");
+        json_string(w, "SKIP");
+        json_key(w, "message");
+        json_string(w, "No question bank available");
+    } else {
+        write_status(w, s->reused_count == 0, "WARN");
+        json_key(w, "reused_count");
+        json_int(w, s->reused_count);
+        json_key(w, "message");
+        snprintf(message, sizeof(message), "%d question(s) appeared in earlier papers", s->reused_count);
+        json_string(w, message);
+    }
+    json_end_object(w);
+
+    json_key(w, "crispness_analysis");
+    json_begin_object(w);
+    write_status(w, s->crisp_percentage >= 70.0, "WARN");
+    json_key(w, "crisp_count");
+    json_int(w, s->crispness_counts[CRISP]);
+    json_key(w, "verbose_count");
+    json_int(w, s->crispness_counts[VERBOSE]);
+    json_key(w, "ambiguous_count");
+    json_int(w, s->crispness_counts[AMBIGUOUS]);
+    json_key(w, "crispness_percentage");
+    json_double(w, s->crisp_percentage);
+    json_key(w, "message");
+    snprintf(message, sizeof(message), "%d/%d questions are crisp and clear",
+             s->crispness_counts[CRISP], n);
+    json_string(w, message);
+    json_end_object(w);
+
+    json_end_object(w);
+}
+
+static void write_statistics(JsonWriter* w, const ASTNode* root, const QuestionStore* store,
+                             const SemanticSummary* s) {
+    json_key(w, "statistics");
+    json_begin_object(w);
+    json_key(w, "total_questions");
+    json_int(w, store->count);
+    json_key(w, "total_marks_calculated");
+    json_int(w, s->marks_total);
+    json_key(w, "total_marks_declared");
+    json_int(w, root->total_marks);
+    json_key(w, "estimated_time_minutes");
+    json_int(w, s->time_needed);
+    json_key(w, "declared_time_minutes");
+    json_int(w, root->total_time);
+    json_key(w, "difficulty_easy_count");
+    json_int(w, s->difficulty_counts[DIFFICULTY_EASY]);
+    json_key(w, "difficulty_medium_count");
+    json_int(w, s->difficulty_counts[DIFFICULTY_MEDIUM]);
+    json_key(w, "difficulty_hard_count");
+    json_int(w, s->difficulty_counts[DIFFICULTY_HARD]);
+    json_end_object(w);
+}
+
+// Same wording as generate_warnings_and_suggestions() in the Python version
+static void write_advice(JsonWriter* w, const ASTNode* root, const QuestionStore* store,
+                         const SemanticSummary* s) {
+    char message[128];
+    int n = store->count;
+
+    json_key(w, "warnings");
+    json_begin_array(w);
+    if (!s->marks_ok) {
+        snprintf(message, sizeof(message), "Marks sum mismatch: Marks mismatch: %ld marks difference",
+                 labs(s->marks_total - root->total_marks));
+        json_string(w, message);
+    }
+    if (s->time_difference > TIME_TOLERANCE) {
+        snprintf(message, sizeof(message), "Time allocation mismatch: %d minutes difference",
+                 s->time_difference);
+        json_string(w, message);
+    }
+    if (s->duplicate_count > 0) {
+        snprintf(message, sizeof(message), "%d question(s) repeat an earlier question",
+                 s->duplicate_count);
+        json_string(w, message);
+    }
+    if (s->reused_count > 0) {
+        snprintf(message, sizeof(message), "%d question(s) were used in earlier papers",
+                 s->reused_count);
+        json_string(w, message);
+    }
+    json_end_array(w);
+
+    json_key(w, "suggestions");
+    json_begin_array(w);
+    if (!s->marks_ok) {
+        json_string(w, "Review and correct the marks allocation to match the declared total");
+    }
+    if (s->time_difference > TIME_TOLERANCE) {
+        json_string(w, s->time_needed > root->total_time
+                           ? "Consider increasing allotted time or reducing question complexity"
+                           : "Consider adding more questions or increasing difficulty");
+    }
+    if (!s->balanced) {
+        double easy = percentage(s->difficulty_counts[DIFFICULTY_EASY], n);
+        double hard = percentage(s->difficulty_counts[DIFFICULTY_HARD], n);
+        if (easy < 20) json_string(w, "Add more easy-level questions (define, state, list)");
+        if (easy > 40) json_string(w, "Reduce easy-level questions and add more challenging ones");
+        if (hard < 10) json_string(w, "Add more hard-level questions (design, construct, analyze)");
+        if (hard > 30) json_string(w, "Reduce hard-level questions for better balance");
+    }
+    if (s->duplicate_count > 0) {
+        snprintf(message, sizeof(message), "Remove or reword %d duplicate question(s)", s->duplicate_count);
+        json_string(w, message);
+    }
+    if (s->crispness_counts[VERBOSE] > 0) {
+        snprintf(message, sizeof(message), "Simplify %d verbose question(s)", s->crispness_counts[VERBOSE]);
+        json_string(w, message);
+    }
+    if (s->crispness_counts[AMBIGUOUS] > 0) {
+        snprintf(message, sizeof(message), "Clarify %d ambiguous question(s)", s->crispness_counts[AMBIGUOUS]);
+        json_string(w, message);
+    }
+    json_end_array(w);
+}
+
+// Writes to 'out' if set (and closes it), otherwise creates 'path'
+static int write_report(const char* path, FILE* out, const ASTNode* root,
+                        const QuestionStore* store, const SemanticSummary* s) {
+    JsonWriter w;
+    int opened = out != NULL ? json_writer_open_stream(&w, out) : json_writer_open(&w, path);
+    if (opened != 0) return -1;
+
+    json_begin_object(&w);
+    json_key(&w, "subject");
+    json_string(&w, root->subject);
+    json_key(&w, "total_marks");
+    json_int(&w, root->total_marks);
+    json_key(&w, "total_time");
+    json_int(&w, question_store_total_time(store));
+    json_key(&w, "time_minutes");
+    json_int(&w, root->total_time);
+    json_key(&w, "syllabus");
+    json_string(&w, root->syllabus_path);
+    write_questions(&w, root, store, s);
+    write_checks(&w, root, store, s);
+    write_statistics(&w, root, store, s);
+    write_advice(&w, root, store, s);
+    json_key(&w, "crispness_score");
+    json_int(&w, s->score);
+    json_end_object(&w);
+
+    return json_writer_close(&w);
+}
+
+/* --- Phase 3 Entry Point --- */
+
+// The job id is the job directory's name ("jobs/<uuid>" -> "<uuid>")
+static const char* job_id_of(const char* job_dir, char* buf, size_t size) {
+    size_t len = strlen(job_dir);
+    while (len > 1 && job_dir[len - 1] == '/') len--; // "jobs/abc/"
+    size_t start = len;
+    while (start > 0 && job_dir[start - 1] != '/') start--;
+    snprintf(buf, size, "%.*s", (int)(len - start), job_dir + start);
+    return buf;
+}
+
+// Marks questions that already appeared in other jobs' papers
+static void check_question_bank(const char* bank_path, const char* job_id, const MinHash* sigs,
+                                QuestionStore* store, Arena* arena, SemanticSummary* s) {
+    QuestionBank bank;
+    if (question_bank_open(&bank, bank_path) != 0) {
+        printf("Warning: Cannot read question bank %s\n", bank_path);
+        return;
+    }
+    for (int i = 0; i < store->count; i++) {
+        BankMatch match;
+        if (question_bank_lookup(&bank, &sigs[i], job_id, &match)) {
+            // The id points into the mapping, which is closed below
+            match.job_id = arena_strdup(arena, match.job_id);
+            if (match.job_id == NULL) break;
+            s->bank_match[i] = match;
+            s->reused_count++;
+            store->status[i] = STATUS_DUPLICATE;
+        }
+    }
+    question_bank_close(&bank);
+    s->bank_checked = 1;
+}
+
+/* --- Semantic Cache --- */
+
+#define SEMANTIC_CACHE_MAX_SYLLABI 64
+
+static uint64_t hash_text(const char* text, size_t len) {
+    uint64_t h = 14695981039346656037ull; // FNV-1a
+    for (size_t i = 0; i < len; i++) {
+        h ^= (unsigned char)text[i];
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+int semantic_cache_init(SemanticCache* cache) {
+    memset(cache, 0, sizeof(*cache));
+    arena_init(&cache->arena);
+    pthread_mutex_init(&cache->lock, NULL);
+    if (difficulty_matcher_build(&cache->difficulty, &cache->arena) != 0 ||
+        syllabus_use_defaults(&cache->default_syllabus, &cache->arena) != 0) {
+        semantic_cache_free(cache);
+        return -1;
+    }
+    return 0;
+}
+
+void semantic_cache_free(SemanticCache* cache) {
+    pthread_mutex_destroy(&cache->lock);
+    arena_free(&cache->arena);
+    cache->syllabi = NULL;
+    cache->syllabus_count = 0;
+}
+
+// Compiled syllabus for 'text', from the cache if the same file was seen
+// before. Returns NULL if it is not cached and the cache is full.
+static const Syllabus* cached_syllabus(SemanticCache* cache, const char* text, size_t len) {
+    uint64_t hash = hash_text(text, len);
+    const Syllabus* found = NULL;
+
+    pthread_mutex_lock(&cache->lock);
+    for (CachedSyllabus* c = cache->syllabi; c != NULL; c = c->next) {
+        // FNV-1a collisions are easy to make on purpose, so compare the text
+        if (c->hash == hash && c->length == len && memcmp(c->text, text, len) == 0) {
+            found = &c->syllabus;
+            break;
+        }
+    }
+    if (found == NULL && cache->syllabus_count < SEMANTIC_CACHE_MAX_SYLLABI) {
+        CachedSyllabus* c = (CachedSyllabus*)arena_alloc(&cache->arena, sizeof(CachedSyllabus));
+        char* copy = (char*)arena_alloc(&cache->arena, len + 1);
+        if (c != NULL && copy != NULL &&
+            syllabus_compile(&c->syllabus, text, len, &cache->arena) == 0) {
+            memcpy(copy, text, len);
+            c->hash = hash;
+            c->length = len;
+            c->text = copy;
+            c->next = cache->syllabi;
+            cache->syllabi = c;
+            cache->syllabus_count++;
+            found = &c->syllabus;
+        }
+    }
+    pthread_mutex_unlock(&cache->lock);
+    return found;
+}
+
+// The header's SYLLABUS_PATH decides which topics are in syllabus.
+// Falls back to the built-in topics if it can't be read.
+// With 'syllabus_dir' set, it is only looked for there (see
+// syllabus_open_in_dir()).
+static const Syllabus* get_syllabus(const ASTNode* root, const char* job_dir,
+                                    const char* syllabus_dir, SemanticCache* cache,
+                                    Syllabus* local) {
+    const Syllabus* syllabus = NULL;
+    SourceBuffer file;
+    int opened = syllabus_dir != NULL
+        ? syllabus_open_in_dir(&file, root->syllabus_path, syllabus_dir)
+        : syllabus_open_file(&file, root->syllabus_path, job_dir);
+    if (opened == 0) {
+        if (cache != NULL) {
+            syllabus = cached_syllabus(cache, file.data, file.length);
+        }
+        if (syllabus == NULL && syllabus_compile(local, file.data, file.length, root->arena) == 0) {
+            syllabus = local;
+        }
+        source_close(&file);
+    }
+    if (syllabus != NULL) return syllabus;
+
+    printf("Warning: Cannot read syllabus '%s', using built-in topics\n", root->syllabus_path);
+    if (cache != NULL) return &cache->default_syllabus;
+    return syllabus_use_defaults(local, root->arena) == 0 ? local : NULL;
+}
+
+/* --- Phase 3 Entry Point --- */
+
+// Whether the results reused from fingerprints.bin (incremental.h) are
+// ones this syllabus and these tables could have produced
+static int reused_results_fit(const QuestionStore* store, int unit_count) {
+    for (int i = 0; i < store->count; i++) {
+        if (!store->reused[i]) continue;
+        if (store->difficulty[i] >= DIFFICULTY_COUNT || store->crispness[i] > AMBIGUOUS) return 0;
+        for (int u = 0; u < store->unit_count[i]; u++) {
+            if (store->units[i][u] >= unit_count) return 0;
+        }
+    }
+    return 1;
+}
+
+int run_phase_3_semantic(ASTNode* root, QuestionStore* store, const char* job_dir,
+                         const char* syllabus_dir, const char* bank_path,
+                         SemanticCache* cache, FILE* report_out) {
+    SemanticSummary summary;
+    memset(&summary, 0, sizeof(summary));
+    size_t per_question = store->count > 0 ? (size_t)store->count : 1;
+    summary.duplicate_of = (int*)arena_alloc(root->arena, sizeof(int) * per_question);
+    summary.bank_match = (BankMatch*)arena_alloc(root->arena, sizeof(BankMatch) * per_question);
+
+    // Without a cache the automata are built for this job alone
+    Syllabus local_syllabus;
+    const Syllabus* syllabus = get_syllabus(root, job_dir, syllabus_dir, cache, &local_syllabus);
+    SyllabusCoverage coverage;
+    KeywordMatcher local_difficulty;
+    const KeywordMatcher* difficulty_words = &local_difficulty;
+    if (cache != NULL) {
+        difficulty_words = &cache->difficulty;
+    } else if (difficulty_matcher_build(&local_difficulty, root->arena) != 0) {
+        difficulty_words = NULL;
+    }
+    uint16_t* units = syllabus != NULL
+        ? (uint16_t*)arena_alloc(root->arena, sizeof(uint16_t) * (syllabus->unit_count + 1))
+        : NULL;
+    if (summary.duplicate_of == NULL || summary.bank_match == NULL ||
+        syllabus == NULL || difficulty_words == NULL || units == NULL ||
+        syllabus_coverage_init(&coverage, syllabus, &root->topics, root->arena) != 0) {
+        fprintf(stderr, "Error: Out of memory in Phase 3\n");
+        return 1;
+    }
+    summary.coverage = &coverage;
+
+    // A damaged file is dropped as a whole: every question is analyzed again
+    if (!reused_results_fit(store, syllabus->unit_count)) {
+        fprintf(stderr, "Warning: Ignoring damaged results in %s/fingerprints.bin\n", job_dir);
+        memset(store->reused, 0, sizeof(uint8_t) * store->count);
+    }
+
+    // Annotate each question (the text blob keeps these reads sequential).
+    // Questions reused from the last compile already have their results.
+    for (int i = 0; i < store->count; i++) {
+        if (!store->reused[i]) {
+            const char* text = store->text + store->text_offset[i];
+            int found = syllabus_tag(&coverage, text, store->text_length[i], units);
+            uint16_t* copy = found > 0 ? (uint16_t*)arena_alloc(root->arena, sizeof(uint16_t) * found) : NULL;
+            if (copy != NULL) memcpy(copy, units, sizeof(uint16_t) * found);
+            store->units[i] = copy;
+            store->unit_count[i] = (uint16_t)(copy != NULL ? found : 0);
+            store->difficulty[i] = (uint8_t)classify_difficulty(difficulty_words, text, store->text_length[i]);
+            store->crispness[i] = (uint8_t)classify_crispness(text, store->text_length[i]);
+        } else {
+            syllabus_cover(&coverage, store->units[i], store->unit_count[i]);
+        }
+        int topic = store->unit_count[i] > 0 ? coverage.unit_topic[store->units[i][0]] : TOPIC_NONE;
+        store->estimated_time[i] = estimate_question_time(store->marks[i], (Difficulty)store->difficulty[i]);
+        store->topic[i] = (uint16_t)topic;
+        store->status[i] = topic == TOPIC_NONE ? STATUS_OUT_OF_SYLLABUS : STATUS_OK;
+    }
+
+    // Near-duplicates (reworded repeats) within this paper
+    MinHash* signatures = store->signature;
+    summary.duplicate_count = minhash_store(store, root->arena) == 0
+        ? find_duplicates(signatures, store->count, root->arena, summary.duplicate_of)
+        : -1;
+    if (summary.duplicate_count < 0) {
+        fprintf(stderr, "Error: Out of memory in Phase 3\n");
+        return 1;
+    }
+    for (int i = 0; i < store->count; i++) {
+        if (summary.duplicate_of[i] >= 0) store->status[i] = STATUS_DUPLICATE;
+    }
+
+    // ... and repeats of questions from earlier papers
+    char job_id[BANK_JOB_ID_SIZE];
+    job_id_of(job_dir, job_id, sizeof(job_id));
+    memset(summary.bank_match, 0, sizeof(BankMatch) * per_question);
+    if (bank_path != NULL) {
+        check_question_bank(bank_path, job_id, signatures, store, root->arena, &summary);
+    }
+    question_store_sync_to_ast(store);
+
+    summarize(store, root->total_marks, root->total_time, &summary);
+
+    char report_path[PATH_MAX] = "semantic_report.json";
+    if (report_out == NULL && source_path(report_path, sizeof(report_path), job_dir, "semantic_report.json") != 0) {
+        fprintf(stderr, "Error: Job path too long: %s\n", job_dir);
+        return 1;
+    }
+    if (write_report(report_path, report_out, root, store, &summary) != 0) {
+        fprintf(stderr, "Error: Could not write %s\n", report_path);
+        return 1;
+    }
+
+    // Later papers are checked against this one too
+    if (bank_path != NULL && question_bank_add_job(bank_path, job_id, signatures, store->count) != 0) {
+        printf("Warning: Could not add %s to question bank %s\n", job_id, bank_path);
+    }
+    return 0;
+}
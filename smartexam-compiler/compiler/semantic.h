@@ -0,0 +1,74 @@
+/*
+ * compiler/semantic.h
+ * Phase 3 (semantic analysis): annotates every question and writes
+ * semantic_report.json for the web UI.
+ */
+
+#ifndef SEMANTIC_H
+#define SEMANTIC_H
+
+#include <stdio.h>
+#include <pthread.h>
+#include "ast.h"
+#include "question_store.h"
+#include "keyword_matcher.h"
+#include "syllabus.h"
+
+// Minutes the estimated time may be off TOTAL_TIME before the report
+// warns (and Phase 5 gives up fitting the times, see optimizer.h)
+#define TIME_TOLERANCE 15
+
+// Automata kept warm between jobs (used by the server and batch modes,
+// see server.h and batch.h). Shared by all worker threads.
+typedef struct CachedSyllabus {
+    uint64_t hash;             // FNV-1a of the syllabus file contents
+    size_t length;
+    const char* text;          // Copy of the contents: a hash match is checked with it
+    Syllabus syllabus;
+    struct CachedSyllabus* next;
+} CachedSyllabus;
+
+typedef struct SemanticCache {
+    pthread_mutex_t lock;      // Guards 'syllabi' and 'arena'
+    Arena arena;               // Everything below is allocated here
+    KeywordMatcher difficulty; // Read-only once built
+    Syllabus default_syllabus; // Built-in topics
+    CachedSyllabus* syllabi;   // Compiled syllabus files, newest first
+    int syllabus_count;
+} SemanticCache;
+
+// Builds the difficulty automaton and default topics. Returns 0 on success.
+int semantic_cache_init(SemanticCache* cache);
+void semantic_cache_free(SemanticCache* cache);
+
+// Runs all Phase 3 checks on 'store' (built from 'root'), copies the
+// annotations back into the AST and writes job_dir/semantic_report.json.
+// The syllabus is looked up relative to job_dir, or, if 'syllabus_dir'
+// is set, only as a bare file name in that directory.
+// If 'bank_path' is set, questions are also looked up in that question
+// bank (see question_bank.h) and this job is added to it afterwards.
+// 'cache' may be NULL; then the keyword automata are built for this job.
+// If 'report_out' is set, the report is written to that stream instead
+// of to job_dir/semantic_report.json (the caller closes the stream).
+// Returns 0 on success, 1 if the report could not be written.
+int run_phase_3_semantic(ASTNode* root, QuestionStore* store, const char* job_dir,
+                         const char* syllabus_dir, const char* bank_path,
+                         SemanticCache* cache, FILE* report_out);
+
+// Validate sum of marks against the declared TOTAL_MARKS.
+// Returns 1 on PASS, 0 on FAIL.
+int validate_marks(const QuestionStore* store, int declared_total);
+
+// Builds the automaton for the difficulty keywords (in 'arena')
+int difficulty_matcher_build(KeywordMatcher* m, Arena* arena);
+
+// Classify difficulty (keyword-based) with a matcher from
+// difficulty_matcher_build(). Returns a Difficulty code.
+Difficulty classify_difficulty(const KeywordMatcher* m, const char* text, size_t len);
+
+// Minutes a student needs for one question. The paper needs the sum of
+// these: Phase 3 checks it against TOTAL_TIME, Phase 5 and synthesis fit
+// the same numbers to it.
+int estimate_question_time(int marks, Difficulty difficulty);
+
+#endif // SEMANTIC_H
@@ -0,0 +1,323 @@
+/*
+ * compiler/server.c
+ * Unix domain socket server (see server.h).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include "server.h"
+
+#define SERVER_LINE_MAX 4096
+
+typedef struct Connection Connection;
+
+typedef struct Server {
+    const JobContext* defaults;
+    SemanticCache cache;        // Shared by every job
+    pthread_mutex_t lock;       // Guards the fields below
+    pthread_cond_t changed;     // Signalled when a job or a connection ends
+    int compiling;              // Jobs running, at most 'max_workers'
+    int max_workers;
+    Connection* connections;    // Open connections, so shutdown can end them
+    int connection_count;
+    int stopping;
+} Server;
+
+struct Connection {
+    Server* server;
+    int fd;
+    Connection* prev;
+    Connection* next;
+    char buf[SERVER_LINE_MAX];
+    size_t len;                 // Bytes in 'buf'
+};
+
+// The signal handler writes a byte here to wake the accept loop
+static int signal_pipe[2] = { -1, -1 };
+
+static void on_signal(int sig) {
+    (void)sig;
+    int saved = errno;
+    if (write(signal_pipe[1], "", 1) < 0) {
+        // Full already: the loop is being woken anyway
+    }
+    errno = saved;
+}
+
+/* --- Connection I/O --- */
+
+// Sends the whole string; MSG_NOSIGNAL so a client that went away
+// doesn't kill the server with SIGPIPE
+static int send_text(int fd, const char* text) {
+    size_t len = strlen(text);
+    while (len > 0) {
+        ssize_t n = send(fd, text, len, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        text += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+// Reads one line (without the '\n'). Returns 0 on success, -1 on EOF,
+// error, a line longer than SERVER_LINE_MAX or SERVER_IDLE_TIMEOUT
+// seconds without data (SO_RCVTIMEO, see add_connection()).
+static int read_line(Connection* c, char* line) {
+    for (;;) {
+        char* nl = memchr(c->buf, '\n', c->len);
+        if (nl != NULL) {
+            size_t n = (size_t)(nl - c->buf);
+            memcpy(line, c->buf, n);
+            line[n] = '\0';
+            if (n > 0 && line[n - 1] == '\r') line[n - 1] = '\0';
+            c->len -= n + 1;
+            memmove(c->buf, nl + 1, c->len);
+            return 0;
+        }
+        if (c->len == sizeof(c->buf)) return -1;
+        ssize_t got = recv(c->fd, c->buf + c->len, sizeof(c->buf) - c->len, 0);
+        if (got < 0 && errno == EINTR) continue;
+        if (got <= 0) return -1;
+        c->len += (size_t)got;
+    }
+}
+
+// JobProgressFn: forwards phase updates to the client
+static void send_progress(void* ctx, const char* phase, const char* status, const char* message) {
+    Connection* c = (Connection*)ctx;
+    char line[512];
+    snprintf(line, sizeof(line), "PROGRESS %s %s %s\n", phase, status, message);
+    send_text(c->fd, line);
+}
+
+/* --- Requests --- */
+
+static int compile_request(Connection* c, const char* job_dir) {
+    Server* server = c->server;
+
+    // A worker slot only while the job runs: an idle client holds none
+    pthread_mutex_lock(&server->lock);
+    while (server->compiling >= server->max_workers && !server->stopping) {
+        pthread_cond_wait(&server->changed, &server->lock);
+    }
+    int stopping = server->stopping;
+    if (!stopping) server->compiling++;
+    pthread_mutex_unlock(&server->lock);
+    if (stopping) {
+        send_text(c->fd, "ERROR server shutting down\n");
+        return -1;
+    }
+
+    JobContext job;
+    job_init(&job, job_dir);
+    job_copy_options(&job, server->defaults);
+    job.cache = &server->cache;
+    job.progress = send_progress;
+    job.progress_ctx = c;
+
+    int result = job_compile(&job);
+    job_cleanup(&job);
+
+    pthread_mutex_lock(&server->lock);
+    server->compiling--;
+    pthread_cond_broadcast(&server->changed);
+    pthread_mutex_unlock(&server->lock);
+    return send_text(c->fd, result == 0 ? "DONE OK\n" : "DONE FAILED\n");
+}
+
+/* --- Connections --- */
+
+// Registers a new connection. Returns NULL if there are too many or
+// memory is short.
+static Connection* add_connection(Server* server, int fd) {
+    pthread_mutex_lock(&server->lock);
+    int full = server->connection_count >= SERVER_MAX_CONNECTIONS;
+    Connection* c = full ? NULL : (Connection*)calloc(1, sizeof(Connection));
+    if (c != NULL) {
+        c->server = server;
+        c->fd = fd;
+        c->next = server->connections;
+        if (c->next != NULL) c->next->prev = c;
+        server->connections = c;
+        server->connection_count++;
+    }
+    pthread_mutex_unlock(&server->lock);
+    if (c == NULL) return NULL;
+
+    // A client that connects and then says nothing is dropped eventually
+    struct timeval timeout = { SERVER_IDLE_TIMEOUT, 0 };
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    return c;
+}
+
+// Unregisters and closes a connection
+static void remove_connection(Connection* c) {
+    Server* server = c->server;
+    pthread_mutex_lock(&server->lock);
+    if (c->prev != NULL) c->prev->next = c->next;
+    else server->connections = c->next;
+    if (c->next != NULL) c->next->prev = c->prev;
+    server->connection_count--;
+    pthread_cond_broadcast(&server->changed);
+    pthread_mutex_unlock(&server->lock);
+    close(c->fd);
+    free(c);
+}
+
+static void* serve_connection(void* arg) {
+    Connection* c = (Connection*)arg;
+    char line[SERVER_LINE_MAX];
+
+    while (read_line(c, line) == 0) {
+        int sent;
+        if (strncmp(line, "COMPILE ", 8) == 0 && line[8] != '\0') {
+            sent = compile_request(c, line + 8);
+        } else if (strcmp(line, "PING") == 0) {
+            sent = send_text(c->fd, "PONG\n");
+        } else {
+            sent = send_text(c->fd, "ERROR unknown request\n");
+        }
+        if (sent != 0) break;
+    }
+    remove_connection(c);
+    return NULL;
+}
+
+/* --- Server --- */
+
+static int open_socket(const char* path) {
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "Error: Socket path too long: %s\n", path);
+        return -1;
+    }
+    strcpy(addr.sun_path, path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        perror("socket");
+        return -1;
+    }
+    unlink(path); // A socket left behind by an earlier server
+    if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(fd, SOMAXCONN) != 0) {
+        perror(path);
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int run_server(const char* socket_path, const JobContext* defaults) {
+    Server server;
+    memset(&server, 0, sizeof(server));
+    server.defaults = defaults;
+    // One job per core: more threads would only make each job slower
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    server.max_workers = cores < 1 ? 1 : cores > SERVER_MAX_WORKERS ? SERVER_MAX_WORKERS : (int)cores;
+    if (semantic_cache_init(&server.cache) != 0) {
+        fprintf(stderr, "Fatal Error: Out of memory\n");
+        return 1;
+    }
+    if (pipe(signal_pipe) != 0) {
+        perror("pipe");
+        semantic_cache_free(&server.cache);
+        return 1;
+    }
+    fcntl(signal_pipe[1], F_SETFL, O_NONBLOCK); // Never block in the handler
+    pthread_mutex_init(&server.lock, NULL);
+    pthread_cond_init(&server.changed, NULL);
+
+    int listen_fd = open_socket(socket_path);
+    if (listen_fd < 0) {
+        pthread_cond_destroy(&server.changed);
+        pthread_mutex_destroy(&server.lock);
+        close(signal_pipe[0]);
+        close(signal_pipe[1]);
+        semantic_cache_free(&server.cache);
+        return 1;
+    }
+    fcntl(listen_fd, F_SETFL, O_NONBLOCK); // poll() said ready, but the client may have gone
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_signal;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    printf("q_compiler server listening on %s\n", socket_path);
+    fflush(stdout);
+
+    for (;;) {
+        // Waits for a client or a signal (a signal that arrives just
+        // before poll() is still in the pipe)
+        struct pollfd fds[2] = { { listen_fd, POLLIN, 0 }, { signal_pipe[0], POLLIN, 0 } };
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            perror("poll");
+            break;
+        }
+        if (fds[1].revents != 0) break;
+        int fd = accept(listen_fd, NULL, NULL);
+        if (fd < 0) {
+            if (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK || errno == ECONNABORTED) continue;
+            perror("accept");
+            break;
+        }
+        fcntl(fd, F_SETFL, 0); // Not non-blocking like listen_fd (BSD copies the flag)
+
+        Connection* c = add_connection(&server, fd);
+        if (c == NULL) {
+            send_text(fd, "ERROR too many connections\n");
+            close(fd);
+            continue;
+        }
+        pthread_t thread;
+        if (pthread_create(&thread, NULL, serve_connection, c) == 0) {
+            pthread_detach(thread);
+        } else {
+            send_text(fd, "ERROR cannot start a thread\n");
+            remove_connection(c);
+        }
+    }
+
+    // Stop taking connections. Idle ones end now; the ones running a
+    // job send its DONE line first, then read EOF too.
+    close(listen_fd);
+    unlink(socket_path);
+    pthread_mutex_lock(&server.lock);
+    server.stopping = 1;
+    for (Connection* c = server.connections; c != NULL; c = c->next) {
+        shutdown(c->fd, SHUT_RD);
+    }
+    pthread_cond_broadcast(&server.changed); // Requests waiting for a slot give up
+    while (server.connection_count > 0) {
+        pthread_cond_wait(&server.changed, &server.lock);
+    }
+    pthread_mutex_unlock(&server.lock);
+
+    sa.sa_handler = SIG_DFL; // Before the pipe goes
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    pthread_cond_destroy(&server.changed);
+    pthread_mutex_destroy(&server.lock);
+    close(signal_pipe[0]);
+    close(signal_pipe[1]);
+    semantic_cache_free(&server.cache);
+    printf("q_compiler server stopped\n");
+    return 0;
+}
@@ -0,0 +1,43 @@
+/*
+ * compiler/server.h
+ * Server mode: q_compiler --serve=<socket path>
+ *
+ * Instead of starting one process per upload, app.py can keep a single
+ * q_compiler running and send it job directories over a Unix domain
+ * socket. The server keeps the keyword automata and compiled syllabi
+ * warm (see SemanticCache) and compiles each request on its own thread.
+ *
+ * Protocol (one request or reply per line):
+ *     client: COMPILE <job_dir>
+ *     server: PROGRESS <phase> <status> <message>   (zero or more)
+ *     server: DONE OK | DONE FAILED
+ *
+ *     client: PING
+ *     server: PONG
+ *
+ * A connection may send any number of requests. It only holds one of
+ * the worker slots while a COMPILE runs, and is closed after
+ * SERVER_IDLE_TIMEOUT seconds without a request.
+ */
+
+#ifndef SERVER_H
+#define SERVER_H
+
+#include "job.h"
+
+// Upper limit on jobs compiled at the same time (the real limit is the
+// number of CPU cores, if that is lower)
+#define SERVER_MAX_WORKERS 32
+
+// Connections open at the same time; more are turned away
+#define SERVER_MAX_CONNECTIONS 256
+
+// Seconds a connection may wait between requests
+#define SERVER_IDLE_TIMEOUT 30
+
+// Runs until SIGINT or SIGTERM, then lets running jobs finish and closes
+// every connection. Every job is set up like 'defaults' (use_mmap,
+// token_formats, bank options). Returns 0 on a clean shutdown.
+int run_server(const char* socket_path, const JobContext* defaults);
+
+#endif // SERVER_H
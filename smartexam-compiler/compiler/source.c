@@ -0,0 +1,130 @@
+/*
+ * compiler/source.c
+ * Loads input.qp into a single buffer the Flex scanner can read in place.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "source.h"
+
+/* --- Helpers --- */
+
+// Maps the file privately (copy-on-write) with two zero bytes after it.
+// We reserve an anonymous zero-filled region first and then map the file
+// over its start, so the trailing NULs exist even when the file size is
+// an exact multiple of the page size.
+static int map_file(SourceBuffer* src, int fd, size_t size) {
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t map_length = ((size + 2) + page - 1) / page * page;
+
+    char* base = mmap(NULL, map_length, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) return -1;
+
+    if (mmap(base, size, PROT_READ | PROT_WRITE,
+             MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+        munmap(base, map_length);
+        return -1;
+    }
+    madvise(base, map_length, MADV_SEQUENTIAL);
+
+    src->data = base;
+    src->length = size;
+    src->map_length = map_length;
+    return 0;
+}
+
+// Fallback: one heap buffer, filled with read()
+static int read_file(SourceBuffer* src, int fd, size_t size) {
+    char* buf = (char*)malloc(size + 2);
+    if (buf == NULL) return -1;
+
+    size_t done = 0;
+    while (done < size) {
+        ssize_t n = read(fd, buf + done, size - done);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            free(buf);
+            if (n == 0) errno = EIO; // File shrank under us
+            return -1;
+        }
+        done += (size_t)n;
+    }
+
+    src->data = buf;
+    src->length = size;
+    src->map_length = 0;
+    return 0;
+}
+
+/* --- Source Functions --- */
+
+int source_open(SourceBuffer* src, const char* path, int use_mmap) {
+    memset(src, 0, sizeof(*src));
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return -1;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return -1;
+    }
+    size_t size = (size_t)st.st_size;
+
+    // An empty file cannot be mapped; the heap path handles it fine
+    int rc = -1;
+    if (use_mmap && size > 0) {
+        rc = map_file(src, fd, size);
+    }
+    if (rc != 0) {
+        rc = read_file(src, fd, size);
+    }
+    close(fd);
+    if (rc != 0) return -1;
+
+    // yy_scan_buffer() requires the buffer to end in two NULs
+    src->data[size] = '\0';
+    src->data[size + 1] = '\0';
+    return 0;
+}
+
+int source_from_memory(SourceBuffer* src, const char* data, size_t length) {
+    memset(src, 0, sizeof(*src));
+    // A private copy: the lexer writes NULs into the buffer
+    char* buf = (char*)malloc(length + 2);
+    if (buf == NULL) return -1;
+    memcpy(buf, data, length);
+    buf[length] = '\0';
+    buf[length + 1] = '\0';
+    src->data = buf;
+    src->length = length;
+    return 0;
+}
+
+void source_close(SourceBuffer* src) {
+    if (src->data == NULL) return;
+    if (src->map_length > 0) {
+        munmap(src->data, src->map_length);
+    } else {
+        free(src->data);
+    }
+    memset(src, 0, sizeof(*src));
+}
+
+const char* source_view(const SourceBuffer* src, StrView view) {
+    return src->data + view.offset;
+}
+
+int source_path(char* buf, size_t size, const char* dir, const char* name) {
+    int n = snprintf(buf, size, "%s/%s", dir, name);
+    if (n >= 0 && (size_t)n < size) return 0;
+    errno = ENAMETOOLONG; // For perror()
+    return -1;
+}
@@ -0,0 +1,50 @@
+/*
+ * compiler/source.h
+ * The input.qp source buffer shared by the lexer and the parser.
+ *
+ * The whole file is kept in one contiguous buffer (memory-mapped when
+ * possible) and the Flex scanner reads straight out of it. String tokens
+ * are handed to the parser as offset/length views into this buffer, so
+ * no token text is ever copied onto the heap.
+ */
+
+#ifndef SOURCE_H
+#define SOURCE_H
+
+#include <stddef.h>
+
+typedef struct SourceBuffer {
+    char* data;        // Input bytes, followed by the two NULs Flex wants
+    size_t length;     // Number of real input bytes (without the NULs)
+    size_t map_length; // Size of the mmap'd region, 0 if 'data' is malloc'd
+} SourceBuffer;
+
+// A string token: 'length' bytes starting at 'offset' in the source
+typedef struct StrView {
+    unsigned int offset;
+    unsigned int length;
+} StrView;
+
+/* --- Source Functions --- */
+
+// Loads 'path' into 'src'. Uses mmap when 'use_mmap' is set, and falls
+// back to a single read() into a heap buffer if mapping is not possible.
+// Returns 0 on success, -1 on error (errno is left set).
+int source_open(SourceBuffer* src, const char* path, int use_mmap);
+
+// Loads a copy of 'length' bytes of 'data' (e.g. a DSL string handed to
+// libqverifier). Returns 0 on success, -1 if out of memory.
+int source_from_memory(SourceBuffer* src, const char* data, size_t length);
+
+// Unmaps / frees the buffer. Every StrView into it becomes invalid.
+void source_close(SourceBuffer* src);
+
+// Returns the text of a view. The lexer NUL-terminates string tokens
+// in place, so the result can be used as a normal C string.
+const char* source_view(const SourceBuffer* src, StrView view);
+
+// Writes "dir/name" into 'buf'. Returns 0, or -1 (errno ENAMETOOLONG) if
+// it does not fit: a cut-off path would name some other file.
+int source_path(char* buf, size_t size, const char* dir, const char* name);
+
+#endif // SOURCE_H
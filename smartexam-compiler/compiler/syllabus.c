@@ -0,0 +1,253 @@
+/*
+ * compiler/syllabus.c
+ * Loads the syllabus file and tags questions with its units.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include <limits.h>
+#include "syllabus.h"
+
+#define MAX_KEYWORD_LENGTH 128
+#define MIN_KEYWORD_LENGTH 3 // Skips fragments like "of" or "a"
+
+// Used when the header's syllabus file can't be read
+static const char* const default_topics[] = {
+    "Trees", "Sorting", "Graphs", "Stack", "Queue", "Grammar", "Compiler",
+    "Parsing", "Chomsky", NULL
+};
+
+/* --- Parsing Helpers --- */
+
+static void trim(const char** start, const char** end) {
+    while (*start < *end && (isspace((unsigned char)**start) || **start == '.')) (*start)++;
+    while (*end > *start && (isspace((unsigned char)(*end)[-1]) || (*end)[-1] == '.')) (*end)--;
+}
+
+// Adds one keyword for 'unit'. A final plural "s" is dropped: keywords
+// also match their plural, so "tree" still finds "trees" and "tree
+// traversal" finds "tree traversals" and "tree traversal techniques".
+static int add_keyword(Syllabus* s, const char* start, const char* end, int unit) {
+    trim(&start, &end);
+    size_t len = (size_t)(end - start);
+    if (len < MIN_KEYWORD_LENGTH) return 0;
+    if (len >= MAX_KEYWORD_LENGTH) len = MAX_KEYWORD_LENGTH - 1;
+
+    char word[MAX_KEYWORD_LENGTH];
+    memcpy(word, start, len);
+    if (len > MIN_KEYWORD_LENGTH && tolower((unsigned char)word[len - 1]) == 's' &&
+        tolower((unsigned char)word[len - 2]) != 's') {
+        len--;
+    }
+    word[len] = '\0';
+    return keyword_matcher_add(&s->matcher, word, unit);
+}
+
+// Adds every " and "-separated part of [start, end) as a keyword, so
+// "Sorting and searching algorithms" matches either half
+static int add_phrase(Syllabus* s, const char* start, const char* end, int unit) {
+    const char* p = start;
+    while (p < end) {
+        const char* split = p;
+        while (split + 5 <= end && strncmp(split, " and ", 5) != 0) split++;
+        if (split + 5 > end) split = end;
+        if (add_keyword(s, p, split, unit) != 0) return -1;
+        p = split == end ? end : split + 5;
+    }
+    return 0;
+}
+
+// Starts a new unit named [start, end). Returns its index, or -1.
+static int add_unit(Syllabus* s, Arena* arena, const char* start, const char* end, int capacity) {
+    trim(&start, &end);
+    if (start == end || s->unit_count == capacity) return -1;
+    int unit = s->unit_count;
+    s->unit_names[unit] = arena_strndup(arena, start, (size_t)(end - start));
+    if (s->unit_names[unit] == NULL) return -1;
+    s->unit_count++;
+    if (add_phrase(s, start, end, unit) != 0) return -1;
+    return unit;
+}
+
+// Parses one line of the syllabus file
+static int parse_line(Syllabus* s, Arena* arena, const char* line, const char* end,
+                      int* unit, int capacity) {
+    const char* p = line;
+    while (p < end && isspace((unsigned char)*p)) p++;
+    if (p == end) return 0;
+
+    // "- subtopic" lines belong to the unit above them
+    if ((*p == '-' || *p == '*') && *unit >= 0) {
+        return add_phrase(s, p + 1, end, *unit);
+    }
+
+    // "3. Heading: sub, sub" or "3) Heading". Unnumbered lines only
+    // count if they have a colon; anything else is a title.
+    const char* body = p;
+    while (body < end && isdigit((unsigned char)*body)) body++;
+    int numbered = body > p && body < end && (*body == '.' || *body == ')');
+    if (numbered) body++;
+    const char* colon = memchr(body, ':', (size_t)(end - body));
+    if (!numbered && colon == NULL) return 0;
+
+    *unit = add_unit(s, arena, body, colon != NULL ? colon : end, capacity);
+    if (*unit < 0) return -1;
+    if (colon == NULL) return 0;
+
+    // Subtopics: comma or semicolon separated
+    const char* item = colon + 1;
+    while (item < end) {
+        const char* stop = item;
+        while (stop < end && *stop != ',' && *stop != ';') stop++;
+        if (add_phrase(s, item, stop, *unit) != 0) return -1;
+        item = stop + 1;
+    }
+    return 0;
+}
+
+static int setup(Syllabus* s, Arena* arena, int capacity) {
+    memset(s, 0, sizeof(*s));
+    keyword_matcher_init(&s->matcher, arena);
+    s->unit_names = (const char**)arena_alloc(arena, sizeof(char*) * (capacity > 0 ? capacity : 1));
+    return s->unit_names == NULL ? -1 : 0;
+}
+
+/* --- Syllabus Functions --- */
+
+int syllabus_open_file(SourceBuffer* file, const char* path, const char* job_dir) {
+    if (path == NULL || path[0] == '\0') return -1;
+    const char* name = path;
+    for (const char* p = path; *p != '\0'; p++) {
+        if (*p == '/' || *p == '\\') name = p + 1;
+    }
+    char job_path[PATH_MAX];
+    int in_job = job_dir != NULL && name[0] != '\0' &&
+                 source_path(job_path, sizeof(job_path), job_dir, name) == 0;
+
+    // A bare file name (app.py writes "syllabus.txt") is the job's own copy
+    if (in_job && name == path && source_open(file, job_path, 1) == 0) {
+        return 0;
+    }
+    if (source_open(file, path, 1) == 0) {
+        return 0;
+    }
+    // Also look for the same file name in the job dir (paths in input.qp
+    // are often relative to the web app, and may use backslashes)
+    if (!in_job || name == path) return -1;
+    return source_open(file, job_path, 1);
+}
+
+int syllabus_open_in_dir(SourceBuffer* file, const char* path, const char* dir) {
+    if (path == NULL || dir == NULL || dir[0] == '\0') return -1;
+    if (path[0] == '\0' || strcmp(path, ".") == 0 || strcmp(path, "..") == 0 ||
+        strpbrk(path, "/\\") != NULL) {
+        return -1;
+    }
+    char dir_path[PATH_MAX];
+    if (source_path(dir_path, sizeof(dir_path), dir, path) != 0) return -1;
+    return source_open(file, dir_path, 1);
+}
+
+int syllabus_compile(Syllabus* s, const char* text, size_t len, Arena* arena) {
+    // At most one unit per line
+    int capacity = 1;
+    for (size_t i = 0; i < len; i++) {
+        if (text[i] == '\n') capacity++;
+    }
+    if (capacity > UINT16_MAX) capacity = UINT16_MAX;
+
+    int result = setup(s, arena, capacity);
+    int unit = -1;
+    const char* line = text;
+    const char* end = text + len;
+    while (result == 0 && line < end) {
+        const char* eol = memchr(line, '\n', (size_t)(end - line));
+        if (eol == NULL) eol = end;
+        result = parse_line(s, arena, line, eol, &unit, capacity);
+        line = eol + 1;
+    }
+
+    if (result == 0) result = keyword_matcher_build(&s->matcher);
+    if (result != 0 || s->unit_count == 0) return -1;
+    s->loaded = 1;
+    return 0;
+}
+
+int syllabus_load(Syllabus* s, const char* path, const char* job_dir, Arena* arena) {
+    SourceBuffer file;
+    if (syllabus_open_file(&file, path, job_dir) != 0) return -1;
+    int result = syllabus_compile(s, file.data, file.length, arena);
+    source_close(&file); // Keywords and names were copied into the arena
+    return result;
+}
+
+int syllabus_use_defaults(Syllabus* s, Arena* arena) {
+    int count = 0;
+    while (default_topics[count] != NULL) count++;
+    if (setup(s, arena, count) != 0) return -1;
+    for (int i = 0; i < count; i++) {
+        const char* name = default_topics[i];
+        if (add_unit(s, arena, name, name + strlen(name), count) < 0) return -1;
+    }
+    return keyword_matcher_build(&s->matcher);
+}
+
+/* --- Coverage Functions --- */
+
+int syllabus_coverage_init(SyllabusCoverage* c, const Syllabus* s, TopicTable* topics, Arena* arena) {
+    size_t units = s->unit_count > 0 ? (size_t)s->unit_count : 1;
+    size_t words = (units + 63) / 64;
+    c->syllabus = s;
+    c->unit_topic = (uint16_t*)arena_alloc(arena, sizeof(uint16_t) * units);
+    c->covered = (uint64_t*)arena_alloc(arena, sizeof(uint64_t) * words);
+    if (c->unit_topic == NULL || c->covered == NULL) return -1;
+    memset(c->covered, 0, sizeof(uint64_t) * words);
+    for (int u = 0; u < s->unit_count; u++) {
+        c->unit_topic[u] = (uint16_t)topic_intern(topics, s->unit_names[u], strlen(s->unit_names[u]));
+    }
+    return 0;
+}
+
+typedef struct TagState {
+    uint16_t* units;
+    int count;
+} TagState;
+
+static int on_unit_hit(void* ctx, int unit, size_t start, int length) {
+    (void)start;
+    (void)length;
+    TagState* state = (TagState*)ctx;
+    // A question mentions a handful of units, so a linear check is enough
+    for (int i = 0; i < state->count; i++) {
+        if (state->units[i] == unit) return 0;
+    }
+    state->units[state->count++] = (uint16_t)unit;
+    return 0;
+}
+
+int syllabus_tag(SyllabusCoverage* c, const char* text, size_t len, uint16_t* units) {
+    TagState state = { units, 0 };
+    keyword_matcher_scan(&c->syllabus->matcher, text, len, on_unit_hit, &state);
+    syllabus_cover(c, units, state.count);
+    return state.count;
+}
+
+void syllabus_cover(SyllabusCoverage* c, const uint16_t* units, int count) {
+    for (int i = 0; i < count; i++) {
+        c->covered[units[i] / 64] |= (uint64_t)1 << (units[i] % 64);
+    }
+}
+
+int syllabus_is_covered(const SyllabusCoverage* c, int unit) {
+    return (int)((c->covered[unit / 64] >> (unit % 64)) & 1);
+}
+
+int syllabus_covered_count(const SyllabusCoverage* c) {
+    int count = 0;
+    size_t words = (size_t)(c->syllabus->unit_count + 63) / 64;
+    for (size_t i = 0; i < words; i++) {
+        count += __builtin_popcountll(c->covered[i]);
+    }
+    return count;
+}
@@ -0,0 +1,83 @@
+/*
+ * compiler/syllabus.h
+ * The paper's syllabus, compiled into a keyword matcher.
+ *
+ * A syllabus file is a list of numbered units, e.g.
+ *
+ *     Data Structures Syllabus
+ *     1. Introduction to Data Structures: arrays, linked lists, stacks, queues.
+ *     2. Trees: binary trees, BST, AVL, tree traversals.
+ *     4. Hashing and collision resolution techniques.
+ *
+ * Each unit is named after the text before the ':'.
+ * That heading and every subtopic after it become keywords of the
+ * unit in one Aho-Corasick automaton, so a question is tagged in a
+ * single pass no matter how long the syllabus is.
+ */
+
+#ifndef SYLLABUS_H
+#define SYLLABUS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "arena.h"
+#include "topics.h"
+#include "keyword_matcher.h"
+#include "source.h"
+
+typedef struct Syllabus {
+    int loaded;             // 1 if read from a syllabus file
+    int unit_count;
+    const char** unit_names;
+    KeywordMatcher matcher; // Keyword value = unit index
+} Syllabus;
+
+// What one paper covers of a syllabus. The Syllabus itself is never
+// modified after it is compiled, so one copy can serve many jobs.
+typedef struct SyllabusCoverage {
+    const Syllabus* syllabus;
+    uint16_t* unit_topic;   // Topic id (in the paper's TopicTable) of each unit
+    uint64_t* covered;      // Bitmap: bit u is set once unit u is hit
+} SyllabusCoverage;
+
+/* --- Syllabus Functions --- */
+
+// Opens the header's SYLLABUS_PATH. A bare file name is looked up in
+// 'job_dir' first. If the path cannot be opened, the file with the same
+// name in 'job_dir' is tried (older uploads have paths relative to the
+// web app). Returns 0 on success, -1 if not.
+int syllabus_open_file(SourceBuffer* file, const char* path, const char* job_dir);
+
+// Opens SYLLABUS_PATH for DSL that may come from anyone (libqverifier):
+// only a bare file name is accepted, and only dir/name is tried, so no
+// file outside 'dir' can be read. An empty 'dir' opens nothing.
+// Returns 0 on success, -1 if not.
+int syllabus_open_in_dir(SourceBuffer* file, const char* path, const char* dir);
+
+// Compiles syllabus text. Everything is allocated from 'arena'.
+// Returns 0 on success, -1 if out of memory or no units were found.
+int syllabus_compile(Syllabus* s, const char* text, size_t len, Arena* arena);
+
+// syllabus_open_file() + syllabus_compile()
+int syllabus_load(Syllabus* s, const char* path, const char* job_dir, Arena* arena);
+
+// Fallback when there is no syllabus file: a short built-in topic list
+// (trees, sorting, graphs, ...). 'loaded' stays 0. Returns 0 on success.
+int syllabus_use_defaults(Syllabus* s, Arena* arena);
+
+// Starts an empty coverage record for one paper. Unit names are
+// interned into 'topics'. Returns 0 on success.
+int syllabus_coverage_init(SyllabusCoverage* c, const Syllabus* s, TopicTable* topics, Arena* arena);
+
+// Finds the units mentioned in the text, in the order they are first
+// mentioned, and marks them as covered. 'units' needs room for every
+// unit of the syllabus. Returns how many were found.
+int syllabus_tag(SyllabusCoverage* c, const char* text, size_t len, uint16_t* units);
+
+// Marks units found by an earlier syllabus_tag() as covered
+void syllabus_cover(SyllabusCoverage* c, const uint16_t* units, int count);
+
+int syllabus_is_covered(const SyllabusCoverage* c, int unit);
+int syllabus_covered_count(const SyllabusCoverage* c);
+
+#endif // SYLLABUS_H
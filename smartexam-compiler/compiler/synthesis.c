@@ -0,0 +1,1027 @@
+/*
+ * compiler/synthesis.c
+ * Assembles a paper from a question bank with a parallel
+ * branch-and-bound search (see synthesis.h).
+ */
+
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "synthesis.h"
+#include "ast_helpers.h"
+#include "json_writer.h"
+#include "source.h"
+#include "tex_writer.h"
+
+// Difficulties in the order they are searched: fewest questions first
+#define LEVELS 3
+
+// Time bounds: every question of difficulty d takes at least
+// slope * marks + offset(d, slope) minutes, for any slope. The best
+// slope differs from mix to mix; it is found by ternary search (the
+// bound is concave in the slope).
+#define SLOPE_STEPS 40
+static const int level_difficulty[LEVELS] = { DIFFICULTY_HARD, DIFFICULTY_MEDIUM, DIFFICULTY_EASY };
+
+// Bank questions that are interchangeable for the constraints
+typedef struct QuestionClass {
+    int first;          // Offset into the sorted candidate list
+    int size;
+    int capacity;       // Questions one paper may take from it
+    int marks;
+    int time;
+    uint16_t topic;
+    uint8_t difficulty;
+} QuestionClass;
+
+// How many questions of each difficulty a paper has
+typedef struct Mix {
+    int count[DIFFICULTY_COUNT];
+    int n;
+    int deviation;      // From 30/50/20%, in percent * n
+    int bound;          // Fewest units it can leave uncovered
+    int index;          // Position in search order
+} Mix;
+
+typedef struct Problem {
+    // --- Read-only once the threads start ---
+    const QuestionStore* store;
+    const QuestionClass* classes;
+    int lo[DIFFICULTY_COUNT]; // Classes of difficulty d: [lo[d], hi[d])
+    int hi[DIFFICULTY_COUNT];
+    int* min_marks_from;    // Over classes c.. of the same difficulty
+    int* max_marks_from;
+    int* min_time_from;
+    // Sums of the k smallest / largest marks and smallest times of each
+    // difficulty, k = 0..SYNTH_MAX_QUESTIONS
+    long low_marks[DIFFICULTY_COUNT][SYNTH_MAX_QUESTIONS + 1];
+    long high_marks[DIFFICULTY_COUNT][SYNTH_MAX_QUESTIONS + 1];
+    long low_time[DIFFICULTY_COUNT][SYNTH_MAX_QUESTIONS + 1];
+    int* pair_marks;        // Distinct (marks, time) pairs, by difficulty:
+    int* pair_time;         // [pair_lo[d], pair_hi[d])
+    int pair_lo[DIFFICULTY_COUNT];
+    int pair_hi[DIFFICULTY_COUNT];
+    double max_ratio;       // Largest time / marks
+    int available[DIFFICULTY_COUNT];
+    int marks;
+    int budget;
+    int topics;             // Units the bank covers
+    int required;
+    const Mix* mixes;
+    int mix_count;
+
+    // --- Shared between the threads, guarded by 'lock' ---
+    pthread_mutex_t lock;
+    int next_mix;
+    int best_score;         // Units left uncovered by the best paper ...
+    int best_mix;           // ... its mix (-1: none yet) ...
+    int best_picks[SYNTH_MAX_QUESTIONS]; // ... and its classes
+    uint8_t* limited;       // Per mix: was its search cut short?
+    long nodes;
+} Problem;
+
+// One thread's search of one mix
+typedef struct Search {
+    Problem* p;
+    const Mix* mix;
+    int k[LEVELS];          // Questions to pick on each level
+    long later_min_marks[LEVELS]; // Bounds for the levels after each one
+    long later_max_marks[LEVELS];
+    long later_min_time[LEVELS];
+    int later_count[LEVELS];
+    double slope;           // The time bound chosen for this mix
+    double offset[LEVELS];
+    double later_offset[LEVELS];
+    int* used;              // Per class
+    int* hits;              // Per topic id
+    int covered;
+    int picks[SYNTH_MAX_QUESTIONS];
+    int depth;
+    int best_score;
+    int best[SYNTH_MAX_QUESTIONS];
+    long nodes;
+    int stop;
+    int limited;
+} Search;
+
+/* --- Classes --- */
+
+// A candidate with its sort key
+typedef struct Candidate {
+    uint8_t difficulty;
+    uint8_t crispness;
+    uint16_t topic;
+    int marks;
+    int index;          // In the store
+} Candidate;
+
+// By difficulty, topic, marks (high first), then crispness (CRISP = 0
+// first) and bank order
+static int by_class(const void* a, const void* b) {
+    const Candidate* x = (const Candidate*)a;
+    const Candidate* y = (const Candidate*)b;
+    if (x->difficulty != y->difficulty) return x->difficulty - y->difficulty;
+    if (x->topic != y->topic) return x->topic - y->topic;
+    if (x->marks != y->marks) return y->marks - x->marks;
+    if (x->crispness != y->crispness) return x->crispness - y->crispness;
+    return x->index - y->index;
+}
+
+static int by_int(const void* a, const void* b) {
+    int x = *(const int*)a, y = *(const int*)b;
+    return x < y ? -1 : x > y;
+}
+
+static int is_candidate(const QuestionStore* st, int i, int marks) {
+    int d = st->difficulty[i];
+    return st->status[i] == STATUS_OK && st->topic[i] != TOPIC_NONE &&
+           d >= DIFFICULTY_EASY && d <= DIFFICULTY_HARD &&
+           st->marks[i] > 0 && st->marks[i] <= marks;
+}
+
+// Sorts the candidates into classes and writes their store indexes,
+// grouped by class, to 'order'. Returns the class count, or -1 if out
+// of memory.
+static int build_classes(Problem* p, Candidate* cand, int count, int* order,
+                         QuestionClass** out, Arena* arena) {
+    qsort(cand, (size_t)count, sizeof(Candidate), by_class);
+    const QuestionStore* st = p->store;
+    QuestionClass* classes = (QuestionClass*)arena_alloc(arena, sizeof(QuestionClass) * (size_t)(count + 1));
+    if (classes == NULL) return -1;
+    int n = 0;
+    for (int j = 0; j < count; j++) {
+        int i = cand[j].index;
+        order[j] = i;
+        QuestionClass* last = n > 0 ? &classes[n - 1] : NULL;
+        if (last != NULL && last->difficulty == cand[j].difficulty &&
+            last->topic == cand[j].topic && last->marks == cand[j].marks) {
+            last->size++;
+            continue;
+        }
+        QuestionClass* c = &classes[n++];
+        c->first = j;
+        c->size = 1;
+        c->marks = cand[j].marks;
+        c->time = st->estimated_time[i];
+        c->topic = cand[j].topic;
+        c->difficulty = cand[j].difficulty;
+    }
+    *out = classes;
+    return n;
+}
+
+// Fills the bound tables. Returns 0, or -1 if out of memory.
+static int build_bounds(Problem* p, int class_count, Arena* arena) {
+    size_t size = sizeof(int) * (size_t)(class_count + 1);
+    p->min_marks_from = (int*)arena_alloc(arena, size);
+    p->max_marks_from = (int*)arena_alloc(arena, size);
+    p->min_time_from = (int*)arena_alloc(arena, size);
+    int* values = (int*)arena_alloc(arena, sizeof(int) * (size_t)(p->store->count + 1));
+    if (p->min_marks_from == NULL || p->max_marks_from == NULL || p->min_time_from == NULL ||
+        values == NULL) {
+        return -1;
+    }
+
+    for (int d = DIFFICULTY_EASY; d <= DIFFICULTY_HARD; d++) {
+        for (int c = p->hi[d] - 1; c >= p->lo[d]; c--) {
+            const QuestionClass* q = &p->classes[c];
+            int last = c + 1 < p->hi[d];
+            p->min_marks_from[c] = last && p->min_marks_from[c + 1] < q->marks ? p->min_marks_from[c + 1] : q->marks;
+            p->max_marks_from[c] = last && p->max_marks_from[c + 1] > q->marks ? p->max_marks_from[c + 1] : q->marks;
+            p->min_time_from[c] = last && p->min_time_from[c + 1] < q->time ? p->min_time_from[c + 1] : q->time;
+        }
+
+        // k smallest and largest: sort the values of every question
+        for (int pass = 0; pass < 2; pass++) {
+            int n = 0;
+            for (int c = p->lo[d]; c < p->hi[d]; c++) {
+                for (int j = 0; j < p->classes[c].capacity; j++) {
+                    values[n++] = pass == 0 ? p->classes[c].marks : p->classes[c].time;
+                }
+            }
+            qsort(values, (size_t)n, sizeof(int), by_int);
+            long low = 0, high = 0;
+            for (int k = 0; k <= SYNTH_MAX_QUESTIONS; k++) {
+                if (pass == 0) {
+                    p->low_marks[d][k] = low;
+                    p->high_marks[d][k] = high;
+                } else {
+                    p->low_time[d][k] = low;
+                }
+                if (k < n) {
+                    low += values[k];
+                    high += values[n - 1 - k];
+                }
+            }
+            p->available[d] = n;
+        }
+    }
+
+    // Distinct (marks, time) pairs of each difficulty, for the time bound
+    p->max_ratio = 0.0;
+    p->pair_marks = (int*)arena_alloc(arena, size);
+    p->pair_time = (int*)arena_alloc(arena, size);
+    if (p->pair_marks == NULL || p->pair_time == NULL) return -1;
+    int pairs = 0;
+    for (int d = 0; d < DIFFICULTY_COUNT; d++) {
+        p->pair_lo[d] = pairs;
+        for (int c = p->lo[d]; c < p->hi[d]; c++) {
+            const QuestionClass* q = &p->classes[c];
+            if (q->capacity == 0) continue;
+            int j = p->pair_lo[d];
+            while (j < pairs && (p->pair_marks[j] != q->marks || p->pair_time[j] != q->time)) j++;
+            if (j == pairs) {
+                p->pair_marks[pairs] = q->marks;
+                p->pair_time[pairs++] = q->time;
+            }
+            double ratio = (double)q->time / q->marks;
+            if (ratio > p->max_ratio) p->max_ratio = ratio;
+        }
+        p->pair_hi[d] = pairs;
+    }
+    return 0;
+}
+
+// Least time - slope * marks over the questions of difficulty d
+static double time_offset(const Problem* p, int d, double slope) {
+    double offset = 0.0;
+    for (int j = p->pair_lo[d]; j < p->pair_hi[d]; j++) {
+        double o = p->pair_time[j] - slope * p->pair_marks[j];
+        if (j == p->pair_lo[d] || o < offset) offset = o;
+    }
+    return offset;
+}
+
+// Least time a paper of this mix can take, bounded with 'slope'
+static double time_bound(const Problem* p, const Mix* mix, double slope) {
+    double time = slope * p->marks;
+    for (int d = DIFFICULTY_EASY; d <= DIFFICULTY_HARD; d++) {
+        if (mix->count[d] > 0) time += mix->count[d] * time_offset(p, d, slope);
+    }
+    return time;
+}
+
+/* --- Difficulty Mixes --- */
+
+// Is 'count' within [min, max] percent of 'n'?
+static int in_band(int count, int n, int min, int max) {
+    return count * 100 >= min * n && count * 100 <= max * n;
+}
+
+static int by_mix(const void* a, const void* b) {
+    const Mix* x = (const Mix*)a;
+    const Mix* y = (const Mix*)b;
+    if (x->bound != y->bound) return x->bound - y->bound;
+    long dx = (long)x->deviation * y->n, dy = (long)y->deviation * x->n;
+    if (dx != dy) return dx < dy ? -1 : 1;
+    return x->n - y->n;
+}
+
+// Lists every mix that meets the bands and can reach the totals, in
+// search order. Returns the count, or -1 if out of memory.
+static int build_mixes(Problem* p, Mix** out, Arena* arena) {
+    int max_n = p->available[DIFFICULTY_EASY] + p->available[DIFFICULTY_MEDIUM] + p->available[DIFFICULTY_HARD];
+    if (max_n > SYNTH_MAX_QUESTIONS) max_n = SYNTH_MAX_QUESTIONS;
+    // At most one mix per easy and hard count within the bands
+    size_t capacity = 1;
+    for (int n = 1; n <= max_n; n++) {
+        capacity += (size_t)(n * (SYNTH_EASY_MAX - SYNTH_EASY_MIN) / 100 + 2) *
+                    (size_t)(n * (SYNTH_HARD_MAX - SYNTH_HARD_MIN) / 100 + 2);
+    }
+    Mix* mixes = (Mix*)arena_alloc(arena, sizeof(Mix) * capacity);
+    if (mixes == NULL) return -1;
+
+    int count = 0;
+    for (int n = p->required > 1 ? p->required : 1; n <= max_n; n++) {
+        for (int e = 0; e <= n; e++) {
+            if (!in_band(e, n, SYNTH_EASY_MIN, SYNTH_EASY_MAX)) continue;
+            for (int h = 0; e + h <= n; h++) {
+                int m = n - e - h;
+                if (!in_band(h, n, SYNTH_HARD_MIN, SYNTH_HARD_MAX) ||
+                    !in_band(m, n, SYNTH_MEDIUM_MIN, SYNTH_MEDIUM_MAX) ||
+                    e > p->available[DIFFICULTY_EASY] || m > p->available[DIFFICULTY_MEDIUM] ||
+                    h > p->available[DIFFICULTY_HARD]) {
+                    continue;
+                }
+                long low = p->low_marks[DIFFICULTY_EASY][e] + p->low_marks[DIFFICULTY_MEDIUM][m] +
+                           p->low_marks[DIFFICULTY_HARD][h];
+                long high = p->high_marks[DIFFICULTY_EASY][e] + p->high_marks[DIFFICULTY_MEDIUM][m] +
+                            p->high_marks[DIFFICULTY_HARD][h];
+                long time = p->low_time[DIFFICULTY_EASY][e] + p->low_time[DIFFICULTY_MEDIUM][m] +
+                            p->low_time[DIFFICULTY_HARD][h];
+                if (p->marks < low || p->marks > high || time > p->budget) continue;
+
+                Mix* mix = &mixes[count++];
+                memset(mix, 0, sizeof(*mix));
+                mix->count[DIFFICULTY_EASY] = e;
+                mix->count[DIFFICULTY_MEDIUM] = m;
+                mix->count[DIFFICULTY_HARD] = h;
+                mix->n = n;
+                mix->deviation = abs(100 * e - 30 * n) + abs(100 * m - 50 * n) + abs(100 * h - 20 * n);
+                mix->bound = n < p->topics ? p->topics - n : 0;
+            }
+        }
+    }
+    qsort(mixes, (size_t)count, sizeof(Mix), by_mix);
+    for (int i = 0; i < count; i++) mixes[i].index = i;
+    *out = mixes;
+    return count;
+}
+
+/* --- Branch and Bound --- */
+
+// Can this mix no longer win? A mix earlier in the order has found a
+// paper at least as good as the best this one could reach.
+static int mix_beaten(Search* s) {
+    Problem* p = s->p;
+    pthread_mutex_lock(&p->lock);
+    int beaten = p->best_mix >= 0 && p->best_mix < s->mix->index && p->best_score <= s->mix->bound;
+    pthread_mutex_unlock(&p->lock);
+    return beaten;
+}
+
+static void leaf(Search* s, int marks, int time) {
+    const Problem* p = s->p;
+    if (marks != p->marks || time > p->budget || s->covered < p->required) return;
+    int score = p->topics - s->covered;
+    if (score >= s->best_score) return;
+    s->best_score = score;
+    memcpy(s->best, s->picks, sizeof(int) * (size_t)s->depth);
+    if (score <= s->mix->bound) s->stop = 1; // Nothing left to improve
+}
+
+// Picks the remaining 'r' questions of 'level' from classes 'start' on
+// (never going back, so each set of questions is visited once), then
+// moves on to the next level
+static void search(Search* s, int level, int r, int start, int marks, int time) {
+    if (s->stop) return;
+    if (++s->nodes > SYNTH_NODE_LIMIT) {
+        s->stop = s->limited = 1;
+        return;
+    }
+    if ((s->nodes & 1023) == 0 && mix_beaten(s)) {
+        s->stop = 1;
+        return;
+    }
+    const Problem* p = s->p;
+    if (r == 0) {
+        if (level + 1 < LEVELS) {
+            int d = level_difficulty[level + 1];
+            search(s, level + 1, s->k[level + 1], p->lo[d], marks, time);
+        } else {
+            leaf(s, marks, time);
+        }
+        return;
+    }
+    int end = p->hi[level_difficulty[level]];
+    if (start >= end) return;
+
+    // What the remaining picks can still add up to
+    long left = p->marks - marks;
+    if (left < r * (long)p->min_marks_from[start] + s->later_min_marks[level] ||
+        left > r * (long)p->max_marks_from[start] + s->later_max_marks[level] ||
+        time + r * (long)p->min_time_from[start] + s->later_min_time[level] > p->budget ||
+        time + s->slope * left + r * s->offset[level] + s->later_offset[level] > p->budget + 1e-9) {
+        return;
+    }
+    int picks_left = r + s->later_count[level];
+    int reachable = s->covered + (picks_left < p->topics - s->covered ? picks_left : p->topics - s->covered);
+    if (reachable < p->required || p->topics - reachable >= s->best_score) return;
+
+    // Questions on new topics first
+    for (int pass = 0; pass < 2; pass++) {
+        for (int c = start; c < end; c++) {
+            const QuestionClass* q = &p->classes[c];
+            if (s->used[c] == q->capacity || q->marks > left || (s->hits[q->topic] == 0) != (pass == 0)) {
+                continue;
+            }
+            s->used[c]++;
+            if (s->hits[q->topic]++ == 0) s->covered++;
+            s->picks[s->depth++] = c;
+            search(s, level, r - 1, c, marks + q->marks, time + q->time);
+            s->depth--;
+            if (--s->hits[q->topic] == 0) s->covered--;
+            s->used[c]--;
+            if (s->stop) return;
+        }
+    }
+}
+
+static void solve_mix(Search* s, const Mix* mix) {
+    const Problem* p = s->p;
+    s->mix = mix;
+    s->covered = 0;
+    s->depth = 0;
+    s->best_score = p->topics + 1;
+    s->nodes = 0;
+    s->stop = 0;
+    s->limited = 0;
+    if (mix_beaten(s)) return;
+    long min_marks = 0, max_marks = 0, min_time = 0;
+    int count = 0;
+    for (int level = LEVELS - 1; level >= 0; level--) {
+        int d = level_difficulty[level];
+        s->k[level] = mix->count[d];
+        s->later_min_marks[level] = min_marks;
+        s->later_max_marks[level] = max_marks;
+        s->later_min_time[level] = min_time;
+        s->later_count[level] = count;
+        min_marks += p->low_marks[d][mix->count[d]];
+        max_marks += p->high_marks[d][mix->count[d]];
+        min_time += p->low_time[d][mix->count[d]];
+        count += mix->count[d];
+    }
+
+    // The slope that bounds the paper's time best
+    double lo = 0.0, hi = p->max_ratio;
+    for (int step = 0; step < SLOPE_STEPS; step++) {
+        double a = lo + (hi - lo) / 3.0, b = hi - (hi - lo) / 3.0;
+        if (time_bound(p, mix, a) < time_bound(p, mix, b)) {
+            lo = a;
+        } else {
+            hi = b;
+        }
+    }
+    s->slope = lo;
+    double best_time = time_bound(p, mix, lo);
+    double later = 0.0;
+    for (int level = LEVELS - 1; level >= 0; level--) {
+        s->offset[level] = time_offset(p, level_difficulty[level], lo);
+        s->later_offset[level] = later;
+        later += s->k[level] * s->offset[level];
+    }
+    if (best_time > p->budget + 1e-9) return; // Too long whatever is picked
+
+    search(s, 0, s->k[0], p->lo[level_difficulty[0]], 0, 0);
+}
+
+static void* solver_main(void* arg) {
+    Search* s = (Search*)arg;
+    Problem* p = s->p;
+    for (;;) {
+        pthread_mutex_lock(&p->lock);
+        int m = p->next_mix < p->mix_count ? p->next_mix++ : -1;
+        pthread_mutex_unlock(&p->lock);
+        if (m < 0) break;
+
+        solve_mix(s, &p->mixes[m]);
+
+        pthread_mutex_lock(&p->lock);
+        p->nodes += s->nodes;
+        p->limited[m] = (uint8_t)s->limited;
+        if (s->best_score <= p->topics &&
+            (p->best_mix < 0 || s->best_score < p->best_score ||
+             (s->best_score == p->best_score && m < p->best_mix))) {
+            p->best_score = s->best_score;
+            p->best_mix = m;
+            memcpy(p->best_picks, s->best, sizeof(int) * (size_t)s->mix->n);
+        }
+        pthread_mutex_unlock(&p->lock);
+    }
+    return NULL;
+}
+
+// Runs the search over every mix for the classes' current capacities.
+// Returns 0 (p->best_mix < 0 if nothing was found), -1 if out of memory.
+static int run_search(Problem* p, int class_count, const ASTNode* root, const SynthesisOptions* options,
+                      SynthesizedPaper* paper, Arena* arena) {
+    const QuestionClass* classes = p->classes;
+
+    // --- Coverage target ---
+    uint8_t* seen = (uint8_t*)arena_alloc(arena, (size_t)root->topics.count + 1);
+    if (seen == NULL) return -1;
+    memset(seen, 0, (size_t)root->topics.count + 1);
+    p->topics = 0;
+    for (int c = 0; c < class_count; c++) {
+        if (classes[c].capacity == 0) continue;
+        if (!seen[classes[c].topic]) p->topics++;
+        seen[classes[c].topic] = 1;
+    }
+    int units = root->topics.count - 1; // Without TOPIC_NONE
+    p->required = (units * options->coverage + 99) / 100;
+    if (p->required > p->topics) p->required = p->topics;
+    paper->topics_in_bank = p->topics;
+    paper->topics_required = p->required;
+
+    // --- Bounds and mixes ---
+    Mix* mixes = NULL;
+    if (build_bounds(p, class_count, arena) != 0) return -1;
+    p->mix_count = build_mixes(p, &mixes, arena);
+    if (p->mix_count < 0) return -1;
+    p->mixes = mixes;
+    p->limited = (uint8_t*)arena_alloc(arena, (size_t)p->mix_count + 1);
+    if (p->limited == NULL) return -1;
+    memset(p->limited, 0, (size_t)p->mix_count + 1);
+    paper->mixes += p->mix_count;
+
+    // --- Search, one mix at a time per thread ---
+    int threads = options->threads;
+    if (threads <= 0) {
+        long cores = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cores > 0 ? (int)cores : 1;
+    }
+    if (threads > p->mix_count) threads = p->mix_count > 0 ? p->mix_count : 1;
+    Search* searches = (Search*)arena_alloc(arena, sizeof(Search) * (size_t)threads);
+    if (searches == NULL) return -1;
+    for (int t = 0; t < threads; t++) {
+        Search* s = &searches[t];
+        memset(s, 0, sizeof(*s));
+        s->p = p;
+        s->used = (int*)arena_alloc(arena, sizeof(int) * (size_t)(class_count + 1));
+        s->hits = (int*)arena_alloc(arena, sizeof(int) * (size_t)(root->topics.count + 1));
+        if (s->used == NULL || s->hits == NULL) return -1;
+        memset(s->used, 0, sizeof(int) * (size_t)(class_count + 1));
+        memset(s->hits, 0, sizeof(int) * (size_t)(root->topics.count + 1));
+    }
+    p->next_mix = 0;
+    p->best_mix = -1;
+    p->nodes = 0;
+    pthread_mutex_init(&p->lock, NULL);
+    pthread_t* ids = (pthread_t*)arena_alloc(arena, sizeof(pthread_t) * (size_t)threads);
+    int started = 1;
+    for (int t = 1; ids != NULL && t < threads; t++) {
+        if (pthread_create(&ids[t], NULL, solver_main, &searches[t]) != 0) break;
+        started++;
+    }
+    solver_main(&searches[0]); // This thread searches too
+    for (int t = 1; t < started; t++) {
+        pthread_join(ids[t], NULL);
+    }
+    pthread_mutex_destroy(&p->lock);
+    paper->threads = started;
+    paper->nodes += p->nodes;
+
+    // It is optimal unless a search that was cut short might have
+    // covered more units
+    paper->complete = 1;
+    for (int m = 0; m < p->mix_count; m++) {
+        if (p->limited[m] && (p->best_mix < 0 || mixes[m].bound < p->best_score)) paper->complete = 0;
+    }
+    return 0;
+}
+
+// splitmix64 (as in duplicates.c): the seeded shuffles below
+static uint64_t mix64(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+// Fisher-Yates with values drawn from (seed, stream)
+static void shuffle(int* values, int n, uint64_t seed, uint64_t stream) {
+    uint64_t state = mix64(seed ^ mix64(stream));
+    for (int i = n - 1; i > 0; i--) {
+        state = mix64(state);
+        int j = (int)(state % (uint64_t)(i + 1));
+        int t = values[i];
+        values[i] = values[j];
+        values[j] = t;
+    }
+}
+
+typedef struct VariantJob {
+    const Problem* p;
+    const int* pool;        // Per class: the questions the sets draw from ...
+    const int* pool_start;  // ... pool[pool_start[c]], pool_size[c] of them
+    const int* pool_size;
+    const int* per_paper;   // Per class: questions each set takes
+    const SynthesisOptions* options;
+    PaperVariant* variant;
+    int index;              // 0 = Set A
+    int count;
+    int* scratch;
+} VariantJob;
+
+// Deals set 'index' its questions: the t-th pick from class c is
+// pool[(index * per_paper[c] + t) % pool_size[c]], so the sets don't
+// share questions while the pool lasts
+static void* assemble_variant(void* arg) {
+    VariantJob* job = (VariantJob*)arg;
+    const Problem* p = job->p;
+    const QuestionStore* store = p->store;
+    const Mix* mix = &p->mixes[p->best_mix];
+    int* questions = job->scratch;
+    int n = 0;
+    for (int j = 0; j < mix->n; j++) {
+        int c = p->best_picks[j];
+        if (j > 0 && p->best_picks[j - 1] == c) continue; // Picks of a class are adjacent
+        for (int t = 0; t < job->per_paper[c]; t++) {
+            int slot = (job->index * job->per_paper[c] + t) % job->pool_size[c];
+            questions[n++] = job->pool[job->pool_start[c] + slot];
+        }
+    }
+
+    // Paper order: easy questions first. One paper keeps bank order;
+    // sets are shuffled within each difficulty
+    qsort(questions, (size_t)n, sizeof(int), by_int);
+    int* out = job->variant->questions;
+    int count = 0;
+    for (int d = DIFFICULTY_EASY; d <= DIFFICULTY_HARD; d++) {
+        int first = count;
+        for (int j = 0; j < n; j++) {
+            if (store->difficulty[questions[j]] == d) out[count++] = questions[j];
+        }
+        if (job->count > 1) {
+            shuffle(out + first, count - first, job->options->seed,
+                    (uint64_t)job->index * DIFFICULTY_COUNT + (uint64_t)d + 1);
+        }
+    }
+    return NULL;
+}
+
+// Builds every set from the winning classes, one thread per set.
+// Returns 0, -1 if out of memory.
+static int assemble_variants(const Problem* p, int class_count, const int* order,
+                             const SynthesisOptions* options, SynthesizedPaper* paper, Arena* arena) {
+    const QuestionClass* classes = p->classes;
+    const Mix* mix = &p->mixes[p->best_mix];
+    int k = paper->variant_count;
+    size_t class_size = sizeof(int) * (size_t)(class_count + 1);
+    int* per_paper = (int*)arena_alloc(arena, class_size);
+    int* pool_start = (int*)arena_alloc(arena, class_size);
+    int* pool_size = (int*)arena_alloc(arena, class_size);
+    int* pool = (int*)arena_alloc(arena, sizeof(int) * (size_t)mix->n * (size_t)k);
+    paper->variants = (PaperVariant*)arena_alloc(arena, sizeof(PaperVariant) * (size_t)k);
+    VariantJob* jobs = (VariantJob*)arena_alloc(arena, sizeof(VariantJob) * (size_t)k);
+    pthread_t* ids = (pthread_t*)arena_alloc(arena, sizeof(pthread_t) * (size_t)k);
+    if (per_paper == NULL || pool_start == NULL || pool_size == NULL || pool == NULL ||
+        paper->variants == NULL || jobs == NULL || ids == NULL) {
+        return -1;
+    }
+    memset(per_paper, 0, class_size);
+    for (int j = 0; j < mix->n; j++) per_paper[p->best_picks[j]]++;
+
+    // Each class's pool: its crispest questions, as many as the sets
+    // need if it has them, in a seeded order
+    int pooled = 0;
+    for (int c = 0; c < class_count; c++) {
+        if (per_paper[c] == 0) continue;
+        int size = per_paper[c] * k < classes[c].size ? per_paper[c] * k : classes[c].size;
+        pool_start[c] = pooled;
+        pool_size[c] = size;
+        memcpy(pool + pooled, order + classes[c].first, sizeof(int) * (size_t)size);
+        if (k > 1) shuffle(pool + pooled, size, options->seed, (uint64_t)c + 1 + SYNTH_MAX_VARIANTS * DIFFICULTY_COUNT);
+        pooled += size;
+    }
+
+    int started = 0;
+    for (int v = 0; v < k; v++) {
+        VariantJob* job = &jobs[v];
+        job->p = p;
+        job->pool = pool;
+        job->pool_start = pool_start;
+        job->pool_size = pool_size;
+        job->per_paper = per_paper;
+        job->options = options;
+        job->variant = &paper->variants[v];
+        job->index = v;
+        job->count = k;
+        job->variant->questions = (int*)arena_alloc(arena, sizeof(int) * (size_t)mix->n);
+        job->scratch = (int*)arena_alloc(arena, sizeof(int) * (size_t)mix->n);
+        if (job->variant->questions == NULL || job->scratch == NULL) return -1;
+    }
+    for (int v = 1; v < k; v++) {
+        if (pthread_create(&ids[v], NULL, assemble_variant, &jobs[v]) != 0) break;
+        started = v;
+    }
+    assemble_variant(&jobs[0]);
+    for (int v = started + 1; v < k; v++) {
+        assemble_variant(&jobs[v]); // Threads that didn't start
+    }
+    for (int v = 1; v <= started; v++) {
+        pthread_join(ids[v], NULL);
+    }
+    return 0;
+}
+
+// Most questions any two sets have in common
+static int max_shared(const PaperVariant* variants, int k, int n) {
+    int most = 0;
+    for (int a = 0; a < k; a++) {
+        for (int b = a + 1; b < k; b++) {
+            int shared = 0;
+            for (int i = 0; i < n; i++) {
+                for (int j = 0; j < n; j++) {
+                    shared += variants[a].questions[i] == variants[b].questions[j];
+                }
+            }
+            if (shared > most) most = shared;
+        }
+    }
+    return most;
+}
+
+// Fills in 'paper' from the best mix. Returns 0, -1 if out of memory.
+static int finish_paper(const Problem* p, int class_count, const int* order,
+                        const SynthesisOptions* options, SynthesizedPaper* paper, Arena* arena) {
+    const QuestionStore* store = p->store;
+    int k = paper->variant_count;
+    paper->status = paper->complete ? SYNTH_OPTIMAL : SYNTH_FEASIBLE;
+    paper->count = p->mixes[p->best_mix].n;
+    paper->topics_covered = p->topics - p->best_score;
+    if (assemble_variants(p, class_count, order, options, paper, arena) != 0) return -1;
+    paper->questions = paper->variants[0].questions;
+    paper->total_marks = paper->total_time = 0;
+    memset(paper->difficulty_count, 0, sizeof(paper->difficulty_count));
+    for (int j = 0; j < paper->count; j++) {
+        int i = paper->questions[j];
+        paper->total_marks += store->marks[i];
+        paper->total_time += store->estimated_time[i];
+        paper->difficulty_count[store->difficulty[i]]++;
+    }
+    paper->overlap_limit = k > 1 ? paper->count * options->max_overlap / 100 : 0;
+    paper->max_shared = max_shared(paper->variants, k, paper->count);
+    if (paper->max_shared > paper->overlap_limit) paper->status = SYNTH_INFEASIBLE; // Too few questions to go round
+    return 0;
+}
+
+/* --- Synthesis Functions --- */
+
+void synthesis_options_init(SynthesisOptions* options) {
+    memset(options, 0, sizeof(*options));
+    options->coverage = SYNTH_DEFAULT_COVERAGE;
+    options->variants = 1;
+    options->max_overlap = SYNTH_DEFAULT_OVERLAP;
+    options->seed = SYNTH_DEFAULT_SEED;
+}
+
+int synthesize_paper(const QuestionStore* store, const ASTNode* root,
+                     const SynthesisOptions* options, SynthesizedPaper* paper, Arena* arena) {
+    memset(paper, 0, sizeof(*paper));
+    Problem* p = (Problem*)arena_alloc(arena, sizeof(Problem));
+    Candidate* cand = (Candidate*)arena_alloc(arena, sizeof(Candidate) * (size_t)(store->count + 1));
+    int* order = (int*)arena_alloc(arena, sizeof(int) * (size_t)(store->count + 1));
+    if (p == NULL || cand == NULL || order == NULL) return -1;
+    memset(p, 0, sizeof(*p));
+    p->store = store;
+    p->marks = options->marks > 0 ? options->marks : root->total_marks;
+    p->budget = options->time > 0 ? options->time : root->total_time;
+    paper->marks = p->marks;
+    paper->time_budget = p->budget;
+    paper->complete = 1;
+    paper->variant_count = options->variants > 1 ? options->variants : 1;
+    if (paper->variant_count > SYNTH_MAX_VARIANTS) paper->variant_count = SYNTH_MAX_VARIANTS;
+    int k = paper->variant_count;
+    paper->seed = options->seed;
+    if (p->marks <= 0 || p->budget <= 0) return 0; // Nothing to aim for
+
+    // --- 1. Candidates and their classes ---
+    int count = 0;
+    for (int i = 0; i < store->count; i++) {
+        if (!is_candidate(store, i, p->marks)) continue;
+        cand[count].difficulty = store->difficulty[i];
+        cand[count].crispness = store->crispness[i];
+        cand[count].topic = store->topic[i];
+        cand[count].marks = store->marks[i];
+        cand[count].index = i;
+        count++;
+    }
+    paper->candidates = count;
+    QuestionClass* classes = NULL;
+    int class_count = build_classes(p, cand, count, order, &classes, arena);
+    if (class_count < 0) return -1;
+    p->classes = classes;
+    for (int d = 0; d < DIFFICULTY_COUNT; d++) {
+        p->lo[d] = p->hi[d] = 0;
+    }
+    for (int c = class_count - 1; c >= 0; c--) p->lo[classes[c].difficulty] = c;
+    for (int c = 0; c < class_count; c++) p->hi[classes[c].difficulty] = c + 1;
+
+    // --- 2. Search and the sets: first with every question available,
+    // then, if the sets share too many, with each class split K ways ---
+    SynthesizedPaper shared;
+    for (int split = 0; split < 2; split++) {
+        for (int c = 0; c < class_count; c++) {
+            classes[c].capacity = split ? classes[c].size / k : classes[c].size;
+        }
+        p->best_mix = -1;
+        if (run_search(p, class_count, root, options, paper, arena) != 0) return -1;
+        if (p->best_mix < 0) {
+            if (split) {
+                shared.mixes = paper->mixes;
+                shared.nodes = paper->nodes;
+                *paper = shared; // Report the sets that share too many
+            } else {
+                paper->status = SYNTH_INFEASIBLE;
+            }
+            return 0;
+        }
+        if (finish_paper(p, class_count, order, options, paper, arena) != 0) return -1;
+        if (paper->status != SYNTH_INFEASIBLE || k == 1) return 0;
+        shared = *paper;
+    }
+    return 0;
+}
+
+/* --- Output --- */
+
+static const char* status_names[] = { "INFEASIBLE", "FEASIBLE", "OPTIMAL" };
+
+// EnhancedPaper.qp: the chosen questions under the bank's header
+static int write_paper_dsl(const SynthesizedPaper* paper, const QuestionStore* store,
+                           const ASTNode* root, const char* path) {
+    FILE* f = fopen(path, "w");
+    if (f == NULL) {
+        perror("Error opening EnhancedPaper.qp");
+        return -1;
+    }
+    fprintf(f, "[HEADER]\n");
+    fprintf(f, "    SUBJECT: \"%s\"\n", root->subject != NULL ? root->subject : "");
+    fprintf(f, "    TOTAL_MARKS: %d\n", paper->marks);
+    fprintf(f, "    TOTAL_TIME: %d\n", paper->time_budget);
+    fprintf(f, "    SYLLABUS_PATH: \"%s\"\n", root->syllabus_path != NULL ? root->syllabus_path : "");
+    fprintf(f, "[/HEADER]\n[QUESTION_LIST]\n");
+    for (int j = 0; j < paper->count; j++) {
+        int i = paper->questions[j];
+        fprintf(f, "    [QUESTION]\n        Q_TEXT: \"%.*s\"\n        Q_MARKS: %d\n    [/QUESTION]\n",
+                (int)store->text_length[i], store->text + store->text_offset[i], store->marks[i]);
+    }
+    fprintf(f, "[/QUESTION_LIST]\n");
+    return fclose(f) == 0 ? 0 : -1;
+}
+
+typedef struct VariantFile {
+    const SynthesizedPaper* paper;
+    const QuestionStore* store;
+    const ASTNode* root;
+    const char* job_dir;
+    int index;
+    int result;
+} VariantFile;
+
+// EnhancedPaper_<k>.tex: one set, laid out like EnhancedPaper.tex
+// (see codegen.h). Each thread has its own writer.
+static void* write_variant_tex(void* arg) {
+    VariantFile* v = (VariantFile*)arg;
+    const QuestionStore* store = v->store;
+    const int* questions = v->paper->variants[v->index].questions;
+    char path[PATH_MAX];
+    int n = snprintf(path, sizeof(path), "%s/EnhancedPaper_%d.tex", v->job_dir, v->index + 1);
+    TexWriter w;
+    v->result = -1;
+    if (n < 0 || (size_t)n >= sizeof(path)) return NULL;
+    if (tex_writer_init(&w) != 0) return NULL;
+    if (tex_writer_begin(&w, path) != 0) {
+        tex_writer_free(&w);
+        return NULL;
+    }
+    tex_raw(&w, "\\documentclass{article}\n\\begin{document}\n\\section*{");
+    tex_text(&w, v->root->subject != NULL ? v->root->subject : "");
+    tex_rawf(&w, " --- Set %c}\n", 'A' + v->index);
+    tex_rawf(&w, "\\noindent Total marks: %d \\hfill Time: %d minutes\n\n",
+             v->paper->total_marks, v->paper->time_budget);
+    for (int j = 0; j < v->paper->count; j++) {
+        int i = questions[j];
+        tex_rawf(&w, "\\paragraph{Q%d (%d marks)} ", j + 1, store->marks[i]);
+        tex_text_n(&w, store->text + store->text_offset[i], store->text_length[i]);
+        tex_raw(&w, "\n\n");
+    }
+    tex_raw(&w, "\\end{document}\n");
+    v->result = tex_writer_end(&w);
+    tex_writer_free(&w);
+    return NULL;
+}
+
+// Every set's .tex, one thread each. Returns 0 on success, -1 on error.
+static int write_variants(const SynthesizedPaper* paper, const QuestionStore* store,
+                          const ASTNode* root, const char* job_dir) {
+    VariantFile files[SYNTH_MAX_VARIANTS];
+    pthread_t ids[SYNTH_MAX_VARIANTS];
+    int started[SYNTH_MAX_VARIANTS];
+    for (int v = 0; v < paper->variant_count; v++) {
+        files[v].paper = paper;
+        files[v].store = store;
+        files[v].root = root;
+        files[v].job_dir = job_dir;
+        files[v].index = v;
+        files[v].result = 0;
+        started[v] = pthread_create(&ids[v], NULL, write_variant_tex, &files[v]) == 0;
+        if (!started[v]) write_variant_tex(&files[v]);
+    }
+    int result = 0;
+    for (int v = 0; v < paper->variant_count; v++) {
+        if (started[v]) pthread_join(ids[v], NULL);
+        if (files[v].result != 0) result = -1;
+    }
+    return result;
+}
+
+int write_synthesis(const SynthesizedPaper* paper, const QuestionStore* store,
+                    const ASTNode* root, const char* job_dir) {
+    char path[PATH_MAX], message[256];
+    if (source_path(path, sizeof(path), job_dir, "synthesis.json") != 0) return -1;
+    JsonWriter w;
+    if (json_writer_open(&w, path) != 0) return -1;
+
+    if (paper->status == SYNTH_INFEASIBLE && paper->count > 0) {
+        snprintf(message, sizeof(message),
+                 "The bank has too few questions for %d sets: two of them share %d of %d questions (at most %d allowed)",
+                 paper->variant_count, paper->max_shared, paper->count, paper->overlap_limit);
+    } else if (paper->status == SYNTH_INFEASIBLE) {
+        snprintf(message, sizeof(message),
+                 "No paper of %d marks within %d minutes meets the difficulty bands and covers %d units%s",
+                 paper->marks, paper->time_budget, paper->topics_required,
+                 paper->complete ? "" : " within the search limits");
+    } else {
+        snprintf(message, sizeof(message), "%d questions, %d marks, %d minutes, %d of %d units covered",
+                 paper->count, paper->total_marks, paper->total_time, paper->topics_covered,
+                 paper->topics_in_bank);
+    }
+    json_begin_object(&w);
+    json_key(&w, "status");
+    json_string(&w, status_names[paper->status]);
+    json_key(&w, "message");
+    json_string(&w, message);
+    json_key(&w, "target_marks");
+    json_int(&w, paper->marks);
+    json_key(&w, "time_budget");
+    json_int(&w, paper->time_budget);
+    json_key(&w, "topics_required");
+    json_int(&w, paper->topics_required);
+    json_key(&w, "topics_in_bank");
+    json_int(&w, paper->topics_in_bank);
+    json_key(&w, "total_marks");
+    json_int(&w, paper->total_marks);
+    json_key(&w, "total_time");
+    json_int(&w, paper->total_time);
+    json_key(&w, "topics_covered");
+    json_int(&w, paper->topics_covered);
+    json_key(&w, "easy_count");
+    json_int(&w, paper->difficulty_count[DIFFICULTY_EASY]);
+    json_key(&w, "medium_count");
+    json_int(&w, paper->difficulty_count[DIFFICULTY_MEDIUM]);
+    json_key(&w, "hard_count");
+    json_int(&w, paper->difficulty_count[DIFFICULTY_HARD]);
+    json_key(&w, "search_complete");
+    json_bool(&w, paper->complete);
+    json_key(&w, "candidates");
+    json_int(&w, paper->candidates);
+    json_key(&w, "mixes");
+    json_int(&w, paper->mixes);
+    json_key(&w, "nodes");
+    json_int(&w, paper->nodes);
+    json_key(&w, "threads");
+    json_int(&w, paper->threads);
+    json_key(&w, "variants");
+    json_int(&w, paper->variant_count);
+    json_key(&w, "seed");
+    json_int(&w, (long)paper->seed);
+    json_key(&w, "max_shared");
+    json_int(&w, paper->max_shared);
+    json_key(&w, "overlap_limit");
+    json_int(&w, paper->overlap_limit);
+
+    json_key(&w, "questions");
+    json_begin_array(&w);
+    for (int j = 0; j < paper->count; j++) {
+        int i = paper->questions[j];
+        json_begin_object(&w);
+        json_key(&w, "bank_question"); // Counting from 1
+        json_int(&w, i + 1);
+        json_key(&w, "text");
+        json_string_n(&w, store->text + store->text_offset[i], store->text_length[i]);
+        json_key(&w, "marks");
+        json_int(&w, store->marks[i]);
+        json_key(&w, "estimated_time");
+        json_int(&w, store->estimated_time[i]);
+        json_key(&w, "difficulty");
+        json_string(&w, difficulty_name(store->difficulty[i]));
+        json_key(&w, "syllabus_topic");
+        json_string(&w, topic_name(&root->topics, store->topic[i]));
+        json_end_object(&w);
+    }
+    json_end_array(&w);
+
+    // Each set as bank question numbers, in paper order
+    json_key(&w, "sets");
+    json_begin_array(&w);
+    for (int v = 0; v < paper->variant_count && paper->count > 0; v++) {
+        json_begin_array(&w);
+        for (int j = 0; j < paper->count; j++) {
+            json_int(&w, paper->variants[v].questions[j] + 1);
+        }
+        json_end_array(&w);
+    }
+    json_end_array(&w);
+    json_end_object(&w);
+    if (json_writer_close(&w) != 0) return -1;
+
+    // No sets left over from an earlier run
+    int written = paper->status == SYNTH_INFEASIBLE || paper->variant_count == 1 ? 0 : paper->variant_count;
+    for (int v = written; v < SYNTH_MAX_VARIANTS; v++) {
+        snprintf(path, sizeof(path), "%s/EnhancedPaper_%d.tex", job_dir, v + 1);
+        unlink(path);
+    }
+
+    snprintf(path, sizeof(path), "%s/EnhancedPaper.qp", job_dir);
+    if (paper->status == SYNTH_INFEASIBLE) {
+        unlink(path); // Not left over from an earlier run
+        return 0;
+    }
+    if (write_paper_dsl(paper, store, root, path) != 0) return -1;
+    return paper->variant_count > 1 ? write_variants(paper, store, root, job_dir) : 0;
+}
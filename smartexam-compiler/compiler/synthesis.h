@@ -0,0 +1,131 @@
+/*
+ * compiler/synthesis.h
+ * Assembles a new paper from a bank of compiled questions:
+ *
+ *     q_compiler --synthesize [--paper-marks=N] [--paper-time=N] [--coverage=P] <bank job dir>
+ *
+ * The bank is an ordinary job whose input.qp holds the spare questions
+ * (thousands of them) and whose header gives the paper to build:
+ * TOTAL_MARKS, TOTAL_TIME and the syllabus. After Phases 1-3 every
+ * question has its marks, time, difficulty and topic, and the selector
+ * picks questions so that
+ *   - the marks add up to the total exactly,
+ *   - the estimated time stays within the time budget,
+ *   - 20-40% are easy, 40-60% medium and 10-30% hard (the bands of
+ *     analyze_difficulty() in the analysis scripts),
+ *   - at least P% of the syllabus units are covered (as many as the
+ *     bank has questions for, if fewer).
+ * Among such papers it covers as many units as it can.
+ *
+ * Only questions Phase 3 marked OK take part, and questions that differ
+ * only in their text are interchangeable, so they are grouped into
+ * classes by (difficulty, topic, marks) and the crispest ones are taken
+ * first. Every difficulty mix (how many easy, medium and hard questions)
+ * that can reach the total is then a separate branch-and-bound search
+ * over those classes. The mixes are spread over a pool of threads, and
+ * the best paper wins, ties going to the mix closest to 30/50/20%. The
+ * result does not depend on the number of threads.
+ *
+ * Writes synthesis.json (the selection and its totals) and
+ * EnhancedPaper.qp (the new paper, which compiles like any other).
+ *
+ * With --variants=K it prints K equivalent sets of the paper instead
+ * (Set A, B, C, ...), to keep students from copying. All of them are
+ * built from the same classes, so their marks, times, difficulties and
+ * topics match question for question; only the questions themselves
+ * differ. Each set takes the same picks from a class as the others, so
+ * they share questions only where a class runs short. If they share
+ * more than --max-overlap percent, the search runs again with each class
+ * split K ways, so that no two sets share any. Which set gets which
+ * question and the order within each set are drawn from --seed, so the
+ * same seed always gives the same sets. The sets are assembled and
+ * written on one thread each, as EnhancedPaper_<k>.tex (k = 1..K).
+ */
+
+#ifndef SYNTHESIS_H
+#define SYNTHESIS_H
+
+#include <stdint.h>
+#include "arena.h"
+#include "ast.h"
+#include "question_store.h"
+
+// Difficulty bands in percent of the questions, as in analyze_difficulty()
+#define SYNTH_EASY_MIN   20
+#define SYNTH_EASY_MAX   40
+#define SYNTH_MEDIUM_MIN 40
+#define SYNTH_MEDIUM_MAX 60
+#define SYNTH_HARD_MIN   10
+#define SYNTH_HARD_MAX   30
+
+#define SYNTH_MAX_QUESTIONS     64     // Longest paper the selector builds
+#define SYNTH_NODE_LIMIT        100000 // Search nodes per difficulty mix
+#define SYNTH_DEFAULT_COVERAGE  80     // Percent of the syllabus units
+#define SYNTH_MAX_VARIANTS      26     // Set A to Set Z
+#define SYNTH_DEFAULT_OVERLAP   20     // Percent of the questions two sets may share
+#define SYNTH_DEFAULT_SEED      1
+
+typedef enum SynthesisStatus {
+    SYNTH_INFEASIBLE = 0, // No paper meets the constraints
+    SYNTH_FEASIBLE,       // Best paper found, but a search that was cut
+                          // short might have covered more units
+    SYNTH_OPTIMAL         // No paper covers more units
+} SynthesisStatus;
+
+typedef struct SynthesisOptions {
+    int marks;    // Total marks; <= 0: TOTAL_MARKS from the header
+    int time;     // Time budget in minutes; <= 0: TOTAL_TIME from the header
+    int coverage; // Percent of the syllabus units to cover
+    int threads;  // <= 0: one per core
+    int variants; // Sets of the paper to print (<= 1: one paper)
+    int max_overlap; // Percent of the questions two sets may share
+    uint64_t seed;   // Decides which set gets which question
+} SynthesisOptions;
+
+// One printed set of the paper
+typedef struct PaperVariant {
+    int* questions;       // Store indexes, in paper order
+} PaperVariant;
+
+typedef struct SynthesizedPaper {
+    SynthesisStatus status;
+    int complete;         // 0 if SYNTH_NODE_LIMIT cut a search short that mattered
+    int* questions;       // Store indexes of the chosen questions, in paper order
+    int count;            // Questions per paper
+    PaperVariant* variants; // variant_count sets (variants[0].questions == questions)
+    int variant_count;
+    uint64_t seed;
+    int max_shared;       // Most questions two sets have in common ...
+    int overlap_limit;    // ... and how many they may
+    int marks;            // Targets ...
+    int time_budget;
+    int topics_required;
+    int total_marks;      // ... and what the paper reaches
+    int total_time;
+    int topics_covered;
+    int topics_in_bank;   // Syllabus units the bank has questions for
+    int difficulty_count[DIFFICULTY_COUNT];
+    int candidates;       // Bank questions that took part
+    int mixes;            // Difficulty mixes searched
+    long nodes;           // Search nodes, over all mixes
+    int threads;          // Threads used
+} SynthesizedPaper;
+
+/* --- Synthesis Functions --- */
+
+// SYNTH_DEFAULT_* values, everything else from the header
+void synthesis_options_init(SynthesisOptions* options);
+
+// Picks questions from 'store' (after Phase 3 on 'root'). The result and
+// all scratch memory come from 'arena'. Returns 0 (see paper->status),
+// -1 if out of memory.
+int synthesize_paper(const QuestionStore* store, const ASTNode* root,
+                     const SynthesisOptions* options, SynthesizedPaper* paper, Arena* arena);
+
+// Writes job_dir/synthesis.json and, if a paper was found,
+// job_dir/EnhancedPaper.qp (or EnhancedPaper_<k>.tex for each set).
+// Returns 0 on success, -1 on error.
+int write_synthesis(const SynthesizedPaper* paper, const QuestionStore* store,
+                    const ASTNode* root, const char* job_dir);
+
+#endif // SYNTHESIS_H
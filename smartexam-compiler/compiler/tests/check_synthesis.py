@@ -0,0 +1,93 @@
+#!/usr/bin/env python3
+#
+# compiler/tests/check_synthesis.py
+# Checks the synthesis.json of a --synthesize run against the bank's
+# semantic_report.json, from the questions themselves rather than the
+# totals the compiler reports.
+# Usage: check_synthesis.py <bank job dir> [--sets=K] [--optimal]
+#   --optimal  the search must also have finished (status OPTIMAL)
+#
+
+import json
+import sys
+
+
+def fail(message):
+    print("  " + message, file=sys.stderr)
+    sys.exit(1)
+
+
+def in_band(count, n, low, high):
+    return count * 100 >= low * n and count * 100 <= high * n
+
+
+def check_set(number, ids, bank, result):
+    if len(set(ids)) != len(ids):
+        fail(f"set {number} uses a question twice: {ids}")
+    questions = []
+    for i in ids:
+        if i < 1 or i > len(bank):
+            fail(f"set {number} has bank question {i}, the bank has {len(bank)}")
+        q = bank[i - 1]
+        if q["status_flag"] != 0:
+            fail(f"set {number} has bank question {i}, which Phase 3 did not mark OK")
+        questions.append(q)
+
+    marks = sum(q["marks"] for q in questions)
+    if marks != result["target_marks"]:
+        fail(f"set {number} has {marks} marks, not {result['target_marks']}")
+    time = sum(q["estimated_time"] for q in questions)
+    if time > result["time_budget"]:
+        fail(f"set {number} takes {time} minutes, over the budget of {result['time_budget']}")
+
+    n = len(questions)
+    for level, low, high in (("EASY", 20, 40), ("MEDIUM", 40, 60), ("HARD", 10, 30)):
+        count = sum(1 for q in questions if q["difficulty"] == level)
+        if not in_band(count, n, low, high):
+            fail(f"set {number} has {count} of {n} {level} questions, outside {low}-{high}%")
+
+    topics = {q["syllabus_topic"] for q in questions} - {"N/A"}
+    if len(topics) < result["topics_required"]:
+        fail(f"set {number} covers {len(topics)} units, fewer than {result['topics_required']}")
+    return topics
+
+
+def main():
+    job_dir = sys.argv[1]
+    sets_expected = 1
+    optimal = False
+    for arg in sys.argv[2:]:
+        if arg.startswith("--sets="):
+            sets_expected = int(arg[len("--sets="):])
+        elif arg == "--optimal":
+            optimal = True
+
+    with open(f"{job_dir}/synthesis.json") as f:
+        result = json.load(f)
+    with open(f"{job_dir}/semantic_report.json") as f:
+        bank = json.load(f)["questions"]
+
+    if result["status"] == "INFEASIBLE":
+        fail(f"status is INFEASIBLE: {result['message']}")
+    if optimal and (result["status"] != "OPTIMAL" or not result["search_complete"]):
+        fail(f"status is {result['status']}, the search did not finish")
+
+    sets = result.get("sets", [[q["bank_question"] for q in result["questions"]]])
+    if len(sets) != sets_expected:
+        fail(f"{len(sets)} sets written, expected {sets_expected}")
+    if [q["bank_question"] for q in result["questions"]] != sets[0]:
+        fail("questions[] is not the first set")
+
+    covered = [check_set(k + 1, ids, bank, result) for k, ids in enumerate(sets)]
+    if len(covered[0]) != result["topics_covered"]:
+        fail(f"topics_covered is {result['topics_covered']}, the paper covers {len(covered[0])}")
+
+    for a in range(len(sets)):
+        for b in range(a + 1, len(sets)):
+            shared = len(set(sets[a]) & set(sets[b]))
+            if shared > result["overlap_limit"]:
+                fail(f"sets {a + 1} and {b + 1} share {shared} questions, over the limit of {result['overlap_limit']}")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,43 @@
+#!/usr/bin/env python3
+#
+# compiler/tests/make_bank.py
+# Writes a generated bank job (input.qp and syllabus.txt) for the
+# synthesis tests. The same arguments always give the same bank.
+# Usage: make_bank.py <job dir> <units> <questions> <seed>
+#
+
+import random
+import sys
+
+UNITS = ["Arrays", "Linked Lists", "Stacks", "Queues", "Trees", "Heaps", "Graphs", "Hashing",
+         "Sorting", "Searching", "Recursion", "Tries", "Matrices", "Strings", "Bitsets", "Deques",
+         "Skip Lists", "Treaps", "Ropes", "Bloom Filters"]
+VERBS = [["Define", "List", "State"], ["Explain", "Compare", "Describe"], ["Design", "Implement", "Evaluate"]]
+WORDS = "alpha beta gamma delta epsilon zeta eta theta iota kappa lambda mu nu xi pi rho sigma tau".split()
+MARKS = [2, 3, 5, 8, 10, 12]
+
+
+def main():
+    out = sys.argv[1]
+    units = UNITS[:int(sys.argv[2])]
+    count = int(sys.argv[3])
+    rng = random.Random(int(sys.argv[4]))
+
+    with open(out + "/syllabus.txt", "w") as f:
+        f.write("Data Structures Syllabus\n")
+        for n, unit in enumerate(units, 1):
+            f.write(f"{n}. {unit}: {unit.lower()} basics.\n")
+
+    with open(out + "/input.qp", "w") as f:
+        f.write('[HEADER]\n    SUBJECT: "Data Structures"\n    TOTAL_MARKS: 100\n    TOTAL_TIME: 360\n'
+                '    SYLLABUS_PATH: "syllabus.txt"\n[/HEADER]\n[QUESTION_LIST]\n')
+        for i in range(count):
+            level = rng.choice([0, 0, 1, 1, 1, 2])
+            text = (f"{rng.choice(VERBS[level])} {rng.choice(units).lower()} basics case {i} with "
+                    + " ".join(rng.sample(WORDS, 6)) + ".")
+            f.write(f'    [QUESTION]\n        Q_TEXT: "{text}"\n        Q_MARKS: {rng.choice(MARKS)}\n    [/QUESTION]\n')
+        f.write("[/QUESTION_LIST]\n")
+
+
+if __name__ == "__main__":
+    main()
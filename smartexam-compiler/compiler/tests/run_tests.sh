@@ -0,0 +1,31 @@
+#!/bin/bash
+#
+# compiler/tests/run_tests.sh
+# Runs every tests/test_*.sh against a q_compiler binary.
+# Usage: tests/run_tests.sh ./q_compiler   (or just "make test")
+#
+
+COMPILER="$(cd "$(dirname "${1:-./q_compiler}")" && pwd)/$(basename "${1:-./q_compiler}")"
+TESTS_DIR="$(cd "$(dirname "$0")" && pwd)"
+
+if [ ! -x "$COMPILER" ]; then
+    echo "run_tests.sh: no compiler at $COMPILER (run make first)" >&2
+    exit 2
+fi
+
+failed=0
+for test in "$TESTS_DIR"/test_*.sh; do
+    name="$(basename "$test" .sh)"
+    if bash "$test" "$COMPILER" "$TESTS_DIR/fixtures"; then
+        echo "PASS: $name"
+    else
+        echo "FAIL: $name"
+        failed=$((failed + 1))
+    fi
+done
+
+if [ "$failed" -ne 0 ]; then
+    echo "$failed test script(s) failed"
+    exit 1
+fi
+echo "All tests passed"
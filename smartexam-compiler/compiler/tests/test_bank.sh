@@ -0,0 +1,69 @@
+#!/bin/bash
+#
+# compiler/tests/test_bank.sh
+# The question bank (see question_bank.h) must find a paper's questions
+# in later papers, keep every job it has seen, start again only when the
+# file is damaged, and leave alone a bank it just can't read.
+# Usage: test_bank.sh <q_compiler> <fixtures dir>
+#
+
+COMPILER="$1"
+FIXTURE="$2/incremental"
+WORK="$(mktemp -d)"
+trap 'rm -rf "$WORK"' EXIT
+BANK="$WORK/question_bank.idx"
+
+fail() {
+    echo "  $*" >&2
+    exit 1
+}
+
+# compile <job name>: a copy of the fixture, checked against the bank
+# next to it
+compile() {
+    mkdir -p "$WORK/$1"
+    cp "$FIXTURE/input.qp" "$FIXTURE/syllabus.txt" "$WORK/$1/"
+    (cd "$WORK" && "$COMPILER" --no-cache "$1") > "$WORK/$1.log" 2>&1 ||
+        fail "compile of $1 failed, see:" "$(cat "$WORK/$1.log")"
+}
+
+# report <job name> <python expression on r, the semantic report>
+report() {
+    python3 -c "import json, sys; r = json.load(open(sys.argv[1])); print($2)" "$WORK/$1/semantic_report.json"
+}
+
+# The header's job_count
+job_count() {
+    python3 -c "import struct, sys; print(struct.unpack_from('=I', open(sys.argv[1], 'rb').read(), 12)[0])" "$BANK"
+}
+
+# --- 1. A second paper with the same questions ---
+compile a
+compile b
+[ "$(report b "r['checks']['question_bank']['reused_count']")" = "10" ] ||
+    fail "b reused $(report b "r['checks']['question_bank']['reused_count']") questions of a, not 10"
+[ "$(report b "r['questions'][3]['bank_match']['job_id']")" = "a" ] || fail "b's question 4 was not found in a"
+[ "$(job_count)" = "2" ] || fail "the bank holds $(job_count) jobs, not 2"
+
+# Recompiling a replaces its questions rather than adding them again
+compile a
+[ "$(job_count)" = "2" ] || fail "after recompiling a the bank holds $(job_count) jobs, not 2"
+
+# --- 2. A damaged bank is started again ---
+printf '\377\377\377\377' | dd of="$BANK" bs=1 seek=12 conv=notrunc 2> /dev/null
+compile c
+grep -q "Rebuilding damaged question bank" "$WORK/c.log" || fail "a damaged bank was not rebuilt"
+[ "$(job_count)" = "1" ] || fail "the rebuilt bank holds $(job_count) jobs, not 1"
+
+# --- 3. One that can't be read is left as it is ---
+# (A directory: open() works, mmap() fails with ENODEV, not EINVAL)
+mv "$BANK" "$WORK/saved.idx"
+mkdir "$BANK"
+touch "$BANK/keep"
+compile d
+grep -q "Rebuilding" "$WORK/d.log" && fail "an unreadable bank was treated as damaged"
+grep -q "Could not add d to question bank" "$WORK/d.log" || fail "no warning that d was not added"
+[ -f "$BANK/keep" ] || fail "the unreadable bank was replaced"
+[ -f "$WORK/d/semantic_report.json" ] || fail "d was not compiled"
+
+exit 0
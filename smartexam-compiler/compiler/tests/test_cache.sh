@@ -0,0 +1,80 @@
+#!/bin/bash
+#
+# compiler/tests/test_cache.sh
+# A second upload of the same paper must hit the compile cache (see
+# compile_cache.h): with the question bank only its tokens and AST are
+# reused and Phase 3 still runs against the bank, without it every
+# output is. Either way the outputs must match a compile from scratch.
+# Usage: test_cache.sh <q_compiler> <fixtures dir>
+#
+
+COMPILER="$1"
+FIXTURE="$2/incremental"
+WORK="$(mktemp -d)"
+trap 'rm -rf "$WORK"' EXIT
+mkdir "$WORK/cached" "$WORK/fresh"
+
+fail() {
+    echo "  $*" >&2
+    exit 1
+}
+
+# compile <dir> <job name> [options...]: a copy of the fixture
+compile() {
+    local dir="$WORK/$1" job="$2"
+    shift 2
+    mkdir -p "$dir/$job"
+    cp "$FIXTURE/input.qp" "$FIXTURE/syllabus.txt" "$dir/$job/"
+    (cd "$dir" && "$COMPILER" "$@" "$job") > "$dir/$job.log" 2>&1 ||
+        fail "compile of $job failed, see:" "$(cat "$dir/$job.log")"
+}
+
+# same <job name> <files...>: cached/<job> and fresh/<job> agree
+same() {
+    local job="$1" file
+    shift
+    for file in "$@"; do
+        cmp -s "$WORK/cached/$job/$file" "$WORK/fresh/$job/$file" ||
+            fail "$file of $job differs from a compile without the cache"
+    done
+}
+
+OUTPUTS="tokens.json ast.dot ast.json semantic_report.json optimization_log.json
+         EnhancedPaper.tex AnalysisReport.tex"
+
+# --- 1. With the question bank (the default) ---
+compile cached a
+compile cached b
+grep -q "compile cache" "$WORK/cached/a.log" && fail "the first compile hit the cache"
+grep -q "Tokens and AST reused from compile cache" "$WORK/cached/b.log" ||
+    fail "the second identical job missed the cache"
+grep -q "Re-lexed 0 of 10 questions" "$WORK/cached/b.log" || fail "b lexed questions again"
+grep -q "Phase 3 (Semantic) Complete" "$WORK/cached/b.log" || fail "b skipped Phase 3"
+
+# b still finds a's questions in the bank
+compile fresh a --no-cache
+compile fresh b --no-cache
+same b $OUTPUTS fingerprints.bin
+reused="$(python3 -c "import json, sys; print(json.load(open(sys.argv[1]))['checks']['question_bank']['reused_count'])" \
+          "$WORK/cached/b/semantic_report.json")"
+[ "$reused" = "10" ] || fail "b reused $reused questions of a, not 10"
+
+# An edited paper is a miss
+mkdir -p "$WORK/cached/c"
+sed 's/four conditions/four necessary conditions/' "$FIXTURE/input.qp" > "$WORK/cached/c/input.qp"
+cp "$FIXTURE/syllabus.txt" "$WORK/cached/c/"
+(cd "$WORK/cached" && "$COMPILER" c) > "$WORK/cached/c.log" 2>&1 || fail "compile of c failed"
+grep -q "compile cache" "$WORK/cached/c.log" && fail "an edited paper hit the cache"
+
+# --- 2. Without it every output is reused ---
+# (The entries above only hold Phases 1 & 2, so the first one is a miss)
+compile cached x --no-bank
+compile cached y --no-bank
+grep -q "compile cache" "$WORK/cached/x.log" && fail "a --no-bank job used a question bank job's entry"
+grep -q "Outputs reused from compile cache" "$WORK/cached/y.log" ||
+    fail "the second identical --no-bank job missed the cache"
+grep -q "Phase 3" "$WORK/cached/y.log" && fail "y ran Phase 3 on a full hit"
+compile fresh y --no-bank --no-cache
+same y $OUTPUTS
+
+exit 0
@@ -0,0 +1,109 @@
+#!/bin/bash
+#
+# compiler/tests/test_incremental.sh
+# An incremental recompile (see incremental.h) must write the same files,
+# byte for byte, as a full compile of the same input.qp.
+# Usage: test_incremental.sh <q_compiler> <fixtures dir>
+#
+
+COMPILER="$1"
+FIXTURE="$2/incremental"
+WORK="$(mktemp -d)"
+trap 'rm -rf "$WORK"' EXIT
+
+# Outputs that depend on the tokens or the AST
+OUTPUTS="tokens.json tokens.bin ast.json semantic_report.json"
+
+fail() {
+    echo "  $*" >&2
+    exit 1
+}
+
+# compile <job dir> [options...]: the bank and the compile cache would
+# skip or change the compile, so both are off
+compile() {
+    local dir="$1"
+    shift
+    (cd "$dir" && "$COMPILER" --no-bank --no-cache --tokens=both "$@" .) > "$dir.log" 2>&1 ||
+        fail "compile of $dir failed, see:" "$(cat "$dir.log")"
+}
+
+# same_outputs <dir a> <dir b>
+same_outputs() {
+    for f in $OUTPUTS; do
+        cmp -s "$1/$f" "$2/$f" || fail "$f differs between $1 and the full compile"
+    done
+}
+
+# full_compile <name>: a fresh copy of 'inc' compiled from scratch
+full_compile() {
+    mkdir "$WORK/$1"
+    cp "$FIXTURE/syllabus.txt" "$WORK/inc/input.qp" "$WORK/$1/"
+    compile "$WORK/$1" --no-incremental
+}
+
+# --- 1. Edit one question, recompile ---
+mkdir "$WORK/inc"
+cp "$FIXTURE/input.qp" "$FIXTURE/syllabus.txt" "$WORK/inc/"
+compile "$WORK/inc"
+[ -f "$WORK/inc/fingerprints.bin" ] || fail "the first compile wrote no fingerprints.bin"
+
+# A longer text, so every later question moves
+sed -i 's/List the four conditions for a deadlock./List the four necessary conditions for a deadlock to occur./' "$WORK/inc/input.qp"
+compile "$WORK/inc"
+grep -q "Re-lexed 1 of 10 questions" "$WORK/inc.log" || fail "the recompile did not re-lex just one question"
+
+full_compile full
+same_outputs "$WORK/inc" "$WORK/full"
+
+# --- 2. A damaged fingerprints.bin means a full compile ---
+# Cut short
+sed -i 's/Explain paging with a two level page table./Explain paging with a three level page table./' "$WORK/inc/input.qp"
+truncate -s -7 "$WORK/inc/fingerprints.bin"
+compile "$WORK/inc"
+grep -q "Ignoring damaged" "$WORK/inc.log" || fail "a truncated fingerprints.bin was not rejected"
+grep -q "AST built" "$WORK/inc.log" || fail "a truncated fingerprints.bin did not fall back to a full compile"
+full_compile full2
+same_outputs "$WORK/inc" "$WORK/full2"
+
+# Wrong magic
+sed -i 's/Define the process states/Define the five process states/' "$WORK/inc/input.qp"
+printf 'XXXX' | dd of="$WORK/inc/fingerprints.bin" bs=1 seek=0 conv=notrunc 2> /dev/null
+compile "$WORK/inc"
+grep -q "Ignoring damaged" "$WORK/inc.log" || fail "a fingerprints.bin with a bad header was not rejected"
+grep -q "AST built" "$WORK/inc.log" || fail "a fingerprints.bin with a bad header did not fall back to a full compile"
+full_compile full3
+same_outputs "$WORK/inc" "$WORK/full3"
+
+# Syllabus units the syllabus doesn't have (the unit ids are the last
+# section of the file)
+python3 - "$WORK/inc/fingerprints.bin" <<'PY'
+import struct, sys
+data = bytearray(open(sys.argv[1], "rb").read())
+units = struct.unpack_from("=I", data, 16)[0]  # unit_count
+assert units > 0
+struct.pack_into("=%dH" % units, data, len(data) - 2 * units, *([60000] * units))
+open(sys.argv[1], "wb").write(data)
+PY
+compile "$WORK/inc"
+grep -q "Ignoring damaged" "$WORK/inc.log" || fail "a fingerprints.bin with unknown units was not rejected"
+full_compile full4
+same_outputs "$WORK/inc" "$WORK/full4"
+
+# A token past the end of its question
+python3 - "$WORK/inc/fingerprints.bin" <<'PY'
+import struct, sys
+data = bytearray(open(sys.argv[1], "rb").read())
+token_count, unit_count = struct.unpack_from("=II", data, 12)
+tokens = len(data) - 2 * unit_count - 16 * token_count  # TokenRecord[]
+first = struct.unpack_from("=I", data, 96 + 12)[0]      # Question 1's token_first
+struct.pack_into("=I", data, tokens + 16 * first + 8, 0xFFFFFF00)  # Its offset
+open(sys.argv[1], "wb").write(data)
+PY
+compile "$WORK/inc"
+grep -q "Ignoring damaged" "$WORK/inc.log" || fail "a fingerprints.bin with a token out of range was not rejected"
+grep -q "AST built" "$WORK/inc.log" || fail "a token out of range did not fall back to a full compile"
+full_compile full5
+same_outputs "$WORK/inc" "$WORK/full5"
+
+exit 0
@@ -0,0 +1,58 @@
+#!/bin/bash
+#
+# compiler/tests/test_optimizer.sh
+# Phase 5 (see optimizer.h) must start from the time Phase 3 reports,
+# fit the question times to TOTAL_TIME when the paper is close enough,
+# and leave them alone (PARTIAL) when Phase 3 finds the paper too long.
+# Usage: test_optimizer.sh <q_compiler> <fixtures dir>
+#
+
+COMPILER="$1"
+FIXTURE="$2/incremental"
+WORK="$(mktemp -d)"
+trap 'rm -rf "$WORK"' EXIT
+
+fail() {
+    echo "  $*" >&2
+    exit 1
+}
+
+# compile <total time>: the fixture (70 marks, 246 minutes of questions)
+# with another TOTAL_TIME; prints "<change> <report estimate> <time
+# before> <time after> <time rewrites>"
+compile() {
+    local dir="$WORK/t$1"
+    mkdir "$dir"
+    sed "s/TOTAL_TIME: [0-9]*/TOTAL_TIME: $1/" "$FIXTURE/input.qp" > "$dir/input.qp"
+    cp "$FIXTURE/syllabus.txt" "$dir/"
+    "$COMPILER" --no-bank --no-cache "$dir" > "$dir.log" 2>&1 ||
+        fail "compile with TOTAL_TIME $1 failed, see:" "$(cat "$dir.log")"
+    python3 - "$dir" <<'PY'
+import json, sys
+report = json.load(open(sys.argv[1] + "/semantic_report.json"))
+log = json.load(open(sys.argv[1] + "/optimization_log.json"))
+times = [r for r in log[1:] if r["change"] == "TIME"]
+print(log[0]["change"], report["checks"]["time_estimation"]["estimated_time"],
+      log[0]["time_before"], log[0]["time_after"], len(times))
+PY
+}
+
+# --- 1. Far too long: the estimates stay, and the log says so ---
+read change estimate before after rewrites <<< "$(compile 90)"
+[ "$estimate" = "$before" ] || fail "Phase 3 estimates $estimate minutes, Phase 5 starts from $before"
+[ "$change" = "PARTIAL" ] || fail "a paper $((estimate - 90)) minutes too long was logged as $change"
+[ "$after" = "$estimate" ] && [ "$rewrites" = "0" ] ||
+    fail "the times of a paper that is too long were changed ($rewrites rewrites, $after minutes)"
+grep -q "cut questions or allow more time" "$WORK/t90/optimization_log.json" || fail "no advice for a paper that is too long"
+
+# --- 2. Within the report's tolerance: fitted exactly ---
+read change estimate before after rewrites <<< "$(compile $((estimate - 10)))"
+[ "$change" = "REBALANCE" ] && [ "$after" = "$((estimate - 10))" ] ||
+    fail "a paper 10 minutes over was not fitted ($change, $after minutes)"
+
+# --- 3. Time to spare: handed out ---
+read change estimate before after rewrites <<< "$(compile 300)"
+[ "$change" = "REBALANCE" ] && [ "$after" = "300" ] ||
+    fail "a paper with time to spare was not fitted ($change, $after minutes)"
+
+exit 0
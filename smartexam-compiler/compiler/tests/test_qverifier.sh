@@ -0,0 +1,68 @@
+#!/bin/bash
+#
+# compiler/tests/test_qverifier.sh
+# libqverifier (see qverifier.h) must compile a paper without touching
+# the disk: no fingerprints.bin in the caller's directory or in base_dir,
+# whichever phases run first.
+# Usage: test_qverifier.sh <q_compiler> <fixtures dir>
+#
+
+LIB="$(dirname "$1")/libqverifier.so"
+FIXTURE="$(cd "$2/incremental" && pwd)"
+WORK="$(mktemp -d)"
+trap 'rm -rf "$WORK"' EXIT
+
+fail() {
+    echo "  $*" >&2
+    exit 1
+}
+
+[ -f "$LIB" ] || fail "no $LIB (run make first)"
+
+# paper <base dir or ""> <phase...>: runs the phases on the fixture in
+# $WORK/cwd and prints the last status (the library logs to stdout too)
+paper() {
+    rm -f "$WORK/status"
+    (cd "$WORK/cwd" && python3 - "$LIB" "$FIXTURE/input.qp" "$WORK/status" "$@") > /dev/null 2>&1 <<'PY'
+import ctypes, sys
+lib = ctypes.CDLL(sys.argv[1])
+vp = ctypes.c_void_p
+lib.qv_compiler_new.restype = vp
+lib.qv_paper_new.restype = vp
+lib.qv_paper_new.argtypes = [vp, ctypes.c_char_p, ctypes.c_size_t, ctypes.c_char_p]
+lib.qv_paper_free.argtypes = [vp]
+lib.qv_compiler_free.argtypes = [vp]
+source = open(sys.argv[2], "rb").read()
+compiler = lib.qv_compiler_new()
+paper = lib.qv_paper_new(compiler, source, len(source), sys.argv[4].encode() or None)
+status = -1
+for phase in sys.argv[5:]:
+    getattr(lib, phase).argtypes = [vp]
+    status = getattr(lib, phase)(paper)
+lib.qv_paper_free(paper)
+lib.qv_compiler_free(compiler)
+open(sys.argv[3], "w").write(str(status))
+PY
+    cat "$WORK/status" 2> /dev/null
+}
+
+mkdir "$WORK/cwd" "$WORK/job"
+
+# --- 1. No base_dir: nothing appears in the working directory ---
+[ "$(paper "" qv_lex qv_compile)" = "0" ] || fail "qv_lex + qv_compile failed"
+[ "$(paper "" qv_compile)" = "0" ] || fail "qv_compile failed"
+[ -z "$(ls -A "$WORK/cwd")" ] || fail "the library wrote $(ls -A "$WORK/cwd") into its working directory"
+
+# --- 2. A job's base_dir: its fingerprints.bin is neither read nor replaced ---
+cp "$FIXTURE/input.qp" "$FIXTURE/syllabus.txt" "$WORK/job/"
+"$1" --no-bank --no-cache "$WORK/job" > /dev/null 2>&1 || fail "compile of the job failed"
+cp "$WORK/job/fingerprints.bin" "$WORK/saved.bin"
+ls -l --time-style=+%s.%N "$WORK/job" > "$WORK/before"
+sleep 0.01
+[ "$(paper "$WORK/job" qv_lex qv_compile)" = "0" ] || fail "qv_lex + qv_compile with a base_dir failed"
+cmp -s "$WORK/job/fingerprints.bin" "$WORK/saved.bin" || fail "the library changed the job's fingerprints.bin"
+ls -l --time-style=+%s.%N "$WORK/job" > "$WORK/after"
+cmp -s "$WORK/before" "$WORK/after" || fail "the library changed files in base_dir:" "$(diff "$WORK/before" "$WORK/after")"
+[ -z "$(ls -A "$WORK/cwd")" ] || fail "the library wrote $(ls -A "$WORK/cwd") into its working directory"
+
+exit 0
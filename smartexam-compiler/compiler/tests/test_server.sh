@@ -0,0 +1,92 @@
+#!/bin/bash
+#
+# compiler/tests/test_server.sh
+# --serve (see server.h): clients that connect and send nothing must
+# not hold up other clients' jobs, or the server's shutdown.
+# Usage: test_server.sh <q_compiler> <fixtures dir>
+#
+
+COMPILER="$1"
+FIXTURE="$2/incremental"
+WORK="$(mktemp -d)"
+SOCKET="$WORK/q_compiler.sock"
+SERVER=""
+trap '[ -n "$SERVER" ] && kill -9 "$SERVER" 2> /dev/null; rm -rf "$WORK"' EXIT
+
+fail() {
+    echo "  $*" >&2
+    exit 1
+}
+
+mkdir "$WORK/job"
+cp "$FIXTURE/input.qp" "$FIXTURE/syllabus.txt" "$WORK/job/"
+"$COMPILER" --no-bank --no-cache --serve="$SOCKET" > "$WORK/server.log" 2>&1 &
+SERVER=$!
+for i in $(seq 50); do
+    [ -S "$SOCKET" ] && break
+    sleep 0.1
+done
+[ -S "$SOCKET" ] || fail "the server did not start, see:" "$(cat "$WORK/server.log")"
+
+# Holds SERVER_MAX_WORKERS silent connections open, more than there are
+# worker slots on any host, then sends PING and COMPILE on their own
+# connections. Exits 0 if they are answered and SIGTERM closes the others.
+python3 - "$SOCKET" "$WORK/job" "$SERVER" << 'PY'
+import os, signal, socket, sys
+path, job, server = sys.argv[1], sys.argv[2], int(sys.argv[3])
+
+def fail(message):
+    print("  " + message, file=sys.stderr)
+    sys.exit(1)
+
+def request(line, timeout=10):
+    s = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+    s.connect(path)
+    s.settimeout(timeout)
+    with s, s.makefile("rw", encoding="utf-8", newline="\n") as f:
+        f.write(line + "\n")
+        f.flush()
+        for reply in f:
+            if not reply.startswith("PROGRESS "):
+                return reply.rstrip("\n")
+    return None
+
+idle = []
+# connect() blocks while the server's backlog is full
+signal.signal(signal.SIGALRM, lambda *_: fail("the server stopped accepting connections"))
+signal.alarm(10)
+for _ in range(32):
+    idle.append(socket.socket(socket.AF_UNIX, socket.SOCK_STREAM))
+    idle[-1].connect(path)
+signal.alarm(0)
+try:
+    if request("PING") != "PONG":
+        fail("no PONG while another client is idle")
+    if request("COMPILE " + job) != "DONE OK":
+        fail("COMPILE was not done while another client is idle")
+except socket.timeout:
+    fail("a silent client held up the other clients")
+
+# The server must stop while the idle clients are still connected
+os.kill(server, signal.SIGTERM)
+for s in idle:
+    s.settimeout(3)
+    try:
+        if s.recv(1) != b"":
+            fail("an idle connection got data instead of being closed")
+    except socket.timeout:
+        fail("an idle connection was still open 3 s after SIGTERM")
+PY
+[ $? -eq 0 ] || exit 1
+
+# The server is this shell's child, so wait for it here
+for i in $(seq 30); do
+    kill -0 "$SERVER" 2> /dev/null || break
+    sleep 0.1
+done
+kill -0 "$SERVER" 2> /dev/null && fail "the server was still running 3 s after SIGTERM"
+wait "$SERVER" || fail "the server exited with an error, see:" "$(cat "$WORK/server.log")"
+SERVER=""
+[ -e "$SOCKET" ] && fail "the socket was not removed"
+grep -q "q_compiler server stopped" "$WORK/server.log" || fail "no clean shutdown, see:" "$(cat "$WORK/server.log")"
+exit 0
@@ -0,0 +1,70 @@
+#!/bin/bash
+#
+# compiler/tests/test_synthesis.sh
+# --synthesize (see synthesis.h) must find the known best paper of a
+# small bank, keep to the marks, time, bands and coverage, and write the
+# same paper however many threads search for it.
+# Usage: test_synthesis.sh <q_compiler> <fixtures dir>
+#
+
+COMPILER="$1"
+FIXTURES="$2"
+TESTS_DIR="$(cd "$(dirname "$0")" && pwd)"
+WORK="$(mktemp -d)"
+trap 'rm -rf "$WORK"' EXIT
+
+fail() {
+    echo "  $*" >&2
+    exit 1
+}
+
+# synthesize <bank dir> [options...]: returns the compiler's exit code
+synthesize() {
+    local dir="$1"
+    shift
+    (cd "$dir" && "$COMPILER" --synthesize "$@" .) > "$dir.log" 2>&1
+}
+
+# field <bank dir> <python expression on r, the synthesis.json>
+field() {
+    python3 -c "import json, sys; r = json.load(open(sys.argv[1])); print($2)" "$1/synthesis.json"
+}
+
+# --- 1. The fixture bank ---
+# 5 units, 10 questions, a 30 mark and 105 minute paper. Only 5 questions
+# fit the bands (2 easy, 2 medium, 1 hard) and 30 marks while covering
+# every unit: 1, 2, 4, 5 and 8, which take 102 minutes.
+mkdir "$WORK/bank"
+cp "$FIXTURES/synthesis/input.qp" "$FIXTURES/synthesis/syllabus.txt" "$WORK/bank/"
+synthesize "$WORK/bank" --threads=1 || fail "synthesis failed, see:" "$(cat "$WORK/bank.log")"
+python3 "$TESTS_DIR/check_synthesis.py" "$WORK/bank" --optimal || exit 1
+[ "$(field "$WORK/bank" "r['sets']")" = "[[1, 2, 4, 5, 8]]" ] ||
+    fail "expected questions [1, 2, 4, 5, 8], got $(field "$WORK/bank" "r['sets']")"
+[ "$(field "$WORK/bank" "(r['topics_covered'], r['total_time'])")" = "(5, 102)" ] ||
+    fail "expected 5 units in 102 minutes, got $(field "$WORK/bank" "(r['topics_covered'], r['total_time'])")"
+[ -s "$WORK/bank/EnhancedPaper.qp" ] || fail "no EnhancedPaper.qp written"
+
+# A minute less and no paper keeps to the time budget
+synthesize "$WORK/bank" --paper-time=101 && fail "synthesis within 101 minutes should fail"
+[ "$(field "$WORK/bank" "r['status']")" = "INFEASIBLE" ] || fail "synthesis within 101 minutes was not INFEASIBLE"
+
+# --- 2. The same paper on 1 and 4 threads ---
+# A bigger bank: 300 questions on 20 units, which takes some 15 million
+# nodes, so the threads share out the mixes and prune each other's
+mkdir "$WORK/one"
+python3 "$TESTS_DIR/make_bank.py" "$WORK/one" 20 300 22
+cp -r "$WORK/one" "$WORK/four"
+synthesize "$WORK/one" --threads=1 || fail "synthesis on 1 thread failed, see:" "$(cat "$WORK/one.log")"
+synthesize "$WORK/four" --threads=4 || fail "synthesis on 4 threads failed, see:" "$(cat "$WORK/four.log")"
+python3 "$TESTS_DIR/check_synthesis.py" "$WORK/one" --optimal || exit 1
+[ "$(field "$WORK/four" "r['threads']")" = "4" ] || fail "the search did not run on 4 threads"
+
+# Only the thread count may differ, and the nodes searched: a thread can
+# find a good paper sooner or later than on its own, and prune more or less
+for f in synthesis.json EnhancedPaper.qp; do
+    grep -Ev '"(threads|nodes)":' "$WORK/one/$f" > "$WORK/one.out"
+    grep -Ev '"(threads|nodes)":' "$WORK/four/$f" > "$WORK/four.out"
+    cmp -s "$WORK/one.out" "$WORK/four.out" || fail "$f differs between 1 and 4 threads"
+done
+
+exit 0
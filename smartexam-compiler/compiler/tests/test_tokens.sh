@@ -0,0 +1,39 @@
+#!/bin/bash
+#
+# compiler/tests/test_tokens.sh
+# --export-tokens must rebuild the same tokens.json from tokens.bin, and
+# fail, leaving no tokens.json, on a record outside input.qp.
+# Usage: test_tokens.sh <q_compiler> <fixtures dir>
+#
+
+COMPILER="$1"
+FIXTURE="$2/incremental"
+WORK="$(mktemp -d)"
+trap 'rm -rf "$WORK"' EXIT
+JOB="$WORK/job"
+
+fail() {
+    echo "  $*" >&2
+    exit 1
+}
+
+mkdir "$JOB"
+cp "$FIXTURE/input.qp" "$FIXTURE/syllabus.txt" "$JOB/"
+(cd "$JOB" && "$COMPILER" --no-bank --no-cache --no-incremental --tokens=both .) > "$WORK/log" 2>&1 ||
+    fail "compile failed, see:" "$(cat "$WORK/log")"
+cp "$JOB/tokens.json" "$WORK/tokens.json"
+
+# --- 1. The same tokens.json ---
+"$COMPILER" --export-tokens "$JOB" > "$WORK/log" 2>&1 || fail "--export-tokens failed:" "$(cat "$WORK/log")"
+cmp -s "$JOB/tokens.json" "$WORK/tokens.json" || fail "the exported tokens.json differs from the lexer's"
+
+# --- 2. Token 5 points past the end of input.qp ---
+python3 - "$JOB/tokens.bin" << 'PY'
+import struct, sys
+data = bytearray(open(sys.argv[1], "rb").read())
+struct.pack_into("=I", data, 16 + 16 * 5 + 8, 1000000)  # The record's offset
+open(sys.argv[1], "wb").write(data)
+PY
+"$COMPILER" --export-tokens "$JOB" > "$WORK/log" 2>&1 && fail "--export-tokens accepted a record outside input.qp"
+[ -e "$JOB/tokens.json" ] && fail "a cut-off tokens.json was left behind"
+exit 0
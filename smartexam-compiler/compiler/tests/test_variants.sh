@@ -0,0 +1,68 @@
+#!/bin/bash
+#
+# compiler/tests/test_variants.sh
+# --variants=K (see synthesis.h) must write K sets that each keep to the
+# constraints and share no more than --max-overlap, and the same --seed
+# must always deal out the same sets.
+# Usage: test_variants.sh <q_compiler> <fixtures dir>
+#
+
+COMPILER="$1"
+TESTS_DIR="$(cd "$(dirname "$0")" && pwd)"
+WORK="$(mktemp -d)"
+trap 'rm -rf "$WORK"' EXIT
+
+OUTPUTS="synthesis.json EnhancedPaper.qp EnhancedPaper_1.tex EnhancedPaper_2.tex EnhancedPaper_3.tex"
+
+fail() {
+    echo "  $*" >&2
+    exit 1
+}
+
+# run <name> [options...]: 3 sets from a copy of the bank
+run() {
+    local dir="$WORK/$1"
+    shift
+    cp -r "$WORK/bank" "$dir"
+    (cd "$dir" && "$COMPILER" --synthesize --variants=3 "$@" .) > "$dir.log" 2>&1 ||
+        fail "synthesis failed, see:" "$(cat "$dir.log")"
+}
+
+# same <dir a> <dir b>: every output matches, but for the thread count
+# and the nodes searched (see test_synthesis.sh)
+same() {
+    for f in $OUTPUTS; do
+        [ -f "$WORK/$1/$f" ] || fail "$1 has no $f"
+        grep -Ev '"(threads|nodes)":' "$WORK/$1/$f" > "$WORK/a.out"
+        grep -Ev '"(threads|nodes)":' "$WORK/$2/$f" > "$WORK/b.out"
+        cmp -s "$WORK/a.out" "$WORK/b.out" || fail "$f differs between $1 and $2"
+    done
+}
+
+sets() {
+    python3 -c "import json, sys; print(json.load(open(sys.argv[1]))['sets'])" "$WORK/$1/synthesis.json"
+}
+
+# 600 questions on 12 units: enough for 3 sets with no question in common
+mkdir "$WORK/bank"
+python3 "$TESTS_DIR/make_bank.py" "$WORK/bank" 12 600 23
+
+run seed7 --seed=7 --threads=1
+python3 "$TESTS_DIR/check_synthesis.py" "$WORK/seed7" --sets=3 --optimal || exit 1
+
+# --- 1. The same seed, the same sets, on any number of threads ---
+run again --seed=7 --threads=1
+same seed7 again
+run threads --seed=7 --threads=4
+same seed7 threads
+
+# --- 2. Another seed deals the questions out differently ---
+run seed8 --seed=8 --threads=1
+python3 "$TESTS_DIR/check_synthesis.py" "$WORK/seed8" --sets=3 --optimal || exit 1
+[ "$(sets seed7)" != "$(sets seed8)" ] || fail "--seed=7 and --seed=8 gave the same sets"
+
+# --- 3. No more shared questions than --max-overlap allows ---
+run overlap --seed=7 --threads=1 --max-overlap=10
+python3 "$TESTS_DIR/check_synthesis.py" "$WORK/overlap" --sets=3 || exit 1
+
+exit 0
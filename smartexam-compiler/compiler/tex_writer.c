@@ -0,0 +1,124 @@
+/*
+ * compiler/tex_writer.c
+ * Implementation of the buffered LaTeX writer (see tex_writer.h).
+ */
+
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "tex_writer.h"
+
+// What each byte of paper text becomes; NULL: copied unchanged.
+// Bytes >= 0x80 (UTF-8 sequences) are copied too.
+static const char* const escapes[256] = {
+    ['\\'] = "\\textbackslash{}",
+    ['{']  = "\\{",
+    ['}']  = "\\}",
+    ['$']  = "\\$",
+    ['&']  = "\\&",
+    ['#']  = "\\#",
+    ['_']  = "\\_",
+    ['%']  = "\\%",
+    ['~']  = "\\textasciitilde{}",
+    ['^']  = "\\textasciicircum{}",
+    ['<']  = "\\textless{}",   // The default font has no < > |
+    ['>']  = "\\textgreater{}",
+    ['|']  = "\\textbar{}",
+    // Control characters are not allowed in the input
+    [0x01] = " ", [0x02] = " ", [0x03] = " ", [0x04] = " ", [0x05] = " ", [0x06] = " ",
+    [0x07] = " ", [0x08] = " ", [0x0B] = " ", [0x0C] = " ", [0x0E] = " ", [0x0F] = " ",
+    [0x10] = " ", [0x11] = " ", [0x12] = " ", [0x13] = " ", [0x14] = " ", [0x15] = " ",
+    [0x16] = " ", [0x17] = " ", [0x18] = " ", [0x19] = " ", [0x1A] = " ", [0x1B] = " ",
+    [0x1C] = " ", [0x1D] = " ", [0x1E] = " ", [0x1F] = " ", [0x7F] = " ",
+};
+
+static void flush(TexWriter* w) {
+    if (w->length > 0 && w->out != NULL && fwrite(w->buf, 1, w->length, w->out) != w->length) {
+        w->failed = 1;
+    }
+    w->length = 0;
+}
+
+static void put(TexWriter* w, const char* s, size_t len) {
+    if (w->length + len > TEX_WRITER_BUFFER_SIZE) {
+        flush(w);
+        if (len > TEX_WRITER_BUFFER_SIZE) { // Too big to buffer
+            if (w->out != NULL && fwrite(s, 1, len, w->out) != len) w->failed = 1;
+            return;
+        }
+    }
+    memcpy(w->buf + w->length, s, len);
+    w->length += len;
+}
+
+/* --- Tex Writer Functions --- */
+
+int tex_writer_init(TexWriter* w) {
+    memset(w, 0, sizeof(*w));
+    w->buf = (char*)malloc(TEX_WRITER_BUFFER_SIZE);
+    return w->buf != NULL ? 0 : -1;
+}
+
+void tex_writer_free(TexWriter* w) {
+    if (w->out != NULL) tex_writer_end(w);
+    free(w->buf);
+    w->buf = NULL;
+}
+
+int tex_writer_begin(TexWriter* w, const char* path) {
+    unlink(path); // May be a link into the compile cache
+    w->out = fopen(path, "w");
+    w->length = 0;
+    w->failed = 0;
+    if (w->out == NULL) {
+        perror(path);
+        return -1;
+    }
+    setvbuf(w->out, NULL, _IONBF, 0); // Already buffered here
+    return 0;
+}
+
+int tex_writer_end(TexWriter* w) {
+    if (w->out == NULL) return -1;
+    flush(w);
+    if (fclose(w->out) != 0) w->failed = 1;
+    w->out = NULL;
+    if (w->failed) {
+        perror("Failed to write LaTeX document");
+        return -1;
+    }
+    return 0;
+}
+
+void tex_raw(TexWriter* w, const char* markup) {
+    put(w, markup, strlen(markup));
+}
+
+void tex_rawf(TexWriter* w, const char* format, ...) {
+    char line[512];
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+    if (n < 0) return;
+    put(w, line, (size_t)n < sizeof(line) ? (size_t)n : sizeof(line) - 1);
+}
+
+void tex_text(TexWriter* w, const char* text) {
+    tex_text_n(w, text, strlen(text));
+}
+
+// Copies runs of plain bytes in one go and looks up the rest
+void tex_text_n(TexWriter* w, const char* text, size_t len) {
+    const unsigned char* p = (const unsigned char*)text;
+    const unsigned char* end = p + len;
+    while (p < end) {
+        const unsigned char* run = p;
+        while (p < end && escapes[*p] == NULL) p++;
+        put(w, (const char*)run, (size_t)(p - run));
+        if (p == end) break;
+        tex_raw(w, escapes[*p]);
+        p++;
+    }
+}
@@ -0,0 +1,51 @@
+/*
+ * compiler/tex_writer.h
+ * Small buffered writer for the LaTeX the compiler emits.
+ *
+ * One writer (and one buffer) is reused for every document of a job:
+ *
+ *     tex_writer_init(&w);
+ *     tex_writer_begin(&w, "EnhancedPaper.tex");
+ *     tex_raw(&w, "\\section*{");  tex_text(&w, subject);  tex_raw(&w, "}\n");
+ *     tex_writer_end(&w);
+ *     tex_writer_begin(&w, "AnalysisReport.tex");  ...
+ *     tex_writer_free(&w);
+ *
+ * tex_raw() copies markup as it is; tex_text() escapes text from the
+ * paper, so a question may contain %, $, _, braces or backslashes.
+ */
+
+#ifndef TEX_WRITER_H
+#define TEX_WRITER_H
+
+#include <stdio.h>
+#include <stddef.h>
+
+#define TEX_WRITER_BUFFER_SIZE (64 * 1024)
+
+typedef struct TexWriter {
+    FILE* out;       // The document being written, or NULL between documents
+    char* buf;       // Pending output, flushed with one fwrite when full
+    size_t length;
+    int failed;      // A write to 'out' went wrong
+} TexWriter;
+
+/* --- Tex Writer Functions --- */
+
+// Allocates the buffer. Returns 0 on success, -1 if out of memory.
+int tex_writer_init(TexWriter* w);
+void tex_writer_free(TexWriter* w);
+
+// Creates 'path' and sends the output there. Returns 0 on success, -1 on error.
+int tex_writer_begin(TexWriter* w, const char* path);
+
+// Flushes and closes the document. Returns 0 if everything was written.
+int tex_writer_end(TexWriter* w);
+
+// --- Output ---
+void tex_raw(TexWriter* w, const char* markup);
+void tex_rawf(TexWriter* w, const char* format, ...);
+void tex_text(TexWriter* w, const char* text);
+void tex_text_n(TexWriter* w, const char* text, size_t len); // 'text' need not be NUL-terminated
+
+#endif // TEX_WRITER_H
@@ -0,0 +1,263 @@
+/*
+ * compiler/token_stream.c
+ * Writer and reader for the binary token stream (tokens.bin).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "token_stream.h"
+#include "token_writer.h"
+#include "source.h"
+
+// Indexed by TokenKind
+static const char* token_kind_names[TOK_KIND_COUNT] = {
+    "T_HEADER_START", "T_HEADER_END",
+    "T_QUESTION_LIST_START", "T_QUESTION_LIST_END",
+    "T_QUESTION_START", "T_QUESTION_END",
+    "T_SUBJECT", "T_TOTAL_MARKS", "T_TOTAL_TIME", "T_SYLLABUS_PATH",
+    "T_Q_TEXT", "T_Q_MARKS",
+    "T_STRING", "T_NUMBER", "T_COLON",
+    "T_ERROR_UNKNOWN"
+};
+
+const char* token_kind_name(int kind) {
+    if (kind < 0 || kind >= TOK_KIND_COUNT) return "T_INVALID";
+    return token_kind_names[kind];
+}
+
+/* --- Writer --- */
+
+static int write_all(int fd, const void* data, size_t n, off_t at) {
+    const char* p = (const char*)data;
+    while (n > 0) {
+        ssize_t w = at >= 0 ? pwrite(fd, p, n, at) : write(fd, p, n);
+        if (w < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        p += w;
+        n -= (size_t)w;
+        if (at >= 0) at += w;
+    }
+    return 0;
+}
+
+static void fill_header(TokenStreamHeader* h, uint32_t count, uint32_t source_length) {
+    memset(h, 0, sizeof(*h));
+    memcpy(h->magic, TOKEN_STREAM_MAGIC, 4);
+    h->version = TOKEN_STREAM_VERSION;
+    h->record_size = (uint16_t)sizeof(TokenRecord);
+    h->count = count;
+    h->source_length = source_length;
+}
+
+static void flush_records(TokenStreamWriter* w) {
+    if (w->pending == 0 || w->failed) {
+        w->pending = 0;
+        return;
+    }
+    if (write_all(w->fd, w->buf, w->pending * sizeof(TokenRecord), -1) != 0) {
+        perror("Failed to write tokens.bin");
+        w->failed = 1;
+    }
+    w->pending = 0;
+}
+
+int token_stream_writer_open(TokenStreamWriter* w, const char* path, size_t source_length) {
+    memset(w, 0, sizeof(*w));
+    w->fd = -1;
+    w->source_length = (uint32_t)source_length;
+
+    w->buf = (TokenRecord*)malloc(sizeof(TokenRecord) * TOKEN_STREAM_BUFFER_RECORDS);
+    if (w->buf == NULL) return -1;
+
+    unlink(path); // May be a link into the compile cache
+    w->fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (w->fd < 0) {
+        free(w->buf);
+        w->buf = NULL;
+        return -1;
+    }
+
+    // Placeholder header: the count is only known in token_stream_writer_close()
+    TokenStreamHeader header;
+    fill_header(&header, 0, w->source_length);
+    if (write_all(w->fd, &header, sizeof(header), -1) != 0) {
+        w->failed = 1;
+    }
+    return 0;
+}
+
+void token_stream_writer_add(TokenStreamWriter* w, TokenKind kind, uint32_t line,
+                             uint32_t offset, uint32_t length) {
+    if (w->fd < 0) return;
+    if (w->pending == TOKEN_STREAM_BUFFER_RECORDS) {
+        flush_records(w);
+    }
+    TokenRecord* r = &w->buf[w->pending++];
+    r->kind = (uint16_t)kind;
+    r->reserved = 0;
+    r->line = line;
+    r->offset = offset;
+    r->length = length;
+    w->count++;
+}
+
+int token_stream_writer_close(TokenStreamWriter* w) {
+    if (w->fd < 0) return -1;
+
+    flush_records(w);
+    if (!w->failed) {
+        TokenStreamHeader header;
+        fill_header(&header, w->count, w->source_length);
+        if (write_all(w->fd, &header, sizeof(header), 0) != 0) {
+            w->failed = 1;
+        }
+    }
+    int failed = w->failed;
+    if (close(w->fd) != 0) failed = 1;
+    free(w->buf);
+    w->buf = NULL;
+    w->fd = -1;
+    return failed ? -1 : 0;
+}
+
+/* --- In-Memory Token List --- */
+
+static int token_list_reserve(TokenList* list, size_t count) {
+    if (count <= list->capacity) return 0;
+    size_t capacity = list->capacity > 0 ? list->capacity : 1024;
+    while (capacity < count) capacity *= 2;
+    TokenRecord* grown = (TokenRecord*)realloc(list->tokens, sizeof(TokenRecord) * capacity);
+    if (grown == NULL) {
+        list->failed = 1;
+        return -1;
+    }
+    list->tokens = grown;
+    list->capacity = capacity;
+    return 0;
+}
+
+void token_list_add(TokenList* list, TokenKind kind, uint32_t line,
+                    uint32_t offset, uint32_t length) {
+    if (token_list_reserve(list, list->count + 1) != 0) return;
+    TokenRecord* t = &list->tokens[list->count++];
+    t->kind = (uint16_t)kind;
+    t->reserved = 0;
+    t->line = line;
+    t->offset = offset;
+    t->length = length;
+}
+
+void token_list_append(TokenList* list, const TokenList* from) {
+    if (from->failed) list->failed = 1;
+    if (from->count == 0 || token_list_reserve(list, list->count + from->count) != 0) return;
+    memcpy(list->tokens + list->count, from->tokens, sizeof(TokenRecord) * from->count);
+    list->count += from->count;
+}
+
+void token_list_free(TokenList* list) {
+    free(list->tokens);
+    memset(list, 0, sizeof(*list));
+}
+
+/* --- Reader --- */
+
+int token_stream_open(TokenStream* ts, const char* path) {
+    memset(ts, 0, sizeof(*ts));
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return -1;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(TokenStreamHeader)) {
+        close(fd);
+        errno = EINVAL;
+        return -1;
+    }
+    size_t size = (size_t)st.st_size;
+    void* map = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return -1;
+
+    const TokenStreamHeader* h = (const TokenStreamHeader*)map;
+    if (memcmp(h->magic, TOKEN_STREAM_MAGIC, 4) != 0 ||
+        h->version != TOKEN_STREAM_VERSION ||
+        h->record_size != sizeof(TokenRecord) ||
+        (size - sizeof(*h)) / sizeof(TokenRecord) < h->count) {
+        munmap(map, size);
+        errno = EINVAL;
+        return -1;
+    }
+
+    ts->header = h;
+    ts->records = (const TokenRecord*)((const char*)map + sizeof(*h));
+    ts->count = h->count;
+    ts->map = map;
+    ts->map_length = size;
+    return 0;
+}
+
+void token_stream_close(TokenStream* ts) {
+    if (ts->map != NULL) {
+        munmap(ts->map, ts->map_length);
+    }
+    memset(ts, 0, sizeof(*ts));
+}
+
+const TokenRecord* token_stream_get(const TokenStream* ts, uint32_t index) {
+    if (index >= ts->count) return NULL;
+    return &ts->records[index];
+}
+
+int token_stream_export_json(const char* bin_path, const char* source_path,
+                             const char* json_path) {
+    TokenStream ts;
+    if (token_stream_open(&ts, bin_path) != 0) {
+        fprintf(stderr, "Error: Cannot read token stream %s\n", bin_path);
+        return -1;
+    }
+
+    SourceBuffer src;
+    if (source_open(&src, source_path, 1) != 0) {
+        fprintf(stderr, "Error: Cannot open source %s\n", source_path);
+        token_stream_close(&ts);
+        return -1;
+    }
+    if (src.length != ts.header->source_length) {
+        fprintf(stderr, "Error: %s does not match %s (was it edited?)\n", source_path, bin_path);
+        source_close(&src);
+        token_stream_close(&ts);
+        return -1;
+    }
+
+    TokenWriter json;
+    int rc = -1;
+    unlink(json_path); // Replaced rather than truncated: it may be a link into the compile cache
+    if (token_writer_open(&json, json_path) == 0) {
+        uint32_t i;
+        for (i = 0; i < ts.count; i++) {
+            const TokenRecord* r = &ts.records[i];
+            if ((size_t)r->offset + r->length > src.length) break; // Corrupt record
+            token_writer_add(&json, token_kind_name(r->kind),
+                             src.data + r->offset, r->length, (int)r->line);
+        }
+        rc = token_writer_close(&json);
+        if (i < ts.count) {
+            // Not a truncated tokens.json that looks complete
+            fprintf(stderr, "Error: Token %u of %s is outside %s\n", i, bin_path, source_path);
+            unlink(json_path);
+            rc = -1;
+        }
+    }
+
+    source_close(&src);
+    token_stream_close(&ts);
+    return rc;
+}
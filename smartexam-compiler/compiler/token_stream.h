@@ -0,0 +1,124 @@
+/*
+ * compiler/token_stream.h
+ * Compact binary token stream (tokens.bin) and a tiny reader for it.
+ *
+ * tokens.bin is a 16-byte header followed by one fixed-width 16-byte
+ * record per token. A record does not hold the token text, only where it
+ * is in input.qp, so the file is a fraction of the size of tokens.json
+ * and token N can be read directly at byte 16 + 16 * N.
+ *
+ * Integers are in the byte order of the machine that wrote the file
+ * (little-endian on x86 and ARM). On the other byte order the version
+ * and record_size read wrong, so token_stream_open() rejects the file.
+ */
+
+#ifndef TOKEN_STREAM_H
+#define TOKEN_STREAM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define TOKEN_STREAM_MAGIC   "QTOK"
+#define TOKEN_STREAM_VERSION 1
+
+// Stable token ids stored in tokens.bin (never renumber these)
+typedef enum TokenKind {
+    TOK_HEADER_START = 0,
+    TOK_HEADER_END,
+    TOK_QUESTION_LIST_START,
+    TOK_QUESTION_LIST_END,
+    TOK_QUESTION_START,
+    TOK_QUESTION_END,
+    TOK_SUBJECT,
+    TOK_TOTAL_MARKS,
+    TOK_TOTAL_TIME,
+    TOK_SYLLABUS_PATH,
+    TOK_Q_TEXT,
+    TOK_Q_MARKS,
+    TOK_STRING,
+    TOK_NUMBER,
+    TOK_COLON,
+    TOK_ERROR_UNKNOWN,
+    TOK_KIND_COUNT
+} TokenKind;
+
+typedef struct TokenStreamHeader {
+    char magic[4];          // "QTOK"
+    uint16_t version;       // TOKEN_STREAM_VERSION
+    uint16_t record_size;   // sizeof(TokenRecord)
+    uint32_t count;         // Number of records that follow
+    uint32_t source_length; // Size of the input.qp the offsets refer to
+} TokenStreamHeader;
+
+typedef struct TokenRecord {
+    uint16_t kind;          // A TokenKind
+    uint16_t reserved;      // Always 0
+    uint32_t line;          // Line number, as in tokens.json
+    uint32_t offset;        // Byte offset of the token value in input.qp
+    uint32_t length;        // Byte length of the value
+} TokenRecord;
+
+// "T_HEADER_START" etc. (the names used in tokens.json)
+const char* token_kind_name(int kind);
+
+/* --- Writer (used by the lexer) --- */
+
+#define TOKEN_STREAM_BUFFER_RECORDS 8192
+
+typedef struct TokenStreamWriter {
+    int fd;
+    int failed;
+    uint32_t count;        // Records written so far
+    uint32_t source_length;
+    size_t pending;        // Records waiting in 'buf'
+    TokenRecord* buf;
+} TokenStreamWriter;
+
+int token_stream_writer_open(TokenStreamWriter* w, const char* path, size_t source_length);
+void token_stream_writer_add(TokenStreamWriter* w, TokenKind kind, uint32_t line,
+                             uint32_t offset, uint32_t length);
+// Flushes the records and fills in the final count. Returns 0 on success.
+int token_stream_writer_close(TokenStreamWriter* w);
+
+/* --- In-Memory Token List --- */
+
+// Tokens kept in memory, in source order (incremental.c and parallel.c
+// collect the lexer's tokens here before they are logged)
+typedef struct TokenList {
+    TokenRecord* tokens;
+    size_t count;
+    size_t capacity;
+    int failed;            // Out of memory: some tokens are missing
+} TokenList;
+
+void token_list_add(TokenList* list, TokenKind kind, uint32_t line,
+                    uint32_t offset, uint32_t length);
+// Appends every token of 'from'
+void token_list_append(TokenList* list, const TokenList* from);
+void token_list_free(TokenList* list);
+
+/* --- Reader --- */
+
+typedef struct TokenStream {
+    const TokenStreamHeader* header;
+    const TokenRecord* records;
+    uint32_t count;
+    void* map;             // The mmap'd file
+    size_t map_length;
+} TokenStream;
+
+// Maps tokens.bin and checks its header. Returns 0 on success, -1 on error.
+int token_stream_open(TokenStream* ts, const char* path);
+void token_stream_close(TokenStream* ts);
+
+// Record 'index' (0-based), or NULL if out of range. The pointer stays
+// valid until token_stream_close().
+const TokenRecord* token_stream_get(const TokenStream* ts, uint32_t index);
+
+// Rebuilds the equivalent tokens.json from tokens.bin and input.qp.
+// Returns 0 on success, -1 on error. A record outside input.qp is an
+// error too, and then no tokens.json is left behind.
+int token_stream_export_json(const char* bin_path, const char* source_path,
+                             const char* json_path);
+
+#endif // TOKEN_STREAM_H
@@ -0,0 +1,194 @@
+/*
+ * compiler/token_writer.c
+ * Buffered JSON writer for tokens.json.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "token_writer.h"
+
+/*
+ * JSON escape table, indexed by byte value:
+ *   0    -> copy the byte as is
+ *   'u'  -> write it as \u00XX
+ *   else -> write a backslash followed by this character
+ * Bytes >= 0x80 (UTF-8 sequences) are copied unchanged.
+ */
+static const char escape_table[256] = {
+    'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'b', 't', 'n', 'u', 'f', 'r', 'u', 'u',
+    'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u',
+    0, 0, '"', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, '\\', 0, 0, 0,
+    // Everything from 0x60 up is copied as is (the rest of the table is 0)
+};
+
+static const char hex_digits[] = "0123456789abcdef";
+
+/* --- Buffer Helpers --- */
+
+// Writes out the whole buffer, retrying on short writes
+static void flush_buffer(TokenWriter* w) {
+    if (w->stream != NULL) {
+        if (!w->failed && fwrite(w->buf, 1, w->len, w->stream) != w->len) w->failed = 1;
+        w->len = 0;
+        return;
+    }
+    size_t done = 0;
+    while (done < w->len && !w->failed) {
+        ssize_t n = write(w->fd, w->buf + done, w->len - done);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            perror("Failed to write tokens.json");
+            w->failed = 1;
+            break;
+        }
+        done += (size_t)n;
+    }
+    w->len = 0;
+}
+
+// Makes sure at least 'n' bytes are free ('n' must be <= the buffer size)
+static inline void reserve(TokenWriter* w, size_t n) {
+    if (w->len + n > TOKEN_WRITER_BUFFER_SIZE) {
+        flush_buffer(w);
+    }
+}
+
+static void append(TokenWriter* w, const char* data, size_t n) {
+    while (n > 0) {
+        size_t room = TOKEN_WRITER_BUFFER_SIZE - w->len;
+        if (room == 0) {
+            flush_buffer(w);
+            room = TOKEN_WRITER_BUFFER_SIZE;
+        }
+        size_t chunk = n < room ? n : room;
+        memcpy(w->buf + w->len, data, chunk);
+        w->len += chunk;
+        data += chunk;
+        n -= chunk;
+    }
+}
+
+// Copies runs of plain bytes with memcpy and escapes the rest
+static void append_escaped(TokenWriter* w, const char* value, size_t value_len) {
+    const unsigned char* p = (const unsigned char*)value;
+    const unsigned char* end = p + value_len;
+
+    while (p < end) {
+        const unsigned char* run = p;
+        while (p < end && escape_table[*p] == 0) {
+            p++;
+        }
+        append(w, (const char*)run, (size_t)(p - run));
+        if (p == end) break;
+
+        char esc = escape_table[*p];
+        reserve(w, 6);
+        w->buf[w->len++] = '\\';
+        if (esc == 'u') {
+            w->buf[w->len++] = 'u';
+            w->buf[w->len++] = '0';
+            w->buf[w->len++] = '0';
+            w->buf[w->len++] = hex_digits[*p >> 4];
+            w->buf[w->len++] = hex_digits[*p & 0xF];
+        } else {
+            w->buf[w->len++] = esc;
+        }
+        p++;
+    }
+}
+
+static void append_int(TokenWriter* w, int value) {
+    char digits[16];
+    int n = 0;
+    unsigned int v = value < 0 ? 0u - (unsigned int)value : (unsigned int)value;
+    do {
+        digits[n++] = (char)('0' + v % 10);
+        v /= 10;
+    } while (v > 0);
+    if (value < 0) digits[n++] = '-';
+
+    reserve(w, (size_t)n);
+    while (n > 0) {
+        w->buf[w->len++] = digits[--n];
+    }
+}
+
+#define APPEND_LITERAL(w, s) append((w), (s), sizeof(s) - 1)
+
+/* --- Token Writer Functions --- */
+
+int token_writer_open_fd(TokenWriter* w, int fd, int owns_fd) {
+    memset(w, 0, sizeof(*w));
+    w->fd = fd;
+    w->owns_fd = owns_fd;
+    w->buf = (char*)malloc(TOKEN_WRITER_BUFFER_SIZE);
+    if (w->buf == NULL) {
+        if (owns_fd) close(fd);
+        w->fd = -1;
+        return -1;
+    }
+    APPEND_LITERAL(w, "["); // Start JSON array
+    return 0;
+}
+
+int token_writer_open_stream(TokenWriter* w, FILE* stream) {
+    if (token_writer_open_fd(w, -1, 0) != 0) return -1;
+    w->stream = stream;
+    return 0;
+}
+
+int token_writer_open(TokenWriter* w, const char* path) {
+    unlink(path); // A new file: the old one may be shared with the compile cache
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        memset(w, 0, sizeof(*w));
+        w->fd = -1;
+        return -1;
+    }
+    return token_writer_open_fd(w, fd, 1);
+}
+
+void token_writer_add(TokenWriter* w, const char* token_name,
+                      const char* value, size_t value_len, int line) {
+    if (w->buf == NULL) return;
+
+    // The separator goes before every token but the first,
+    // so there is never a trailing comma to patch up later
+    if (w->count > 0) {
+        APPEND_LITERAL(w, ",\n  {\"token\": \"");
+    } else {
+        APPEND_LITERAL(w, "\n  {\"token\": \"");
+    }
+    append(w, token_name, strlen(token_name));
+    APPEND_LITERAL(w, "\", \"value\": \"");
+    append_escaped(w, value, value_len);
+    APPEND_LITERAL(w, "\", \"line\": ");
+    append_int(w, line);
+    APPEND_LITERAL(w, "}");
+    w->count++;
+}
+
+int token_writer_close(TokenWriter* w) {
+    if (w->buf == NULL) return -1;
+
+    APPEND_LITERAL(w, "\n]\n"); // End JSON array
+    flush_buffer(w);
+    int failed = w->failed;
+    if (w->stream != NULL && fflush(w->stream) != 0) {
+        failed = 1;
+    } else if (w->owns_fd && close(w->fd) != 0) {
+        failed = 1;
+    }
+    free(w->buf);
+    w->buf = NULL;
+    w->stream = NULL;
+    w->fd = -1;
+    return failed ? -1 : 0;
+}
@@ -0,0 +1,49 @@
+/*
+ * compiler/token_writer.h
+ * Streaming writer for tokens.json (the Phase 1 token log).
+ *
+ * Tokens are appended to a large in-memory buffer and written out in big
+ * blocks with write(). The writer places the JSON separators itself, so
+ * it never has to seek back and works on pipes as well as files.
+ */
+
+#ifndef TOKEN_WRITER_H
+#define TOKEN_WRITER_H
+
+#include <stdio.h>
+#include <stddef.h>
+
+#define TOKEN_WRITER_BUFFER_SIZE (256 * 1024)
+
+typedef struct TokenWriter {
+    int fd;          // Output file descriptor, -1 when closed
+    int owns_fd;     // Close 'fd' in token_writer_close()?
+    FILE* stream;    // Written instead of 'fd' when set (not closed by us)
+    int failed;      // Set once a write() fails; later output is dropped
+    long count;      // Tokens written so far
+    size_t len;      // Bytes currently in 'buf'
+    char* buf;       // TOKEN_WRITER_BUFFER_SIZE bytes
+} TokenWriter;
+
+/* --- Token Writer Functions --- */
+
+// Creates 'path' and starts the JSON array. Returns 0 on success, -1 on error.
+int token_writer_open(TokenWriter* w, const char* path);
+
+// Same, but writes to an already open descriptor (e.g. a pipe)
+int token_writer_open_fd(TokenWriter* w, int fd, int owns_fd);
+
+// Same, but writes to a stdio stream. token_writer_close() only flushes
+// it; the caller closes it. libqverifier uses this to build tokens.json
+// in memory.
+int token_writer_open_stream(TokenWriter* w, FILE* stream);
+
+// Appends one {"token", "value", "line"} object. 'value' need not be
+// NUL-terminated: exactly 'value_len' bytes are escaped and written.
+void token_writer_add(TokenWriter* w, const char* token_name,
+                      const char* value, size_t value_len, int line);
+
+// Ends the array, flushes and closes. Returns 0 if everything was written.
+int token_writer_close(TokenWriter* w);
+
+#endif // TOKEN_WRITER_H
@@ -0,0 +1,105 @@
+/*
+ * compiler/topics.c
+ * Interned topic names (see topics.h).
+ */
+
+#include <string.h>
+#include "topics.h"
+
+#define TOPIC_FIRST_CAPACITY 16
+
+// FNV-1a: short, fast and good enough for a few hundred topic names
+static unsigned int hash_name(const char* name, size_t len) {
+    unsigned int h = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        h ^= (unsigned char)name[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static int name_equals(const char* stored, const char* name, size_t len) {
+    return strncmp(stored, name, len) == 0 && stored[len] == '\0';
+}
+
+// Finds the slot holding 'name', or the empty slot where it would go
+static int find_slot(const TopicTable* table, const char* name, size_t len) {
+    unsigned int mask = (unsigned int)table->slot_count - 1;
+    unsigned int i = hash_name(name, len) & mask;
+    while (table->slots[i] != 0) {
+        if (name_equals(table->names[table->slots[i] - 1], name, len)) break;
+        i = (i + 1) & mask;
+    }
+    return (int)i;
+}
+
+// Doubles 'names' and the hash table. The old arrays stay in the arena
+// (they are small and everything is released together).
+static int grow(TopicTable* table) {
+    int capacity = table->capacity * 2;
+    const char** names = (const char**)arena_alloc(table->arena, sizeof(char*) * capacity);
+    int slot_count = capacity * 2; // Keep the load factor at or below 1/2
+    int* slots = (int*)arena_alloc(table->arena, sizeof(int) * slot_count);
+    if (names == NULL || slots == NULL) return -1;
+
+    if (table->count > 0) {
+        memcpy(names, table->names, sizeof(char*) * table->count);
+    }
+    memset(slots, 0, sizeof(int) * slot_count);
+    table->names = names;
+    table->capacity = capacity;
+    table->slots = slots;
+    table->slot_count = slot_count;
+
+    for (int id = 0; id < table->count; id++) {
+        const char* name = table->names[id];
+        table->slots[find_slot(table, name, strlen(name))] = id + 1;
+    }
+    return 0;
+}
+
+/* --- Topic Table Functions --- */
+
+void topic_table_init(TopicTable* table, Arena* arena) {
+    table->arena = arena;
+    table->count = 0;
+    table->capacity = TOPIC_FIRST_CAPACITY / 2;
+    table->names = NULL;
+    table->slots = NULL;
+    table->slot_count = 0;
+    grow(table); // Allocates the first arrays
+
+    topic_intern(table, "N/A", 3); // Always id 0 (TOPIC_NONE)
+}
+
+int topic_intern(TopicTable* table, const char* name, size_t len) {
+    if (table->names == NULL) return TOPIC_NONE;
+
+    int slot = find_slot(table, name, len);
+    if (table->slots[slot] != 0) {
+        return table->slots[slot] - 1; // Already interned
+    }
+
+    if (table->count == table->capacity) {
+        if (grow(table) != 0) return TOPIC_NONE;
+        slot = find_slot(table, name, len);
+    }
+    char* copy = arena_strndup(table->arena, name, len);
+    if (copy == NULL) return TOPIC_NONE;
+
+    int id = table->count++;
+    table->names[id] = copy;
+    table->slots[slot] = id + 1;
+    return id;
+}
+
+int topic_lookup(const TopicTable* table, const char* name, size_t len) {
+    if (table->names == NULL) return -1;
+    int slot = find_slot(table, name, len);
+    return table->slots[slot] - 1;
+}
+
+const char* topic_name(const TopicTable* table, int id) {
+    if (id < 0 || id >= table->count) return "N/A";
+    return table->names[id];
+}
@@ -0,0 +1,43 @@
+/*
+ * compiler/topics.h
+ * Per-paper table of syllabus topic names.
+ *
+ * Each distinct topic name is stored once and given a small integer id;
+ * questions keep only the id. Comparing or counting topics is then an
+ * integer operation, and topic id 0 always means "no topic" ("N/A").
+ */
+
+#ifndef TOPICS_H
+#define TOPICS_H
+
+#include <stddef.h>
+#include "arena.h"
+
+#define TOPIC_NONE 0 // Id of the "N/A" topic
+
+typedef struct TopicTable {
+    Arena* arena;       // Names and tables are allocated from here
+    const char** names; // names[id]
+    int count;          // Number of topics, including TOPIC_NONE
+    int capacity;       // Size of 'names'
+    int* slots;         // Open-addressing hash: id + 1, or 0 if empty
+    int slot_count;     // Always a power of two
+} TopicTable;
+
+/* --- Topic Table Functions --- */
+
+// Sets up a table holding just TOPIC_NONE. Memory comes from 'arena',
+// so the table is released together with the AST.
+void topic_table_init(TopicTable* table, Arena* arena);
+
+// Returns the id for 'name' (the first 'len' bytes), adding it if new.
+// Returns TOPIC_NONE if memory runs out.
+int topic_intern(TopicTable* table, const char* name, size_t len);
+
+// Returns the id for 'name' without adding it, or -1 if unknown
+int topic_lookup(const TopicTable* table, const char* name, size_t len);
+
+// Returns the name for 'id' ("N/A" for TOPIC_NONE or a bad id)
+const char* topic_name(const TopicTable* table, int id);
+
+#endif // TOPICS_H